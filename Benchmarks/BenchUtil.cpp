@@ -0,0 +1,289 @@
+#include "BenchUtil.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <sstream>
+
+namespace
+{
+    uint64_t allocations = 0;
+
+    const double ZIPF_EXPONENT = 0.99;
+}
+
+// Allocation counting ---------------------------------------------------------------
+
+void *operator new(std::size_t size)
+{
+    allocations++;
+    void *memory = std::malloc(size > 0 ? size : 1);
+    if (memory == nullptr)
+        throw std::bad_alloc();
+    return memory;
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+uint64_t allocationCount()
+{
+    return allocations;
+}
+
+// Distributions ---------------------------------------------------------------
+
+const char *distributionName(Distribution distribution)
+{
+    switch (distribution)
+    {
+        case Distribution::UNIFORM:
+            return "uniform";
+        case Distribution::ZIPF:
+            return "zipf";
+        default:
+            return "adversarial";
+    }
+}
+
+bool distributionFromName(const std::string &name, Distribution &distribution)
+{
+    const Distribution ALL[] = {Distribution::UNIFORM, Distribution::ZIPF, Distribution::ADVERSARIAL};
+    for (Distribution candidate : ALL)
+    {
+        if (name == distributionName(candidate))
+        {
+            distribution = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+IdSource::IdSource(Distribution distribution, int count, uint32_t seed) :
+    distribution(distribution), ids(count), random(seed)
+{
+    if (distribution == Distribution::ADVERSARIAL)
+    {
+        // ascending keys rotate the trees on every insert, and a power of two stride puts them
+        // in a few buckets of a power of two sized table. Past 2^21 keys the stride would overflow,
+        // so the multiple wraps around and the wrap count fills the low bits (keeping ids distinct)
+        const int64_t WRAP = (int64_t) 1 << 21;
+        for (int i = 0; i < count; ++i)
+        {
+            int64_t k = i + 1;
+            ids[i] = (int) ((k % WRAP) * ADVERSARIAL_STRIDE + k / WRAP);
+        }
+        return;
+    }
+
+    for (int i = 0; i < count; ++i)
+        ids[i] = i + 1;
+    std::shuffle(ids.begin(), ids.end(), random);
+
+    if (distribution == Distribution::ZIPF)
+    {
+        zipfCdf.resize(count);
+        double sum = 0;
+        for (int i = 0; i < count; ++i)
+        {
+            sum += 1.0 / std::pow(i + 1, ZIPF_EXPONENT);
+            zipfCdf[i] = sum;
+        }
+        for (int i = 0; i < count; ++i)
+            zipfCdf[i] /= sum;
+    }
+}
+
+const std::vector<int> &IdSource::getIds() const
+{
+    return ids;
+}
+
+int IdSource::pick(int live)
+{
+    if (live <= 0)
+        return 0;
+    switch (distribution)
+    {
+        case Distribution::ZIPF:
+        {
+            // rank among the live ids, hot ranks are the earliest inserted
+            double limit = zipfCdf[live - 1];
+            double target = std::uniform_real_distribution<double>(0, limit)(random);
+            return (int) (std::lower_bound(zipfCdf.begin(), zipfCdf.begin() + live, target) - zipfCdf.begin());
+        }
+        case Distribution::ADVERSARIAL:
+            // the deepest keys of the ascending insertion
+            return live - 1 - (int) (random() % std::min(live, 16));
+        default:
+            return (int) (random() % live);
+    }
+}
+
+std::mt19937 &IdSource::getRandom()
+{
+    return random;
+}
+
+// Latency ---------------------------------------------------------------
+
+LatencyRecorder::LatencyRecorder(size_t expected) : allocations(0), sorted(false)
+{
+    samples.reserve(expected);
+}
+
+size_t LatencyRecorder::getCount() const
+{
+    return samples.size();
+}
+
+double LatencyRecorder::getMean() const
+{
+    if (samples.empty())
+        return 0;
+    double sum = 0;
+    for (uint64_t sample : samples)
+        sum += (double) sample;
+    return sum / (double) samples.size();
+}
+
+double LatencyRecorder::getAllocationsPerOp() const
+{
+    if (samples.empty())
+        return 0;
+    return (double) allocations / (double) samples.size();
+}
+
+uint64_t LatencyRecorder::percentile(double fraction)
+{
+    if (samples.empty())
+        return 0;
+    if (!sorted)
+    {
+        std::sort(samples.begin(), samples.end());
+        sorted = true;
+    }
+    size_t index = (size_t) (fraction * (double) (samples.size() - 1));
+    return samples[index];
+}
+
+// Options and output ---------------------------------------------------------------
+
+namespace
+{
+    std::vector<std::string> splitList(const char *text)
+    {
+        std::vector<std::string> items;
+        std::stringstream stream(text);
+        std::string item;
+        while (std::getline(stream, item, ','))
+        {
+            if (!item.empty())
+                items.push_back(item);
+        }
+        return items;
+    }
+
+    void printUsage(const char *program)
+    {
+        std::cerr << "usage: " << program << " [--sizes 1000,10000,...] [--dist uniform,zipf,adversarial]"
+                  << " [--ops <n>] [--csv]" << std::endl;
+    }
+}
+
+bool parseBenchOptions(int argc, char **argv, BenchOptions &options)
+{
+    options.sizes = {1000, 10000, 100000};
+    options.distributions = {Distribution::UNIFORM, Distribution::ZIPF, Distribution::ADVERSARIAL};
+    options.maxOps = 100000;
+    options.csv = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--sizes") == 0 && i + 1 < argc)
+        {
+            options.sizes.clear();
+            for (const std::string &item : splitList(argv[++i]))
+            {
+                int size = std::atoi(item.c_str());
+                if (size < 16 || size > 10000000)
+                {
+                    std::cerr << "sizes are between 16 and 10^7" << std::endl;
+                    return false;
+                }
+                options.sizes.push_back(size);
+            }
+        }
+        else if (std::strcmp(argv[i], "--dist") == 0 && i + 1 < argc)
+        {
+            options.distributions.clear();
+            for (const std::string &item : splitList(argv[++i]))
+            {
+                Distribution distribution;
+                if (!distributionFromName(item, distribution))
+                {
+                    printUsage(argv[0]);
+                    return false;
+                }
+                options.distributions.push_back(distribution);
+            }
+        }
+        else if (std::strcmp(argv[i], "--ops") == 0 && i + 1 < argc)
+            options.maxOps = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--csv") == 0)
+            options.csv = true;
+        else
+        {
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+    return !options.sizes.empty() && !options.distributions.empty();
+}
+
+void printHeader(const BenchOptions &options)
+{
+    if (options.csv)
+        std::printf("operation,size,distribution,calls,ns_per_op,p50_ns,p99_ns,allocs_per_op\n");
+    else
+        std::printf("%-28s %9s %-12s %9s %10s %9s %9s %8s\n",
+                    "operation", "size", "dist", "calls", "ns/op", "p50", "p99", "allocs");
+}
+
+void printResult(const BenchOptions &options, const char *operation, int size, Distribution distribution,
+                 LatencyRecorder &recorder)
+{
+    const char *format = options.csv ? "%s,%d,%s,%zu,%.1f,%llu,%llu,%.2f\n"
+                                     : "%-28s %9d %-12s %9zu %10.1f %9llu %9llu %8.2f\n";
+    std::printf(format, operation, size, distributionName(distribution), recorder.getCount(),
+                recorder.getMean(), (unsigned long long) recorder.percentile(0.5),
+                (unsigned long long) recorder.percentile(0.99), recorder.getAllocationsPerOp());
+    std::fflush(stdout);
+}
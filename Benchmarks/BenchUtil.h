@@ -0,0 +1,112 @@
+#ifndef BENCHMARKS_BENCH_UTIL_H_
+#define BENCHMARKS_BENCH_UTIL_H_
+
+/*
+ * Shared pieces of the Wet1 and Wet2 benchmarks: id distributions, per-operation latency
+ * recording and allocation counting (global operator new is replaced in BenchUtil.cpp).
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+// Allocations since program start, counted by the replaced operator new
+uint64_t allocationCount();
+
+enum class Distribution
+{
+    UNIFORM,        // ids and accesses spread uniformly
+    ZIPF,           // accesses concentrated on a few hot ids (s = 0.99)
+    ADVERSARIAL     // ids inserted in ascending order, all multiples of a power of two
+};
+
+const char *distributionName(Distribution distribution);
+bool distributionFromName(const std::string &name, Distribution &distribution);
+
+/*
+ * Generates the ids a benchmark inserts, and picks existing ids to operate on.
+ */
+class IdSource
+{
+public:
+    IdSource(Distribution distribution, int count, uint32_t seed);
+
+    // the ids in insertion order
+    const std::vector<int> &getIds() const;
+
+    /**
+     * Picks the index of an id to operate on, among the first `live` inserted ids.
+     * @param live - number of ids currently in use (at most the count the source was built with)
+     * @return
+     */
+    int pick(int live);
+
+    std::mt19937 &getRandom();
+
+private:
+    Distribution distribution;
+    std::vector<int> ids;
+    std::vector<double> zipfCdf;
+    std::mt19937 random;
+
+    static const int ADVERSARIAL_STRIDE = 1024;
+};
+
+/*
+ * Per-operation latencies of one measured operation.
+ */
+class LatencyRecorder
+{
+public:
+    explicit LatencyRecorder(size_t expected = 0);
+
+    template<class Operation>
+    void measure(Operation operation)
+    {
+        uint64_t allocationsBefore = allocationCount();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        operation();
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        allocations += allocationCount() - allocationsBefore;
+        samples.push_back((uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    }
+
+    size_t getCount() const;
+    double getMean() const;
+    double getAllocationsPerOp() const;
+
+    /**
+     * Returns the latency at the given fraction (0.5 - median) of the sorted samples.
+     */
+    uint64_t percentile(double fraction);
+
+private:
+    std::vector<uint64_t> samples;
+    uint64_t allocations;
+    bool sorted;
+};
+
+/*
+ * Command line shared by the benchmarks:
+ *   --sizes 1000,10000,100000   element counts (up to 10^7)
+ *   --dist uniform,zipf,adversarial
+ *   --ops <n>                   cap on measured calls per operation (default 100000)
+ *   --csv                       comma separated output
+ */
+struct BenchOptions
+{
+    std::vector<int> sizes;
+    std::vector<Distribution> distributions;
+    int maxOps;
+    bool csv;
+};
+
+bool parseBenchOptions(int argc, char **argv, BenchOptions &options);
+
+void printHeader(const BenchOptions &options);
+void printResult(const BenchOptions &options, const char *operation, int size, Distribution distribution,
+                 LatencyRecorder &recorder);
+
+#endif //BENCHMARKS_BENCH_UTIL_H_
@@ -0,0 +1,204 @@
+//
+// Wet1 benchmark - drives every world_cup_t operation at the requested sizes and id distributions.
+//
+// usage: bench23a1 [--sizes 1000,10000,...] [--dist uniform,zipf,adversarial] [--ops <n>] [--csv]
+//
+
+#include "worldcup23a1.h"
+#include "BenchUtil.h"
+
+#include <algorithm>
+
+namespace
+{
+    // calls of an operation that costs `cost` elementary steps, keeping every row to a few seconds
+    int callsFor(const BenchOptions &options, long cost)
+    {
+        long calls = 50000000L / std::max(1L, cost);
+        return (int) std::max(10L, std::min((long) options.maxOps, calls));
+    }
+
+    void run(const BenchOptions &options, int size, Distribution distribution)
+    {
+        // about 12 players per team, so most teams are legal and take part in knockouts
+        int teamCount = std::max(16, size / 12);
+        IdSource players(distribution, size, 7);
+        IdSource teams(distribution, teamCount, 11);
+        const std::vector<int> &playerIds = players.getIds();
+        const std::vector<int> &teamIds = teams.getIds();
+        std::mt19937 &random = players.getRandom();
+        std::vector<int> playerTeam(size);
+        int calls = callsFor(options, 1);
+        int minTeamId = *std::min_element(teamIds.begin(), teamIds.end());
+        int maxTeamId = *std::max_element(teamIds.begin(), teamIds.end());
+
+        world_cup_t *world = new world_cup_t();
+
+        LatencyRecorder addTeam(teamCount);
+        for (int i = 0; i < teamCount; ++i)
+            addTeam.measure([&]() { world->add_team(teamIds[i], (int) (random() % 10)); });
+        printResult(options, "add_team", size, distribution, addTeam);
+
+        LatencyRecorder addPlayer(size);
+        for (int i = 0; i < size; ++i)
+        {
+            // the adversarial distribution gives everyone the same stats, so only ids break ties
+            bool flat = distribution == Distribution::ADVERSARIAL;
+            playerTeam[i] = teamIds[(distribution == Distribution::ZIPF) ? teams.pick(teamCount) : i % teamCount];
+            int gamesPlayed = 1 + (int) (random() % 10);
+            int goals = flat ? 1 : (int) (random() % 30);
+            int cards = flat ? 1 : (int) (random() % 5);
+            bool goalKeeper = (i / teamCount) == 0 || random() % 8 == 0;
+            addPlayer.measure([&]() {
+                world->add_player(playerIds[i], playerTeam[i], gamesPlayed, goals, cards, goalKeeper);
+            });
+        }
+        printResult(options, "add_player", size, distribution, addPlayer);
+
+        LatencyRecorder updateStats(calls);
+        for (int i = 0; i < calls; ++i)
+        {
+            int playerId = playerIds[players.pick(size)];
+            int goals = (distribution == Distribution::ADVERSARIAL) ? 0 : (int) (random() % 3);
+            updateStats.measure([&]() { world->update_player_stats(playerId, 1, goals, 0); });
+        }
+        printResult(options, "update_player_stats", size, distribution, updateStats);
+
+        LatencyRecorder playMatch(calls);
+        for (int i = 0; i < calls; ++i)
+        {
+            int teamId1 = teamIds[teams.pick(teamCount)];
+            int teamId2 = teamIds[teams.pick(teamCount)];
+            playMatch.measure([&]() { world->play_match(teamId1, teamId2); });
+        }
+        printResult(options, "play_match", size, distribution, playMatch);
+
+        LatencyRecorder playedGames(calls);
+        for (int i = 0; i < calls; ++i)
+        {
+            int playerId = playerIds[players.pick(size)];
+            playedGames.measure([&]() { world->get_num_played_games(playerId); });
+        }
+        printResult(options, "get_num_played_games", size, distribution, playedGames);
+
+        LatencyRecorder teamPoints(calls);
+        for (int i = 0; i < calls; ++i)
+        {
+            int teamId = teamIds[teams.pick(teamCount)];
+            teamPoints.measure([&]() { world->get_team_points(teamId); });
+        }
+        printResult(options, "get_team_points", size, distribution, teamPoints);
+
+        LatencyRecorder topScorer(calls);
+        for (int i = 0; i < calls; ++i)
+        {
+            int teamId = (i % 2 == 0) ? -1 : teamIds[teams.pick(teamCount)];
+            topScorer.measure([&]() { world->get_top_scorer(teamId); });
+        }
+        printResult(options, "get_top_scorer", size, distribution, topScorer);
+
+        LatencyRecorder playersCount(calls);
+        for (int i = 0; i < calls; ++i)
+        {
+            int teamId = (i % 2 == 0) ? -1 : teamIds[teams.pick(teamCount)];
+            playersCount.measure([&]() { world->get_all_players_count(teamId); });
+        }
+        printResult(options, "get_all_players_count", size, distribution, playersCount);
+
+        std::vector<int> output(size);
+        int allCalls = callsFor(options, size);
+        LatencyRecorder allPlayers(allCalls);
+        for (int i = 0; i < allCalls; ++i)
+            allPlayers.measure([&]() { world->get_all_players(-1, output.data()); });
+        printResult(options, "get_all_players(all)", size, distribution, allPlayers);
+
+        LatencyRecorder page(calls);
+        for (int i = 0; i < calls; ++i)
+        {
+            int index = players.pick(size);
+            page.measure([&]() { world->getPlayersPage(playerIds[index], 100, output.data()); });
+        }
+        printResult(options, "getPlayersPage(100)", size, distribution, page);
+
+        LatencyRecorder teamPlayers(calls);
+        for (int i = 0; i < calls; ++i)
+        {
+            int teamId = teamIds[teams.pick(teamCount)];
+            teamPlayers.measure([&]() { world->get_all_players(teamId, output.data()); });
+        }
+        printResult(options, "get_all_players(team)", size, distribution, teamPlayers);
+
+        LatencyRecorder closest(calls);
+        for (int i = 0; i < calls; ++i)
+        {
+            int index = players.pick(size);
+            closest.measure([&]() { world->get_closest_player(playerIds[index], playerTeam[index]); });
+        }
+        printResult(options, "get_closest_player", size, distribution, closest);
+
+        int knockoutCalls = callsFor(options, teamCount);
+        LatencyRecorder knockout(knockoutCalls);
+        for (int i = 0; i < knockoutCalls; ++i)
+            knockout.measure([&]() { world->knockout_winner(minTeamId, maxTeamId); });
+        printResult(options, "knockout_winner(all)", size, distribution, knockout);
+
+        LatencyRecorder knockoutRange(calls);
+        for (int i = 0; i < calls; ++i)
+        {
+            // ranges of about 16 teams around a picked one
+            int low = teamIds[teams.pick(teamCount)];
+            int high = low + (maxTeamId - minTeamId) / std::max(1, teamCount / 16);
+            knockoutRange.measure([&]() { world->knockout_winner(low, high); });
+        }
+        printResult(options, "knockout_winner(range)", size, distribution, knockoutRange);
+
+        // each team is merged at most once, into the first of its pair
+        int unites = std::min(callsFor(options, 2L * size / teamCount), teamCount / 4);
+        LatencyRecorder unite(unites);
+        for (int i = 0; i < unites; ++i)
+        {
+            int teamId1 = teamIds[2 * i];
+            int teamId2 = teamIds[2 * i + 1];
+            unite.measure([&]() { world->unite_teams(teamId1, teamId2, teamId1); });
+        }
+        printResult(options, "unite_teams", size, distribution, unite);
+
+        int removals = std::min(calls, size / 2);
+        LatencyRecorder removePlayer(removals);
+        for (int i = 0; i < removals; ++i)
+        {
+            int playerId = playerIds[size - 1 - i];
+            removePlayer.measure([&]() { world->remove_player(playerId); });
+        }
+        printResult(options, "remove_player", size, distribution, removePlayer);
+
+        // only teams without players are removed, the rest fail fast
+        int teamRemovals = std::min(calls, teamCount / 2);
+        LatencyRecorder removeTeam(teamRemovals);
+        for (int i = 0; i < teamRemovals; ++i)
+        {
+            int teamId = teamIds[teamCount - 1 - i];
+            removeTeam.measure([&]() { world->remove_team(teamId); });
+        }
+        printResult(options, "remove_team", size, distribution, removeTeam);
+
+        LatencyRecorder teardown(1);
+        teardown.measure([&]() { delete world; });
+        printResult(options, "~world_cup_t", size, distribution, teardown);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions options;
+    if (!parseBenchOptions(argc, argv, options))
+        return 2;
+
+    printHeader(options);
+    for (int size : options.sizes)
+    {
+        for (Distribution distribution : options.distributions)
+            run(options, size, distribution);
+    }
+    return 0;
+}
@@ -0,0 +1,170 @@
+//
+// Wet2 benchmark - drives every world_cup_t operation at the requested sizes and id distributions.
+//
+// usage: bench23a2 [--sizes 1000,10000,...] [--dist uniform,zipf,adversarial] [--ops <n>] [--csv]
+//
+
+#include "worldcup23a2.h"
+#include "BenchUtil.h"
+
+#include <algorithm>
+
+namespace
+{
+    std::vector<permutation_t> allSpirits()
+    {
+        std::vector<permutation_t> spirits;
+        int values[permutation_t::N] = {0, 1, 2, 3, 4};
+        do
+        {
+            spirits.push_back(permutation_t(values));
+        } while (std::next_permutation(values, values + permutation_t::N));
+        return spirits;
+    }
+
+    // calls of an operation that costs `cost` elementary steps, keeping every row to a few seconds
+    int callsFor(const BenchOptions &options, long cost)
+    {
+        long calls = 50000000L / std::max(1L, cost);
+        return (int) std::max(10L, std::min((long) options.maxOps, calls));
+    }
+
+    void run(const BenchOptions &options, int size, Distribution distribution)
+    {
+        const std::vector<permutation_t> spirits = allSpirits();
+        int teamCount = std::max(16, size / 16);
+        IdSource players(distribution, size, 7);
+        IdSource teams(distribution, teamCount, 11);
+        const std::vector<int> &playerIds = players.getIds();
+        const std::vector<int> &teamIds = teams.getIds();
+        std::mt19937 &random = players.getRandom();
+        int calls = callsFor(options, 1);
+
+        world_cup_t *world = new world_cup_t();
+
+        LatencyRecorder addTeam(teamCount);
+        for (int i = 0; i < teamCount; ++i)
+            addTeam.measure([&]() { world->add_team(teamIds[i]); });
+        printResult(options, "add_team", size, distribution, addTeam);
+
+        LatencyRecorder addPlayer(size);
+        for (int i = 0; i < size; ++i)
+        {
+            int teamId = teamIds[teams.pick(teamCount)];
+            const permutation_t &spirit = spirits[random() % spirits.size()];
+            int gamesPlayed = (int) (random() % 10);
+            int ability = (int) (random() % 100) - 20;
+            int cards = (int) (random() % 5);
+            bool goalKeeper = random() % 8 == 0;
+            addPlayer.measure([&]() {
+                world->add_player(playerIds[i], teamId, spirit, gamesPlayed, ability, cards, goalKeeper);
+            });
+        }
+        printResult(options, "add_player", size, distribution, addPlayer);
+
+        LatencyRecorder playMatch(calls);
+        for (int i = 0; i < calls; ++i)
+        {
+            int teamId1 = teamIds[teams.pick(teamCount)];
+            int teamId2 = teamIds[teams.pick(teamCount)];
+            playMatch.measure([&]() { world->play_match(teamId1, teamId2); });
+        }
+        printResult(options, "play_match", size, distribution, playMatch);
+
+        LatencyRecorder numPlayedGames(calls);
+        for (int i = 0; i < calls; ++i)
+        {
+            int playerId = playerIds[players.pick(size)];
+            numPlayedGames.measure([&]() { world->num_played_games_for_player(playerId); });
+        }
+        printResult(options, "num_played_games_for_player", size, distribution, numPlayedGames);
+
+        LatencyRecorder addCards(calls);
+        for (int i = 0; i < calls; ++i)
+        {
+            int playerId = playerIds[players.pick(size)];
+            addCards.measure([&]() { world->add_player_cards(playerId, 1); });
+        }
+        printResult(options, "add_player_cards", size, distribution, addCards);
+
+        LatencyRecorder getCards(calls);
+        for (int i = 0; i < calls; ++i)
+        {
+            int playerId = playerIds[players.pick(size)];
+            getCards.measure([&]() { world->get_player_cards(playerId); });
+        }
+        printResult(options, "get_player_cards", size, distribution, getCards);
+
+        LatencyRecorder teamPoints(calls);
+        for (int i = 0; i < calls; ++i)
+        {
+            int teamId = teamIds[teams.pick(teamCount)];
+            teamPoints.measure([&]() { world->get_team_points(teamId); });
+        }
+        printResult(options, "get_team_points", size, distribution, teamPoints);
+
+        LatencyRecorder ithAbility(calls);
+        for (int i = 0; i < calls; ++i)
+        {
+            int rank = teams.pick(teamCount);
+            ithAbility.measure([&]() { world->get_ith_pointless_ability(rank); });
+        }
+        printResult(options, "get_ith_pointless_ability", size, distribution, ithAbility);
+
+        LatencyRecorder partialSpirit(calls);
+        for (int i = 0; i < calls; ++i)
+        {
+            int playerId = playerIds[players.pick(size)];
+            partialSpirit.measure([&]() { world->get_partial_spirit(playerId); });
+        }
+        printResult(options, "get_partial_spirit", size, distribution, partialSpirit);
+
+        // pairs of distinct teams, each team bought at most once
+        int buys = std::min(calls, teamCount / 4);
+        LatencyRecorder buyTeam(buys);
+        for (int i = 0; i < buys; ++i)
+        {
+            int buyer = teamIds[2 * i];
+            int bought = teamIds[2 * i + 1];
+            buyTeam.measure([&]() { world->buy_team(buyer, bought); });
+        }
+        printResult(options, "buy_team", size, distribution, buyTeam);
+
+        // deeper union find trees after the purchases
+        LatencyRecorder spiritAfterBuy(calls);
+        for (int i = 0; i < calls; ++i)
+        {
+            int playerId = playerIds[players.pick(size)];
+            spiritAfterBuy.measure([&]() { world->get_partial_spirit(playerId); });
+        }
+        printResult(options, "get_partial_spirit(bought)", size, distribution, spiritAfterBuy);
+
+        int removals = std::min(calls, teamCount / 2);
+        LatencyRecorder removeTeam(removals);
+        for (int i = 0; i < removals; ++i)
+        {
+            int teamId = teamIds[teamCount - 1 - i];
+            removeTeam.measure([&]() { world->remove_team(teamId); });
+        }
+        printResult(options, "remove_team", size, distribution, removeTeam);
+
+        LatencyRecorder teardown(1);
+        teardown.measure([&]() { delete world; });
+        printResult(options, "~world_cup_t", size, distribution, teardown);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions options;
+    if (!parseBenchOptions(argc, argv, options))
+        return 2;
+
+    printHeader(options);
+    for (int size : options.sizes)
+    {
+        for (Distribution distribution : options.distributions)
+            run(options, size, distribution);
+    }
+    return 0;
+}
@@ -0,0 +1,84 @@
+#ifndef TOOLS_COMMANDS_23A1_H_
+#define TOOLS_COMMANDS_23A1_H_
+
+/*
+ * Runs op records against a Wet1 world_cup_t - shared by the command driver and the tools built on it.
+ */
+
+#include "worldcup23a1.h"
+#include "DriverCommon.h"
+
+#include <vector>
+
+namespace wet1
+{
+    // output array of get_all_players, grown as needed
+    inline std::vector<int> &allPlayersBuffer()
+    {
+        static std::vector<int> buffer;
+        return buffer;
+    }
+
+    inline Outcome queryAllPlayers(world_cup_t &world, const char *cmd, int teamId, std::ostream *out)
+    {
+        output_t<int> count = world.get_all_players_count(teamId);
+        int size = (count.status() == StatusType::SUCCESS) ? count.ans() : 0;
+        if ((int) allPlayersBuffer().size() < size)
+            allPlayersBuffer().resize(size);
+
+        StatusType status = world.get_all_players(teamId, size > 0 ? allPlayersBuffer().data() : nullptr);
+        report(out, cmd, status);
+        if (status != StatusType::SUCCESS)
+            return Outcome{status, 0};
+
+        if (out != nullptr)
+        {
+            for (int i = 0; i < size; ++i)
+                *out << allPlayersBuffer()[i] << std::endl;
+        }
+        return Outcome{status, checksum(allPlayersBuffer().data(), size)};
+    }
+
+    inline Outcome apply(world_cup_t &world, const OpRecord &record, std::ostream *out)
+    {
+        const int32_t *a = record.args;
+        bool goalKeeper = (record.flags & OpRecord::FLAG_GOAL_KEEPER) != 0;
+        const char *cmd = opName((OpCode) record.op);
+
+        switch ((OpCode) record.op)
+        {
+            case OpCode::ADD_TEAM:
+                return report(out, cmd, world.add_team(a[0], a[1]));
+            case OpCode::REMOVE_TEAM:
+                return report(out, cmd, world.remove_team(a[0]));
+            case OpCode::ADD_PLAYER:
+                return report(out, cmd, world.add_player(a[0], a[1], a[2], a[3], a[4], goalKeeper));
+            case OpCode::REMOVE_PLAYER:
+                return report(out, cmd, world.remove_player(a[0]));
+            case OpCode::UPDATE_PLAYER_STATS:
+                return report(out, cmd, world.update_player_stats(a[0], a[1], a[2], a[3]));
+            case OpCode::PLAY_MATCH:
+                return report(out, cmd, world.play_match(a[0], a[1]));
+            case OpCode::GET_NUM_PLAYED_GAMES:
+                return report(out, cmd, world.get_num_played_games(a[0]));
+            case OpCode::GET_TEAM_POINTS:
+                return report(out, cmd, world.get_team_points(a[0]));
+            case OpCode::UNITE_TEAMS:
+                return report(out, cmd, world.unite_teams(a[0], a[1], a[2]));
+            case OpCode::GET_TOP_SCORER:
+                return report(out, cmd, world.get_top_scorer(a[0]));
+            case OpCode::GET_ALL_PLAYERS_COUNT:
+                return report(out, cmd, world.get_all_players_count(a[0]));
+            case OpCode::GET_ALL_PLAYERS:
+                return queryAllPlayers(world, cmd, a[0], out);
+            case OpCode::GET_CLOSEST_PLAYER:
+                return report(out, cmd, world.get_closest_player(a[0], a[1]));
+            case OpCode::KNOCKOUT_WINNER:
+                return report(out, cmd, world.knockout_winner(a[0], a[1]));
+            default:
+                return report(out, cmd, StatusType::INVALID_INPUT);
+        }
+    }
+}
+
+#endif //TOOLS_COMMANDS_23A1_H_
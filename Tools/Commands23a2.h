@@ -0,0 +1,120 @@
+#ifndef TOOLS_COMMANDS_23A2_H_
+#define TOOLS_COMMANDS_23A2_H_
+
+/*
+ * Runs op records against a Wet2 world_cup_t - shared by the command driver and the tools built on it.
+ */
+
+#include "worldcup23a2.h"
+#include "DriverCommon.h"
+#include "SpiritPacking.h"
+
+#include <new>
+#include <sstream>
+
+namespace wet2
+{
+    // permutation_t objects for every packed spirit, built once so replaying add_player does no parsing
+    class SpiritTable
+    {
+    public:
+        SpiritTable()
+        {
+            // permutation_t has a copy constructor but no assignment, so every entry is built in place
+            int values[permutation_t::N];
+            for (int i = 0; i < SIZE; ++i)
+            {
+                void *entry = storage + i * sizeof(permutation_t);
+                if (unpackSpirit((uint8_t) i, values))
+                    new(entry) permutation_t(values);
+                else
+                    new(entry) permutation_t(permutation_t::invalid());
+            }
+        }
+
+        const permutation_t &operator[](uint8_t packed) const
+        {
+            return reinterpret_cast<const permutation_t *>(storage)[packed];
+        }
+
+    private:
+        static const int SIZE = OpRecord::INVALID_SPIRIT + 1;
+        alignas(permutation_t) unsigned char storage[SIZE * sizeof(permutation_t)];
+    };
+
+    inline const SpiritTable &spiritTable()
+    {
+        static const SpiritTable table;
+        return table;
+    }
+
+    inline Outcome report(std::ostream *out, const char *cmd, output_t<permutation_t> res)
+    {
+        if (res.status() != StatusType::SUCCESS)
+            return ::report(out, cmd, res.status());
+
+        // permutation_t does not expose its values, so go through its text form
+        std::ostringstream text;
+        text << res.ans();
+        if (out != nullptr)
+            *out << cmd << ": " << STATUS_NAMES[(int) res.status()] << ", " << text.str() << std::endl;
+        return Outcome{StatusType::SUCCESS, packSpirit(text.str().c_str())};
+    }
+
+    using ::report;
+
+    inline Outcome checkPartialSpirit(world_cup_t &world, const OpRecord &record, const char *cmd, std::ostream *out)
+    {
+        if (out != nullptr || record.expectedStatus == OpRecord::NO_EXPECTATION)
+            return report(out, cmd, world.get_partial_spirit(record.args[0]));
+
+        // replay: compare against the recorded permutation without formatting it.
+        // strength() is maximal (55) only for the neutral permutation, so res == expected
+        // exactly when res * expected.inv() has that strength.
+        output_t<permutation_t> res = world.get_partial_spirit(record.args[0]);
+        if (res.status() != StatusType::SUCCESS)
+            return Outcome{res.status(), 0};
+        const permutation_t &expected = spiritTable()[(uint8_t) record.expectedAnswer];
+        if (expected.isvalid() && (res.ans() * expected.inv()).strength() == permutation_t::neutral().strength())
+            return Outcome{StatusType::SUCCESS, record.expectedAnswer};
+        return report(nullptr, cmd, res);
+    }
+
+    inline Outcome apply(world_cup_t &world, const OpRecord &record, std::ostream *out)
+    {
+        const int32_t *a = record.args;
+        bool goalKeeper = (record.flags & OpRecord::FLAG_GOAL_KEEPER) != 0;
+        const char *cmd = opName((OpCode) record.op);
+
+        switch ((OpCode) record.op)
+        {
+            case OpCode::ADD_TEAM:
+                return report(out, cmd, world.add_team(a[0]));
+            case OpCode::REMOVE_TEAM:
+                return report(out, cmd, world.remove_team(a[0]));
+            case OpCode::ADD_PLAYER:
+                return report(out, cmd, world.add_player(a[0], a[1], spiritTable()[record.spirit],
+                                                         a[2], a[3], a[4], goalKeeper));
+            case OpCode::PLAY_MATCH:
+                return report(out, cmd, world.play_match(a[0], a[1]));
+            case OpCode::NUM_PLAYED_GAMES_FOR_PLAYER:
+                return report(out, cmd, world.num_played_games_for_player(a[0]));
+            case OpCode::ADD_PLAYER_CARDS:
+                return report(out, cmd, world.add_player_cards(a[0], a[1]));
+            case OpCode::GET_PLAYER_CARDS:
+                return report(out, cmd, world.get_player_cards(a[0]));
+            case OpCode::GET_TEAM_POINTS:
+                return report(out, cmd, world.get_team_points(a[0]));
+            case OpCode::GET_ITH_POINTLESS_ABILITY:
+                return report(out, cmd, world.get_ith_pointless_ability(a[0]));
+            case OpCode::GET_PARTIAL_SPIRIT:
+                return checkPartialSpirit(world, record, cmd, out);
+            case OpCode::BUY_TEAM:
+                return report(out, cmd, world.buy_team(a[0], a[1]));
+            default:
+                return report(out, cmd, StatusType::INVALID_INPUT);
+        }
+    }
+}
+
+#endif //TOOLS_COMMANDS_23A2_H_
@@ -0,0 +1,373 @@
+#ifndef TOOLS_DRIVER_COMMON_H_
+#define TOOLS_DRIVER_COMMON_H_
+
+/*
+ * Shared main loop of the Wet1 and Wet2 command drivers.
+ * Include after the exercise's worldcup23aX.h (StatusType and output_t come from there).
+ */
+
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <poll.h>
+#include <unistd.h>
+#include "OpLog.h"
+#include "WriteAheadLog.h"
+
+static const char *const STATUS_NAMES[] = {
+        "SUCCESS",
+        "ALLOCATION_ERROR",
+        "INVALID_INPUT",
+        "FAILURE"
+};
+
+// What a single command returned, in the form stored in OpRecord
+struct Outcome
+{
+    StatusType status;
+    int32_t answer;
+};
+
+inline Outcome report(std::ostream *out, const char *cmd, StatusType status)
+{
+    if (out != nullptr)
+        *out << cmd << ": " << STATUS_NAMES[(int) status] << std::endl;
+    return Outcome{status, 0};
+}
+
+inline Outcome report(std::ostream *out, const char *cmd, output_t<int> res)
+{
+    if (res.status() != StatusType::SUCCESS)
+        return report(out, cmd, res.status());
+    if (out != nullptr)
+        *out << cmd << ": " << STATUS_NAMES[(int) res.status()] << ", " << res.ans() << std::endl;
+    return Outcome{StatusType::SUCCESS, res.ans()};
+}
+
+// Order dependent checksum of an output array, recorded instead of the whole array
+inline int32_t checksum(const int *values, int count)
+{
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < count; ++i)
+    {
+        hash ^= (uint32_t) values[i];
+        hash *= 16777619u;
+    }
+    return (int32_t) hash;
+}
+
+inline void printDriverUsage(const char *program)
+{
+    std::cerr << "usage: " << program << " [--record <log.bin>] [--wal <wal.bin> [--group <n>] [--group-delay <us>]]"
+              << " [--snapshot <file>] [--stats] [--latency <n>] < commands.txt" << std::endl
+              << "       " << program << " --replay <log.bin> [--verbose] [--stats] [--latency <n>]" << std::endl;
+}
+
+struct DriverOptions
+{
+    const char *recordPath;
+    const char *replayPath;
+    const char *walPath;
+    const char *snapshotPath;
+    int groupSize;
+    std::chrono::microseconds groupDelay;
+    bool verbose;
+    bool stats;
+    int latencySampling;
+};
+
+/**
+ * Replays a binary op log against a fresh world and checks every recorded outcome.
+ * Prints a one line summary, and the mismatching commands when verbose.
+ * @return number of mismatches, or -1 if the log could not be read
+ */
+template<class World, class Apply>
+long replayLog(const char *path, int target, Apply apply, bool verbose)
+{
+    OpLogReader reader;
+    if (!reader.open(path))
+    {
+        std::cerr << path << ": not an op log" << std::endl;
+        return -1;
+    }
+    if (reader.getTarget() != target)
+    {
+        std::cerr << path << ": log was recorded for Wet" << reader.getTarget() << std::endl;
+        return -1;
+    }
+
+    World *world = new World();
+    const OpRecord *records = reader.getRecords();
+    size_t count = reader.getCount();
+    long mismatches = 0;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i)
+    {
+        const OpRecord &record = records[i];
+        Outcome outcome = apply(*world, record, nullptr);
+        if (record.expectedStatus == OpRecord::NO_EXPECTATION)
+            continue;
+        if ((uint8_t) outcome.status != record.expectedStatus || outcome.answer != record.expectedAnswer)
+        {
+            mismatches++;
+            if (verbose)
+            {
+                std::cerr << "#" << i << " " << formatTextCommand(record, target) << ": expected "
+                          << STATUS_NAMES[record.expectedStatus & 3] << "/" << record.expectedAnswer << ", got "
+                          << STATUS_NAMES[(int) outcome.status] << "/" << outcome.answer << std::endl;
+            }
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    delete world;
+
+    std::cout << "replayed " << count << " ops in " << elapsed.count() << " s ("
+              << (elapsed.count() > 0 ? (double) count / elapsed.count() : 0.0) << " ops/s), "
+              << mismatches << " mismatches" << std::endl;
+    return mismatches;
+}
+
+/**
+ * Rebuilds a world from the latest snapshot and the write-ahead log: the snapshot is loaded (an empty
+ * world is created when there is none) and the log records after the snapshot's sequence are applied.
+ * A record whose command failed when it ran (ALLOCATION_ERROR included) left the world unchanged, so it
+ * is skipped rather than given a second chance that would make the recovered world differ.
+ * @param snapshotPath - nullptr for no snapshot
+ * @param walPath - nullptr for no log, a missing file is an empty log
+ * @param sequence - receives the log position the returned world reflects
+ * @return nullptr if the log is unreadable or ends before the snapshot
+ */
+template<class World, class Apply>
+World *recoverWorld(const char *snapshotPath, const char *walPath, int target, Apply apply, uint64_t *sequence)
+{
+    uint64_t snapshotSequence = 0;
+    World *world = (snapshotPath != nullptr) ? World::loadSnapshot(snapshotPath, &snapshotSequence) : nullptr;
+    if (world == nullptr)
+    {
+        snapshotSequence = 0;
+        world = new World();
+    }
+    *sequence = snapshotSequence;
+
+    FILE *file = (walPath != nullptr) ? std::fopen(walPath, "rb") : nullptr;
+    if (file == nullptr)
+        return world;
+    std::fclose(file);
+
+    OpLogReader reader;
+    if (!reader.open(walPath) || reader.getTarget() != target)
+    {
+        std::cerr << walPath << ": not a write-ahead log of Wet" << target << std::endl;
+        delete world;
+        return nullptr;
+    }
+    uint64_t base = reader.getBaseSequence();
+    uint64_t end = base + reader.getCount();
+    if (end < snapshotSequence || base > snapshotSequence)
+    {
+        std::cerr << walPath << ": log holds the records " << base << " to " << end << ", the snapshot is at "
+                  << snapshotSequence << std::endl;
+        delete world;
+        return nullptr;
+    }
+
+    const OpRecord *records = reader.getRecords();
+    for (size_t i = snapshotSequence - base; i < reader.getCount(); ++i)
+    {
+        const OpRecord &record = records[i];
+        if (record.expectedStatus == OpRecord::NO_EXPECTATION || record.expectedStatus == (uint8_t) StatusType::SUCCESS)
+            apply(*world, record, nullptr);
+    }
+    *sequence = end;
+    return world;
+}
+
+// Waits up to timeout for more input on stdin, false if there is still none by then
+inline bool waitForInput(std::chrono::microseconds timeout)
+{
+    if (std::cin.rdbuf()->in_avail() > 0)
+        return true;
+    long long ms = (timeout.count() + 999) / 1000;
+    struct pollfd input = {STDIN_FILENO, POLLIN, 0};
+    // a poll error is left to the read that follows
+    return poll(&input, 1, (int) (ms < INT_MAX ? ms : INT_MAX)) != 0;
+}
+
+// Prints the results held back for a write-ahead log group that is now durable
+inline void releaseOutput(std::ostringstream &held)
+{
+    std::cout << held.str() << std::flush;
+    held.str(std::string());
+}
+
+/**
+ * Runs text commands from stdin, printing each result in the course format.
+ * Optionally records every command together with its outcome into a binary op log.
+ * With a write-ahead log (and/or a snapshot) the world is recovered first, every mutating command
+ * is logged with its outcome, and a snapshot of the final state is saved at the end, after which the
+ * log is rotated. Results are held back until the log records before them are synced, so no result
+ * of a command that a crash could lose is ever printed.
+ */
+template<class World, class Apply>
+int runTextDriver(const DriverOptions &options, int target, Apply apply)
+{
+    OpLogWriter writer;
+    if (options.recordPath != nullptr && !writer.open(options.recordPath, target))
+    {
+        std::cerr << options.recordPath << ": cannot write" << std::endl;
+        return 1;
+    }
+
+    uint64_t sequence = 0;
+    World *world = recoverWorld<World>(options.snapshotPath, options.walPath, target, apply, &sequence);
+    if (world == nullptr)
+        return 1;
+
+    WriteAheadLog wal;
+    if (options.walPath != nullptr && !wal.open(options.walPath, target, options.groupSize, options.groupDelay))
+    {
+        std::cerr << options.walPath << ": cannot write" << std::endl;
+        delete world;
+        return 1;
+    }
+
+    std::ostringstream held;
+    std::ostream *out = (options.walPath != nullptr) ? &held : &std::cout;
+
+    // a group that is not full is committed once it is due, or right away when the input runs dry,
+    // instead of holding back its results until more commands come
+    bool idleSync = options.groupSize > 0 || options.groupDelay > std::chrono::microseconds::zero();
+
+    std::string line;
+    OpRecord record;
+    bool ok = true;
+    while (true)
+    {
+        if (options.walPath != nullptr && idleSync && wal.getDurableSequence() != wal.getSequence())
+        {
+            std::chrono::microseconds wait = (options.groupDelay > std::chrono::microseconds::zero())
+                                             ? wal.timeUntilDue() : std::chrono::microseconds::zero();
+            if (!waitForInput(wait))
+            {
+                if (!wal.sync())
+                {
+                    std::cerr << options.walPath << ": write failed" << std::endl;
+                    ok = false;
+                    break;
+                }
+                releaseOutput(held);
+            }
+        }
+        if (!std::getline(std::cin, line))
+            break;
+
+        if (line.find_first_not_of(" \t\r") == std::string::npos)
+            continue;
+        if (!parseTextCommand(line, target, record))
+        {
+            std::cerr << "bad command: " << line << std::endl;
+            continue;
+        }
+        Outcome outcome = apply(*world, record, out);
+        record.expectedStatus = (uint8_t) outcome.status;
+        record.expectedAnswer = outcome.answer;
+        if (options.recordPath != nullptr)
+            writer.append(record);
+        if (options.walPath != nullptr && isMutating((OpCode) record.op) && !wal.append(record))
+        {
+            std::cerr << options.walPath << ": write failed" << std::endl;
+            ok = false;
+            break;
+        }
+        if (options.walPath != nullptr && wal.getDurableSequence() == wal.getSequence())
+            releaseOutput(held);
+    }
+
+    if (options.walPath != nullptr)
+    {
+        ok = wal.sync() && ok;
+        sequence = wal.getSequence();
+        if (ok)
+            releaseOutput(held);
+        else
+            std::cerr << options.walPath << ": the results of the commands after the last sync were not printed"
+                      << std::endl;
+    }
+    if (ok && options.snapshotPath != nullptr)
+    {
+        if (world->saveSnapshot(options.snapshotPath, sequence) != StatusType::SUCCESS)
+        {
+            std::cerr << options.snapshotPath << ": cannot write" << std::endl;
+            ok = false;
+        }
+        // the log is only dropped once the snapshot that replaces it survives a crash
+        else if (options.walPath != nullptr &&
+                 !(WriteAheadLog::syncDirectoryOf(options.snapshotPath) && wal.rotate()))
+        {
+            std::cerr << options.walPath << ": cannot rotate" << std::endl;
+            ok = false;
+        }
+    }
+    if (options.walPath != nullptr)
+        ok = wal.close() && ok;
+    delete world;
+
+    return (writer.close() && ok) ? 0 : 1;
+}
+
+template<class World, class Apply>
+int runDriver(int argc, char **argv, int target, Apply apply)
+{
+    DriverOptions options = {nullptr, nullptr, nullptr, nullptr, 1, std::chrono::microseconds::zero(), false, false, 0};
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+            options.recordPath = argv[++i];
+        else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+            options.replayPath = argv[++i];
+        else if (std::strcmp(argv[i], "--wal") == 0 && i + 1 < argc)
+            options.walPath = argv[++i];
+        else if (std::strcmp(argv[i], "--group") == 0 && i + 1 < argc)
+            options.groupSize = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--group-delay") == 0 && i + 1 < argc)
+            options.groupDelay = std::chrono::microseconds(std::atoll(argv[++i]));
+        else if (std::strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc)
+            options.snapshotPath = argv[++i];
+        else if (std::strcmp(argv[i], "--verbose") == 0)
+            options.verbose = true;
+        else if (std::strcmp(argv[i], "--stats") == 0)
+            options.stats = true;
+        else if (std::strcmp(argv[i], "--latency") == 0 && i + 1 < argc)
+            options.latencySampling = std::atoi(argv[++i]);
+        else
+        {
+            printDriverUsage(argv[0]);
+            return 2;
+        }
+    }
+
+    // stdin gets a buffer of its own, so waitForInput sees the lines already read ahead
+    std::ios::sync_with_stdio(false);
+    World::setLatencySampling(options.latencySampling);
+    int status;
+    if (options.replayPath != nullptr)
+        status = replayLog<World>(options.replayPath, target, apply, options.verbose) == 0 ? 0 : 1;
+    else
+        status = runTextDriver<World>(options, target, apply);
+
+    // the hot path counters, all zero unless built with WC_STATS
+    if (options.stats)
+        World::getStats().print(std::cerr);
+    if (options.latencySampling > 0)
+        World::dumpLatency(std::cerr);
+    return status;
+}
+
+#endif //TOOLS_DRIVER_COMMON_H_
@@ -0,0 +1,331 @@
+#include "OpLog.h"
+#include "SpiritPacking.h"
+
+#include <cstring>
+#include <sstream>
+
+namespace
+{
+    const char MAGIC[8] = {'W', 'C', 'O', 'P', 'L', 'O', 'G', '\0'};
+
+    // Describes how a command is laid out in the text form of one target
+    struct OpSignature
+    {
+        OpCode op;
+        int target;     // 0 - both
+        int argCount;   // integer arguments (without spirit and goalKeeper)
+        bool hasSpirit; // spirit follows the second integer argument
+        bool hasFlag;   // trailing goalKeeper bool
+    };
+
+    const OpSignature SIGNATURES[] = {
+            {OpCode::ADD_TEAM,                    1, 2, false, false},
+            {OpCode::ADD_TEAM,                    2, 1, false, false},
+            {OpCode::REMOVE_TEAM,                 0, 1, false, false},
+            {OpCode::ADD_PLAYER,                  1, 5, false, true},
+            {OpCode::ADD_PLAYER,                  2, 5, true,  true},
+            {OpCode::PLAY_MATCH,                  0, 2, false, false},
+            {OpCode::GET_TEAM_POINTS,             0, 1, false, false},
+            {OpCode::REMOVE_PLAYER,               1, 1, false, false},
+            {OpCode::UPDATE_PLAYER_STATS,         1, 4, false, false},
+            {OpCode::GET_NUM_PLAYED_GAMES,        1, 1, false, false},
+            {OpCode::UNITE_TEAMS,                 1, 3, false, false},
+            {OpCode::GET_TOP_SCORER,              1, 1, false, false},
+            {OpCode::GET_ALL_PLAYERS_COUNT,       1, 1, false, false},
+            {OpCode::GET_ALL_PLAYERS,             1, 1, false, false},
+            {OpCode::GET_CLOSEST_PLAYER,          1, 2, false, false},
+            {OpCode::KNOCKOUT_WINNER,             1, 2, false, false},
+            {OpCode::NUM_PLAYED_GAMES_FOR_PLAYER, 2, 1, false, false},
+            {OpCode::ADD_PLAYER_CARDS,            2, 2, false, false},
+            {OpCode::GET_PLAYER_CARDS,            2, 1, false, false},
+            {OpCode::GET_ITH_POINTLESS_ABILITY,   2, 1, false, false},
+            {OpCode::GET_PARTIAL_SPIRIT,          2, 1, false, false},
+            {OpCode::BUY_TEAM,                    2, 2, false, false},
+    };
+
+    const char *const NAMES[] = {
+            "invalid",
+            "add_team",
+            "remove_team",
+            "add_player",
+            "play_match",
+            "get_team_points",
+            "remove_player",
+            "update_player_stats",
+            "get_num_played_games",
+            "unite_teams",
+            "get_top_scorer",
+            "get_all_players_count",
+            "get_all_players",
+            "get_closest_player",
+            "knockout_winner",
+            "num_played_games_for_player",
+            "add_player_cards",
+            "get_player_cards",
+            "get_ith_pointless_ability",
+            "get_partial_spirit",
+            "buy_team",
+    };
+
+    const OpSignature *findSignature(OpCode op, int target)
+    {
+        for (const OpSignature &signature : SIGNATURES)
+        {
+            if (signature.op == op && (signature.target == 0 || signature.target == target))
+                return &signature;
+        }
+        return nullptr;
+    }
+}
+
+void initOpLogHeader(OpLogHeader &header, int target)
+{
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = OpLogHeader::VERSION;
+    header.target = (uint8_t) target;
+    header.recordSize = sizeof(OpRecord);
+}
+
+size_t checkOpLogHeader(OpLogHeader &header, size_t available)
+{
+    if (available < OpLogHeader::VERSION_1_SIZE || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        header.recordSize != sizeof(OpRecord))
+        return 0;
+    if (header.version == OpLogHeader::VERSION_1)
+    {
+        // what was read past the header is the first record
+        header.baseSequence = 0;
+        return OpLogHeader::VERSION_1_SIZE;
+    }
+    if (header.version == OpLogHeader::VERSION && available >= sizeof(OpLogHeader))
+        return sizeof(OpLogHeader);
+    return 0;
+}
+
+// Writer ---------------------------------------------------------------
+
+OpLogWriter::OpLogWriter() : file(nullptr), buffer(nullptr), buffered(0)
+{}
+
+OpLogWriter::~OpLogWriter()
+{
+    close();
+}
+
+bool OpLogWriter::open(const char *path, int target)
+{
+    close();
+    file = std::fopen(path, "wb");
+    if (file == nullptr)
+        return false;
+    buffer = new OpRecord[BUFFER_RECORDS];
+
+    OpLogHeader header;
+    initOpLogHeader(header, target);
+    return std::fwrite(&header, sizeof(header), 1, file) == 1;
+}
+
+bool OpLogWriter::append(const OpRecord &record)
+{
+    if (file == nullptr)
+        return false;
+    buffer[buffered++] = record;
+    if (buffered == BUFFER_RECORDS)
+        return flushBuffer();
+    return true;
+}
+
+bool OpLogWriter::flushBuffer()
+{
+    if (buffered == 0)
+        return true;
+    bool ok = std::fwrite(buffer, sizeof(OpRecord), buffered, file) == (size_t) buffered;
+    buffered = 0;
+    return ok;
+}
+
+bool OpLogWriter::close()
+{
+    if (file == nullptr)
+        return true;
+    bool ok = flushBuffer();
+    ok = (std::fclose(file) == 0) && ok;
+    file = nullptr;
+    delete[] buffer;
+    buffer = nullptr;
+    return ok;
+}
+
+// Reader ---------------------------------------------------------------
+
+OpLogReader::OpLogReader() : target(0), baseSequence(0), count(0), records(nullptr)
+{}
+
+OpLogReader::~OpLogReader()
+{
+    delete[] records;
+}
+
+bool OpLogReader::open(const char *path)
+{
+    delete[] records;
+    records = nullptr;
+    count = 0;
+
+    FILE *file = std::fopen(path, "rb");
+    if (file == nullptr)
+        return false;
+
+    OpLogHeader header;
+    size_t headerSize = checkOpLogHeader(header, std::fread(&header, 1, sizeof(header), file));
+    if (headerSize == 0)
+    {
+        std::fclose(file);
+        return false;
+    }
+    target = header.target;
+    baseSequence = header.baseSequence;
+
+    std::fseek(file, 0, SEEK_END);
+    long end = std::ftell(file);
+    std::fseek(file, (long) headerSize, SEEK_SET);
+
+    count = (size_t) (end - (long) headerSize) / sizeof(OpRecord);
+    records = new OpRecord[count > 0 ? count : 1];
+    count = std::fread(records, sizeof(OpRecord), count, file);
+    std::fclose(file);
+    return true;
+}
+
+int OpLogReader::getTarget() const
+{
+    return target;
+}
+
+uint64_t OpLogReader::getBaseSequence() const
+{
+    return baseSequence;
+}
+
+size_t OpLogReader::getCount() const
+{
+    return count;
+}
+
+const OpRecord *OpLogReader::getRecords() const
+{
+    return records;
+}
+
+// Text form ---------------------------------------------------------------
+
+const char *opName(OpCode op)
+{
+    if ((int) op >= (int) OpCode::OP_COUNT)
+        return NAMES[0];
+    return NAMES[(int) op];
+}
+
+OpCode opFromName(const std::string &name, int target)
+{
+    for (int i = 1; i < (int) OpCode::OP_COUNT; ++i)
+    {
+        if (name == NAMES[i] && findSignature((OpCode) i, target) != nullptr)
+            return (OpCode) i;
+    }
+    return OpCode::INVALID;
+}
+
+bool parseTextCommand(const std::string &line, int target, OpRecord &record)
+{
+    std::istringstream in(line);
+    std::string name;
+    if (!(in >> name))
+        return false;
+
+    OpCode op = opFromName(name, target);
+    const OpSignature *signature = findSignature(op, target);
+    if (signature == nullptr)
+        return false;
+
+    std::memset(&record, 0, sizeof(record));
+    record.op = (uint8_t) op;
+    record.spirit = OpRecord::INVALID_SPIRIT;
+    record.expectedStatus = OpRecord::NO_EXPECTATION;
+
+    for (int i = 0; i < signature->argCount; ++i)
+    {
+        if (signature->hasSpirit && i == 2)
+        {
+            std::string spirit;
+            if (!(in >> spirit))
+                return false;
+            record.spirit = packSpirit(spirit.c_str());
+        }
+        if (!(in >> record.args[i]))
+            return false;
+    }
+
+    if (signature->hasFlag)
+    {
+        std::string flag;
+        if (!(in >> flag))
+            return false;
+        if (flag == "true" || flag == "1")
+            record.flags |= OpRecord::FLAG_GOAL_KEEPER;
+        else if (flag != "false" && flag != "0")
+            return false;
+    }
+    return true;
+}
+
+std::string formatTextCommand(const OpRecord &record, int target)
+{
+    const OpSignature *signature = findSignature((OpCode) record.op, target);
+    if (signature == nullptr)
+        return NAMES[0];
+
+    std::ostringstream out;
+    out << opName((OpCode) record.op);
+    for (int i = 0; i < signature->argCount; ++i)
+    {
+        if (signature->hasSpirit && i == 2)
+        {
+            int values[SPIRIT_SIZE];
+            out << ' ';
+            if (unpackSpirit(record.spirit, values))
+            {
+                for (int j = 0; j < SPIRIT_SIZE; ++j)
+                    out << (j > 0 ? "," : "") << values[j] + 1;
+            }
+            else
+            {
+                out << "*,*,*,*,*";
+            }
+        }
+        out << ' ' << record.args[i];
+    }
+    if (signature->hasFlag)
+        out << ((record.flags & OpRecord::FLAG_GOAL_KEEPER) ? " true" : " false");
+    return out.str();
+}
+
+bool isMutating(OpCode op)
+{
+    switch (op)
+    {
+        case OpCode::ADD_TEAM:
+        case OpCode::REMOVE_TEAM:
+        case OpCode::ADD_PLAYER:
+        case OpCode::PLAY_MATCH:
+        case OpCode::REMOVE_PLAYER:
+        case OpCode::UPDATE_PLAYER_STATS:
+        case OpCode::UNITE_TEAMS:
+        case OpCode::ADD_PLAYER_CARDS:
+        case OpCode::BUY_TEAM:
+            return true;
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,204 @@
+#ifndef TOOLS_OP_LOG_H_
+#define TOOLS_OP_LOG_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+/*
+ * Binary command log shared by the Wet1 and Wet2 drivers.
+ *
+ * A log is a 24 byte header followed by fixed-size 28 byte records, in host byte order
+ * (little endian on supported targets). Version 1 logs have a 16 byte header without
+ * baseSequence and are still read, as logs that start at sequence 0.
+ * The header says which exercise the log targets, since both exercises reuse
+ * some command names (add_team, add_player, play_match...) with different arguments.
+ */
+
+enum class OpCode : uint8_t
+{
+    INVALID = 0,
+
+    // Wet1 and Wet2
+    ADD_TEAM = 1,
+    REMOVE_TEAM = 2,
+    ADD_PLAYER = 3,
+    PLAY_MATCH = 4,
+    GET_TEAM_POINTS = 5,
+
+    // Wet1 only
+    REMOVE_PLAYER = 6,
+    UPDATE_PLAYER_STATS = 7,
+    GET_NUM_PLAYED_GAMES = 8,
+    UNITE_TEAMS = 9,
+    GET_TOP_SCORER = 10,
+    GET_ALL_PLAYERS_COUNT = 11,
+    GET_ALL_PLAYERS = 12,
+    GET_CLOSEST_PLAYER = 13,
+    KNOCKOUT_WINNER = 14,
+
+    // Wet2 only
+    NUM_PLAYED_GAMES_FOR_PLAYER = 15,
+    ADD_PLAYER_CARDS = 16,
+    GET_PLAYER_CARDS = 17,
+    GET_ITH_POINTLESS_ABILITY = 18,
+    GET_PARTIAL_SPIRIT = 19,
+    BUY_TEAM = 20,
+
+    OP_COUNT = 21
+};
+
+/*
+ * One command. Arguments are stored in the order of the world_cup_t method signature,
+ * with the spirit (Wet2 add_player) and the goalKeeper flag pulled out of args[].
+ *
+ *  expectedStatus - StatusType of the recorded run, or NO_EXPECTATION
+ *  expectedAnswer - output_t answer of the recorded run (packed spirit for get_partial_spirit,
+ *                   checksum of the output ids for get_all_players)
+ */
+struct OpRecord
+{
+    uint8_t op;
+    uint8_t spirit;
+    uint8_t flags;
+    uint8_t expectedStatus;
+    int32_t args[5];
+    int32_t expectedAnswer;
+
+    static const uint8_t FLAG_GOAL_KEEPER = 1;
+    static const uint8_t NO_EXPECTATION = 0xFF;
+    static const uint8_t INVALID_SPIRIT = 0xFF; // INVALID_SPIRIT_RANK of SpiritPacking.h
+};
+
+static_assert(sizeof(OpRecord) == 28, "OpRecord must stay a fixed 28 byte record");
+
+struct OpLogHeader
+{
+    char magic[8];
+    uint16_t version;
+    uint8_t target;     // 1 - Wet1, 2 - Wet2
+    uint8_t recordSize;
+    uint32_t reserved;
+    uint64_t baseSequence;  // sequence of the first record, nonzero only in a rotated write-ahead log
+
+    static const uint16_t VERSION = 2;
+    static const uint16_t VERSION_1 = 1;
+    static const size_t VERSION_1_SIZE = 16; // the header up to baseSequence
+};
+
+static_assert(sizeof(OpLogHeader) == 24, "OpLogHeader must stay 24 bytes");
+static_assert(offsetof(OpLogHeader, baseSequence) == OpLogHeader::VERSION_1_SIZE,
+              "a version 1 header has to be a prefix of the current one");
+
+/**
+ * Fills the header of a new log.
+ * @param header
+ * @param target - 1 or 2
+ */
+void initOpLogHeader(OpLogHeader &header, int target);
+
+/**
+ * Checks the start of a log. A version 1 header is accepted too, its baseSequence is set to 0.
+ * @param header - the first sizeof(OpLogHeader) bytes of the file, or all of it if it is shorter
+ * @param available - the number of bytes read into header
+ * @return the size of the header in the file, 0 if the file is not an op log
+ */
+size_t checkOpLogHeader(OpLogHeader &header, size_t available);
+
+
+class OpLogWriter
+{
+public:
+    OpLogWriter();
+    ~OpLogWriter();
+
+    OpLogWriter(const OpLogWriter &) = delete;
+    OpLogWriter &operator=(const OpLogWriter &) = delete;
+
+    /**
+     * Creates (truncates) the log file and writes its header.
+     * @param path
+     * @param target - 1 or 2
+     * @return false if the file could not be written
+     */
+    bool open(const char *path, int target);
+
+    /**
+     * Appends a record to the log (buffered).
+     * @param record
+     * @return false on a write error
+     */
+    bool append(const OpRecord &record);
+
+    /**
+     * Flushes the buffered records and closes the file.
+     * @return false on a write error
+     */
+    bool close();
+
+private:
+    FILE *file;
+    OpRecord *buffer;
+    int buffered;
+
+    static const int BUFFER_RECORDS = 4096;
+
+    bool flushBuffer();
+};
+
+
+class OpLogReader
+{
+public:
+    OpLogReader();
+    ~OpLogReader();
+
+    OpLogReader(const OpLogReader &) = delete;
+    OpLogReader &operator=(const OpLogReader &) = delete;
+
+    /**
+     * Reads the whole log into memory so replaying it touches no I/O.
+     * A trailing partial record (torn write) is ignored.
+     * @param path
+     * @return false if the file is missing or is not an op log
+     */
+    bool open(const char *path);
+
+    int getTarget() const;
+    uint64_t getBaseSequence() const;
+    size_t getCount() const;
+    const OpRecord *getRecords() const;
+
+private:
+    int target;
+    uint64_t baseSequence;
+    size_t count;
+    OpRecord *records;
+};
+
+
+/*
+ * Text form - one command per line, as read by the course drivers, e.g.
+ *   add_player 1001 1 2,1,3,5,4 2 10 0 false
+ */
+const char *opName(OpCode op);
+OpCode opFromName(const std::string &name, int target);
+
+/**
+ * Parses a single text command of the given target into a record without expectations.
+ * @return false on an unknown command or missing arguments
+ */
+bool parseTextCommand(const std::string &line, int target, OpRecord &record);
+
+/**
+ * Formats a record back into its text command.
+ */
+std::string formatTextCommand(const OpRecord &record, int target);
+
+/**
+ * Returns true for commands that change the world state.
+ */
+bool isMutating(OpCode op);
+
+#endif //TOOLS_OP_LOG_H_
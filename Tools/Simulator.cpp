@@ -0,0 +1,367 @@
+#include "Simulator.h"
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <utility>
+#include <unistd.h>
+
+namespace
+{
+    // splitmix64, small enough to seed one per run
+    class Random
+    {
+    public:
+        Random(uint64_t seed, uint64_t run) : state(seed ^ (run * 0x9E3779B97F4A7C15ull))
+        {}
+
+        uint64_t next()
+        {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        // uniform in [0, bound)
+        int below(int bound)
+        {
+            return (int) (next() % (uint64_t) bound);
+        }
+
+        bool chance(double probability)
+        {
+            return (double) (next() >> 11) * (1.0 / 9007199254740992.0) < probability;
+        }
+
+    private:
+        uint64_t state;
+    };
+}
+
+PointHistogram::PointHistogram() : lowest(0), runs(0)
+{}
+
+void PointHistogram::cover(int points)
+{
+    if (counts.empty())
+    {
+        lowest = points;
+        counts.push_back(0);
+    }
+    else if (points < lowest)
+    {
+        counts.insert(counts.begin(), lowest - points, 0);
+        lowest = points;
+    }
+    else if (points - lowest >= (int) counts.size())
+    {
+        counts.resize(points - lowest + 1, 0);
+    }
+}
+
+void PointHistogram::add(int points)
+{
+    cover(points);
+    counts[points - lowest]++;
+    runs++;
+}
+
+void PointHistogram::merge(const PointHistogram &other)
+{
+    if (other.runs == 0)
+        return;
+    cover(other.getMin());
+    cover(other.getMax());
+    for (size_t i = 0; i < other.counts.size(); ++i)
+    {
+        counts[other.lowest + (int) i - lowest] += other.counts[i];
+    }
+    runs += other.runs;
+}
+
+uint64_t PointHistogram::getRuns() const
+{
+    return runs;
+}
+
+int PointHistogram::getMin() const
+{
+    return lowest;
+}
+
+int PointHistogram::getMax() const
+{
+    return lowest + (int) counts.size() - 1;
+}
+
+uint64_t PointHistogram::getCount(int points) const
+{
+    if (points < lowest || points - lowest >= (int) counts.size())
+        return 0;
+    return counts[points - lowest];
+}
+
+double PointHistogram::mean() const
+{
+    if (runs == 0)
+        return 0;
+    double sum = 0;
+    for (size_t i = 0; i < counts.size(); ++i)
+    {
+        sum += (double) counts[i] * (lowest + (int) i);
+    }
+    return sum / (double) runs;
+}
+
+int PointHistogram::percentile(double fraction) const
+{
+    if (runs == 0)
+        return 0;
+    uint64_t rank = (uint64_t) std::ceil(fraction * (double) runs);
+    if (rank == 0)
+        rank = 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i)
+    {
+        seen += counts[i];
+        if (seen >= rank)
+            return lowest + (int) i;
+    }
+    return getMax();
+}
+
+SimulationConfig defaultSimulationConfig()
+{
+    SimulationConfig config;
+    config.runs = 1000;
+    config.events = 100;
+    config.buyChance = 0;
+    config.seed = 1;
+    config.threads = 0;
+    config.runsPerTask = 16;
+    return config;
+}
+
+void SimulationResult::merge(const SimulationResult &other)
+{
+    runs += other.runs;
+    matchesPlayed += other.matchesPlayed;
+    matchesFailed += other.matchesFailed;
+    buys += other.buys;
+    for (size_t i = 0; i < teams.size(); ++i)
+    {
+        teams[i].points.merge(other.teams[i].points);
+        teams[i].bought += other.teams[i].bought;
+    }
+}
+
+const TeamOutcome *SimulationResult::find(int teamId) const
+{
+    std::vector<TeamOutcome>::const_iterator it = std::lower_bound(
+            teams.begin(), teams.end(), teamId,
+            [](const TeamOutcome &team, int id) { return team.teamId < id; });
+    if (it == teams.end() || it->teamId != teamId)
+        return nullptr;
+    return &*it;
+}
+
+void SimulationResult::print(std::ostream &os) const
+{
+    std::ios::fmtflags flags = os.flags();
+    std::streamsize precision = os.precision();
+    os << runs << " runs, " << matchesPlayed << " matches played, " << matchesFailed << " failed, "
+       << buys << " buys\n";
+    os << std::setw(10) << "team" << std::setw(8) << "start" << std::setw(10) << "bought %"
+       << std::setw(10) << "mean" << std::setw(8) << "p10" << std::setw(8) << "p50" << std::setw(8) << "p90"
+       << std::setw(8) << "max" << "\n";
+    for (size_t i = 0; i < teams.size(); ++i)
+    {
+        const TeamOutcome &team = teams[i];
+        os << std::setw(10) << team.teamId << std::setw(8) << team.startPoints
+           << std::fixed << std::setprecision(1)
+           << std::setw(10) << (runs > 0 ? 100.0 * (double) team.bought / (double) runs : 0.0)
+           << std::setw(10) << team.points.mean();
+        if (team.points.getRuns() > 0)
+        {
+            os << std::setw(8) << team.points.percentile(0.1) << std::setw(8) << team.points.percentile(0.5)
+               << std::setw(8) << team.points.percentile(0.9) << std::setw(8) << team.points.getMax();
+        }
+        os << "\n";
+    }
+    os.flags(flags);
+    os.precision(precision);
+}
+
+Simulator::Simulator(world_cup_t &league) : ownsImage(true)
+{
+    char path[] = "/tmp/wc_simulatorXXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0)
+        throw ImageError();
+    close(fd);
+    imagePath = path;
+
+    if (league.saveSnapshot(path) != StatusType::SUCCESS)
+    {
+        std::remove(path);
+        throw ImageError();
+    }
+    try
+    {
+        readTeams();
+    }
+    catch (...)
+    {
+        std::remove(path);
+        throw;
+    }
+}
+
+Simulator::Simulator(const char *imagePath) : imagePath(imagePath), ownsImage(false)
+{
+    readTeams();
+}
+
+Simulator::~Simulator()
+{
+    if (ownsImage)
+        std::remove(imagePath.c_str());
+}
+
+void Simulator::readTeams()
+{
+    world_cup_t *world = fork();
+    if (world == nullptr)
+        throw ImageError();
+
+    // (id, points) pairs, sorted by id after the walk
+    std::vector<std::pair<int, int> > teams;
+    try
+    {
+        world->forEachTeamByAbility(0, [&teams](const Team &team)
+        {
+            teams.push_back(std::make_pair(team.getId(), team.getPoints()));
+            return true;
+        });
+    }
+    catch (...)
+    {
+        delete world;
+        throw;
+    }
+    delete world;
+
+    std::sort(teams.begin(), teams.end());
+    for (size_t i = 0; i < teams.size(); ++i)
+    {
+        teamIds.push_back(teams[i].first);
+        startPoints.push_back(teams[i].second);
+    }
+}
+
+world_cup_t *Simulator::fork() const
+{
+    return world_cup_t::loadSnapshot(imagePath.c_str());
+}
+
+const std::vector<int> &Simulator::getTeamIds() const
+{
+    return teamIds;
+}
+
+void Simulator::simulate(const SimulationConfig &config, int first, int count, SimulationResult &result) const
+{
+    std::vector<int> live;
+    for (int run = first; run < first + count; ++run)
+    {
+        world_cup_t *world = fork();
+        if (world == nullptr)
+            throw std::bad_alloc();
+
+        Random random(config.seed, (uint64_t) run);
+        live = teamIds;
+        for (int event = 0; event < config.events && live.size() >= 2; ++event)
+        {
+            int i = random.below((int) live.size());
+            int j = random.below((int) live.size() - 1);
+            if (j >= i)
+                j++;
+
+            if (random.chance(config.buyChance))
+            {
+                if (world->buy_team(live[i], live[j]) == StatusType::SUCCESS)
+                {
+                    result.buys++;
+                    live[j] = live.back();
+                    live.pop_back();
+                }
+            }
+            else if (world->play_match(live[i], live[j]).status() == StatusType::SUCCESS)
+            {
+                result.matchesPlayed++;
+            }
+            else
+            {
+                result.matchesFailed++;
+            }
+        }
+
+        for (size_t k = 0; k < teamIds.size(); ++k)
+        {
+            output_t<int> points = world->get_team_points(teamIds[k]);
+            if (points.status() == StatusType::SUCCESS)
+                result.teams[k].points.add(points.ans());
+            else
+                result.teams[k].bought++;
+        }
+        result.runs++;
+        delete world;
+    }
+}
+
+SimulationResult Simulator::run(const SimulationConfig &config) const
+{
+    SimulationResult empty;
+    empty.runs = 0;
+    empty.matchesPlayed = 0;
+    empty.matchesFailed = 0;
+    empty.buys = 0;
+    for (size_t i = 0; i < teamIds.size(); ++i)
+    {
+        TeamOutcome team;
+        team.teamId = teamIds[i];
+        team.startPoints = startPoints[i];
+        team.bought = 0;
+        empty.teams.push_back(team);
+    }
+
+    int perTask = std::max(config.runsPerTask, 1);
+    int tasks = (config.runs + perTask - 1) / perTask;
+    // one result per task, merged in order once all are done
+    std::vector<SimulationResult> partial(tasks, empty);
+    {
+        WorkStealingPool pool(config.threads);
+        for (int task = 0; task < tasks; ++task)
+        {
+            int first = task * perTask;
+            int count = std::min(perTask, config.runs - first);
+            SimulationResult *slot = &partial[task];
+            pool.submit([this, &config, first, count, slot]()
+                        {
+                            simulate(config, first, count, *slot);
+                        });
+        }
+        pool.wait();
+    }
+
+    SimulationResult result = empty;
+    for (int task = 0; task < tasks; ++task)
+    {
+        result.merge(partial[task]);
+    }
+    return result;
+}
@@ -0,0 +1,137 @@
+#ifndef TOOLS_SIMULATOR_H_
+#define TOOLS_SIMULATOR_H_
+
+/*
+ * Monte Carlo "what if" runs over a Wet2 league. The league is saved once as a snapshot image and
+ * every run forks its own world from it with world_cup_t::loadSnapshot: the image is mapped copy on
+ * write, only its header and teams are checked and created up front, and a player record is
+ * checked the first time a run looks it up. A fork costs O(teams) no matter how many players there
+ * are, and runs share every page they do not write. Each run plays a random fixture
+ * list with random buy_team events and the final points of every team are gathered into per team
+ * histograms. Runs are spread over a WorkStealingPool, run i always draws the same random numbers,
+ * so the result does not depend on the number of threads.
+ */
+
+#include "worldcup23a2.h"
+
+#include <cstdint>
+#include <exception>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Count of runs per final points value
+class PointHistogram
+{
+public:
+    PointHistogram();
+
+    void add(int points);
+    void merge(const PointHistogram &other);
+
+    uint64_t getRuns() const;
+    int getMin() const;
+    int getMax() const;
+    uint64_t getCount(int points) const;
+    double mean() const;
+
+    /**
+     * @param fraction - in [0, 1]
+     * @return the lowest points value with at least that fraction of the runs at or below it, 0 if empty
+     */
+    int percentile(double fraction) const;
+
+private:
+    int lowest; // points of counts[0]
+    std::vector<uint64_t> counts;
+    uint64_t runs;
+
+    // widens counts to take points
+    void cover(int points);
+};
+
+struct TeamOutcome
+{
+    int teamId;
+    int startPoints;
+    PointHistogram points; // of the runs the team was still in at the end
+    uint64_t bought;       // runs in which another team bought it
+};
+
+struct SimulationConfig
+{
+    int runs;
+    int events;          // play_match / buy_team calls per run
+    double buyChance;    // chance of an event being buy_team rather than play_match
+    uint64_t seed;
+    int threads;         // 0 - one per hardware thread
+    int runsPerTask;     // runs a pool task simulates back to back
+};
+
+// A config with the defaults: 1000 runs of 100 events, no buys, all hardware threads
+SimulationConfig defaultSimulationConfig();
+
+class SimulationResult
+{
+public:
+    uint64_t runs;
+    uint64_t matchesPlayed;
+    uint64_t matchesFailed;  // play_match that did not return SUCCESS, e.g. a team without a goal keeper
+    uint64_t buys;
+    std::vector<TeamOutcome> teams; // by id
+
+    void merge(const SimulationResult &other);
+
+    // nullptr if the team was not in the league
+    const TeamOutcome *find(int teamId) const;
+
+    // the totals and a row per team: start points, bought %, mean / p10 / p50 / p90 / max points
+    void print(std::ostream &os) const;
+};
+
+class Simulator
+{
+public:
+    /**
+     * Saves the league to a temporary snapshot image, removed with the simulator.
+     * @param league - read only here, later changes to it are not seen
+     */
+    explicit Simulator(world_cup_t &league);
+
+    /**
+     * Simulates from an existing snapshot image file, which is left in place.
+     * @param imagePath
+     */
+    explicit Simulator(const char *imagePath);
+
+    ~Simulator();
+    Simulator(const Simulator &) = delete;
+    Simulator &operator=(const Simulator &) = delete;
+
+    /**
+     * A new world in the state of the league, owned by the caller. Maps the image again, in O(teams),
+     * the constructor already made sure it loads.
+     * @return nullptr if memory runs out
+     */
+    world_cup_t *fork() const;
+
+    SimulationResult run(const SimulationConfig &config) const;
+
+    // the league's teams, by id
+    const std::vector<int> &getTeamIds() const;
+
+    class ImageError : public std::exception {};
+
+private:
+    std::string imagePath;
+    bool ownsImage;
+    std::vector<int> teamIds;
+    std::vector<int> startPoints;
+
+    void readTeams();
+
+    // runs [first, first + count) into result, which already lists the teams
+    void simulate(const SimulationConfig &config, int first, int count, SimulationResult &result) const;
+};
+
+#endif //TOOLS_SIMULATOR_H_
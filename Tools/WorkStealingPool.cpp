@@ -0,0 +1,158 @@
+#include "WorkStealingPool.h"
+
+namespace
+{
+    thread_local int workerIndex = -1;
+}
+
+WorkStealingPool::WorkStealingPool(int threads) :
+        queued(0), pending(0), stopping(false), nextQueue(0), steals(0)
+{
+    if (threads <= 0)
+        threads = (int) std::thread::hardware_concurrency();
+    if (threads <= 0)
+        threads = 1;
+
+    for (int i = 0; i < threads; ++i)
+    {
+        queues.push_back(new Queue());
+    }
+    for (int i = 0; i < threads; ++i)
+    {
+        workers.push_back(std::thread(&WorkStealingPool::run, this, i));
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::unique_lock<std::mutex> lock(stateMutex);
+        allDone.wait(lock, [this]() { return pending == 0; });
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (size_t i = 0; i < workers.size(); ++i)
+    {
+        workers[i].join();
+    }
+    for (size_t i = 0; i < queues.size(); ++i)
+    {
+        delete queues[i];
+    }
+}
+
+void WorkStealingPool::submit(Task task)
+{
+    int index = workerIndex;
+    if (index < 0)
+        index = (int) (nextQueue++ % queues.size());
+
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        queued++;
+        pending++;
+    }
+    workAvailable.notify_one();
+}
+
+void WorkStealingPool::wait()
+{
+    std::unique_lock<std::mutex> lock(stateMutex);
+    allDone.wait(lock, [this]() { return pending == 0; });
+    if (failure)
+    {
+        std::exception_ptr error = failure;
+        failure = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+int WorkStealingPool::getThreadCount() const
+{
+    return (int) workers.size();
+}
+
+uint64_t WorkStealingPool::getSteals() const
+{
+    return steals;
+}
+
+int WorkStealingPool::currentWorker()
+{
+    return workerIndex;
+}
+
+bool WorkStealingPool::take(int index, Task &task)
+{
+    {
+        Queue &own = *queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    int count = (int) queues.size();
+    for (int i = 1; i < count; ++i)
+    {
+        Queue &victim = *queues[(index + i) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            steals++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::finished(std::exception_ptr error)
+{
+    std::lock_guard<std::mutex> lock(stateMutex);
+    if (error && !failure)
+        failure = error;
+    if (--pending == 0)
+        allDone.notify_all();
+}
+
+void WorkStealingPool::run(int index)
+{
+    workerIndex = index;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(stateMutex);
+            workAvailable.wait(lock, [this]() { return stopping || queued > 0; });
+            if (queued == 0)
+                return;
+            // claims one queued task, which take() is then sure to find in some deque
+            queued--;
+        }
+
+        Task task;
+        while (!take(index, task))
+        {
+            std::this_thread::yield();
+        }
+
+        std::exception_ptr error;
+        try
+        {
+            task();
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+        finished(error);
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef TOOLS_WORK_STEALING_POOL_H_
+#define TOOLS_WORK_STEALING_POOL_H_
+
+/*
+ * Fixed set of worker threads, each with its own deque of tasks. A worker takes the newest task of
+ * its own deque and, when that is empty, steals the oldest task of another worker's, so uneven
+ * tasks even out without every worker contending on one shared queue. Tasks submitted from outside
+ * the pool are dealt round robin, tasks submitted by a worker go to its own deque.
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkStealingPool
+{
+public:
+    typedef std::function<void()> Task;
+
+    /**
+     * @param threads - the number of workers, 0 - one per hardware thread
+     */
+    explicit WorkStealingPool(int threads = 0);
+
+    // waits for the submitted tasks, then stops the workers
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    void submit(Task task);
+
+    /**
+     * Blocks until every submitted task has run. The first exception a task threw since the last
+     * wait is rethrown here, the other tasks still run.
+     */
+    void wait();
+
+    int getThreadCount() const;
+
+    // tasks taken from another worker's deque
+    uint64_t getSteals() const;
+
+    // index of the calling worker, -1 outside the pool
+    static int currentWorker();
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<Queue *> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex stateMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable allDone;
+    long queued;   // in some deque, guarded by stateMutex
+    long pending;  // submitted and not finished yet, guarded by stateMutex
+    bool stopping;
+    std::exception_ptr failure;
+
+    std::atomic<unsigned> nextQueue;
+    std::atomic<uint64_t> steals;
+
+    void run(int index);
+    bool take(int index, Task &task);
+    void finished(std::exception_ptr error);
+};
+
+#endif //TOOLS_WORK_STEALING_POOL_H_
@@ -0,0 +1,211 @@
+#include "WriteAheadLog.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    bool writeAll(int fd, const char *data, size_t size)
+    {
+        while (size > 0)
+        {
+            ssize_t written = ::write(fd, data, size);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            data += written;
+            size -= (size_t) written;
+        }
+        return true;
+    }
+}
+
+WriteAheadLog::WriteAheadLog() :
+    fd(-1), target(0), pending(nullptr), pendingCount(0), capacity(0), groupSize(0),
+    maxDelay(std::chrono::microseconds::zero()), appended(0), durable(0), syncCount(0)
+{}
+
+WriteAheadLog::~WriteAheadLog()
+{
+    close();
+}
+
+bool WriteAheadLog::open(const char *path, int target, int groupSize, std::chrono::microseconds maxDelay)
+{
+    close();
+    fd = ::open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+
+    OpLogHeader header;
+    bool ok;
+    if (info.st_size == 0)
+    {
+        initOpLogHeader(header, target);
+        ok = writeAll(fd, reinterpret_cast<const char *>(&header), sizeof(header)) && fdatasync(fd) == 0;
+        durable = 0;
+    }
+    else
+    {
+        ssize_t read = pread(fd, &header, sizeof(header), 0);
+        size_t headerSize = read > 0 ? checkOpLogHeader(header, (size_t) read) : 0;
+        ok = headerSize != 0 && header.target == target;
+        // the tail of a group cut by a crash is dropped, appends go right after the last whole record
+        uint64_t records = ok ? (uint64_t) (info.st_size - (off_t) headerSize) / sizeof(OpRecord) : 0;
+        ok = ok && ftruncate(fd, (off_t) (headerSize + records * sizeof(OpRecord))) == 0;
+        durable = ok ? header.baseSequence + records : 0;
+    }
+    ok = ok && lseek(fd, 0, SEEK_END) >= 0;
+    if (!ok)
+    {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+
+    this->path = path;
+    this->target = target;
+    this->groupSize = groupSize;
+    this->maxDelay = maxDelay;
+    capacity = (groupSize > 0) ? groupSize : UNGROUPED_CAPACITY;
+    pending = new OpRecord[capacity];
+    pendingCount = 0;
+    appended = durable;
+    syncCount = 0;
+    return true;
+}
+
+bool WriteAheadLog::append(const OpRecord &record)
+{
+    if (fd < 0)
+        return false;
+
+    if (appended == durable)
+        oldestPending = std::chrono::steady_clock::now();
+    pending[pendingCount++] = record;
+    appended++;
+
+    if (groupSize > 0 && pendingCount >= groupSize)
+        return sync();
+    if (timeUntilDue() == std::chrono::microseconds::zero())
+        return sync();
+    if (pendingCount == capacity)
+        return writePending();
+    return true;
+}
+
+std::chrono::microseconds WriteAheadLog::timeUntilDue() const
+{
+    // records already written by writePending wait for their sync too
+    if (appended == durable || maxDelay <= std::chrono::microseconds::zero())
+        return std::chrono::microseconds::max();
+    std::chrono::microseconds waited =
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - oldestPending);
+    return (waited >= maxDelay) ? std::chrono::microseconds::zero() : maxDelay - waited;
+}
+
+bool WriteAheadLog::writePending()
+{
+    if (pendingCount == 0)
+        return true;
+    bool ok = writeAll(fd, reinterpret_cast<const char *>(pending), pendingCount * sizeof(OpRecord));
+    pendingCount = 0;
+    return ok;
+}
+
+bool WriteAheadLog::sync()
+{
+    if (fd < 0)
+        return false;
+    if (appended == durable)
+        return true;
+
+    bool ok = writePending() && fdatasync(fd) == 0;
+    if (ok)
+    {
+        durable = appended;
+        syncCount++;
+    }
+    return ok;
+}
+
+bool WriteAheadLog::rotate()
+{
+    if (fd < 0 || !sync())
+        return false;
+
+    std::string tempPath = path + ".tmp";
+    int rotated = ::open(tempPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (rotated < 0)
+        return false;
+    OpLogHeader header;
+    initOpLogHeader(header, target);
+    header.baseSequence = appended;
+    bool ok = writeAll(rotated, reinterpret_cast<const char *>(&header), sizeof(header)) &&
+              fdatasync(rotated) == 0 && std::rename(tempPath.c_str(), path.c_str()) == 0;
+    if (!ok)
+    {
+        ::close(rotated);
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    ::close(fd);
+    fd = rotated;
+    syncDirectoryOf(path.c_str());
+    return true;
+}
+
+bool WriteAheadLog::syncDirectoryOf(const char *path)
+{
+    std::string directory(path);
+    size_t slash = directory.find_last_of('/');
+    directory = (slash == std::string::npos) ? "." : (slash == 0 ? "/" : directory.substr(0, slash));
+    int dirFd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dirFd < 0)
+        return false;
+    bool ok = fsync(dirFd) == 0;
+    ::close(dirFd);
+    return ok;
+}
+
+bool WriteAheadLog::close()
+{
+    if (fd < 0)
+        return true;
+    bool ok = sync();
+    ok = (::close(fd) == 0) && ok;
+    fd = -1;
+    delete[] pending;
+    pending = nullptr;
+    pendingCount = 0;
+    return ok;
+}
+
+uint64_t WriteAheadLog::getSequence() const
+{
+    return appended;
+}
+
+uint64_t WriteAheadLog::getDurableSequence() const
+{
+    return durable;
+}
+
+uint64_t WriteAheadLog::getSyncCount() const
+{
+    return syncCount;
+}
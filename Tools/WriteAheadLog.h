@@ -0,0 +1,108 @@
+#ifndef TOOLS_WRITE_AHEAD_LOG_H_
+#define TOOLS_WRITE_AHEAD_LOG_H_
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include "OpLog.h"
+
+/*
+ * Append-only log of the mutating commands, together with the outcome each had when it ran.
+ *
+ * The file is an ordinary op log (OpLogHeader + OpRecord[]), so it can be replayed or converted
+ * with the other tools. A record's sequence is the header's baseSequence plus its index in the file,
+ * and a snapshot saved after applying the first n records carries sequence n - recovery replays the
+ * records from there. Once such a snapshot is durable the log can be rotated: it starts over empty,
+ * with baseSequence n.
+ *
+ * Group commit: records are collected in memory and written with a single write + fdatasync once
+ * groupSize records are pending, or once the oldest pending record waited maxDelay. Records of a
+ * group that was not committed yet are lost on a crash; groupSize 1 makes every append durable.
+ */
+class WriteAheadLog
+{
+public:
+    WriteAheadLog();
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog &) = delete;
+    WriteAheadLog &operator=(const WriteAheadLog &) = delete;
+
+    /**
+     * Opens a log for appending, creating it if it does not exist.
+     * A trailing partial record (torn write) of an existing log is cut off.
+     * @param path
+     * @param target - 1 or 2, has to match an existing log
+     * @param groupSize - records per commit, 0 - commit only on sync() and close()
+     * @param maxDelay - commit when the oldest pending record is older than this, zero - no limit
+     * @return false if the file could not be opened or belongs to another target
+     */
+    bool open(const char *path, int target, int groupSize,
+              std::chrono::microseconds maxDelay = std::chrono::microseconds::zero());
+
+    /**
+     * Appends a record, committing the pending group when it is full or too old.
+     * @param record
+     * @return false on a write error
+     */
+    bool append(const OpRecord &record);
+
+    /**
+     * Time left until the pending group is due.
+     * @return zero if it is due, microseconds::max() with nothing pending or without maxDelay
+     */
+    std::chrono::microseconds timeUntilDue() const;
+
+    /**
+     * Writes and syncs every pending record.
+     * @return false on a write error
+     */
+    bool sync();
+
+    /**
+     * Starts the log over, for once a snapshot of everything appended is durable. The pending records
+     * are synced, then an empty log that continues at the same sequence is renamed over the file, so a
+     * crash leaves either the old or the new log - both consistent with the snapshot.
+     * @return false on a write error, the old log is kept then
+     */
+    bool rotate();
+
+    /**
+     * Syncs the directory of path, so a file renamed into it survives a crash.
+     * @param path
+     * @return false if the directory could not be synced
+     */
+    static bool syncDirectoryOf(const char *path);
+
+    /**
+     * Syncs the pending records and closes the file.
+     * @return false on a write error
+     */
+    bool close();
+
+    // records in the log, including the pending ones
+    uint64_t getSequence() const;
+    // records that survive a crash
+    uint64_t getDurableSequence() const;
+    uint64_t getSyncCount() const;
+
+private:
+    int fd;
+    std::string path;
+    int target;
+    OpRecord *pending;
+    int pendingCount;
+    int capacity;
+    int groupSize;
+    std::chrono::microseconds maxDelay;
+    std::chrono::steady_clock::time_point oldestPending;
+    uint64_t appended;
+    uint64_t durable;
+    uint64_t syncCount;
+
+    static const int UNGROUPED_CAPACITY = 4096;
+
+    bool writePending();
+};
+
+#endif //TOOLS_WRITE_AHEAD_LOG_H_
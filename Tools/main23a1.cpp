@@ -0,0 +1,10 @@
+//
+// Command driver for Wet1 - reads text commands, can record and replay binary op logs.
+//
+
+#include "Commands23a1.h"
+
+int main(int argc, char **argv)
+{
+    return runDriver<world_cup_t>(argc, argv, 1, wet1::apply);
+}
@@ -0,0 +1,10 @@
+//
+// Command driver for Wet2 - reads text commands, can record and replay binary op logs.
+//
+
+#include "Commands23a2.h"
+
+int main(int argc, char **argv)
+{
+    return runDriver<world_cup_t>(argc, argv, 2, wet2::apply);
+}
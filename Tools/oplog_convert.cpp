@@ -0,0 +1,85 @@
+//
+// Converts text command files into binary op logs and back.
+//
+//   oplog_convert --wet1|--wet2 <commands.txt> <log.bin>
+//   oplog_convert --to-text <log.bin>
+//
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "OpLog.h"
+
+namespace
+{
+    int toBinary(int target, const char *inPath, const char *outPath)
+    {
+        std::ifstream in(inPath);
+        if (!in)
+        {
+            std::cerr << inPath << ": cannot read" << std::endl;
+            return 1;
+        }
+        OpLogWriter writer;
+        if (!writer.open(outPath, target))
+        {
+            std::cerr << outPath << ": cannot write" << std::endl;
+            return 1;
+        }
+
+        std::string line;
+        OpRecord record;
+        long lineNumber = 0, converted = 0, rejected = 0;
+        while (std::getline(in, line))
+        {
+            lineNumber++;
+            if (line.find_first_not_of(" \t\r") == std::string::npos)
+                continue;
+            if (!parseTextCommand(line, target, record))
+            {
+                std::cerr << inPath << ":" << lineNumber << ": bad command: " << line << std::endl;
+                rejected++;
+                continue;
+            }
+            writer.append(record);
+            converted++;
+        }
+
+        if (!writer.close())
+        {
+            std::cerr << outPath << ": write failed" << std::endl;
+            return 1;
+        }
+        std::cerr << converted << " commands converted, " << rejected << " rejected" << std::endl;
+        return rejected == 0 ? 0 : 1;
+    }
+
+    int toText(const char *inPath)
+    {
+        OpLogReader reader;
+        if (!reader.open(inPath))
+        {
+            std::cerr << inPath << ": not an op log" << std::endl;
+            return 1;
+        }
+        const OpRecord *records = reader.getRecords();
+        for (size_t i = 0; i < reader.getCount(); ++i)
+            std::cout << formatTextCommand(records[i], reader.getTarget()) << '\n';
+        return 0;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc == 4 && std::strcmp(argv[1], "--wet1") == 0)
+        return toBinary(1, argv[2], argv[3]);
+    if (argc == 4 && std::strcmp(argv[1], "--wet2") == 0)
+        return toBinary(2, argv[2], argv[3]);
+    if (argc == 3 && std::strcmp(argv[1], "--to-text") == 0)
+        return toText(argv[2]);
+
+    std::cerr << "usage: " << argv[0] << " --wet1|--wet2 <commands.txt> <log.bin>" << std::endl
+              << "       " << argv[0] << " --to-text <log.bin>" << std::endl;
+    return 2;
+}
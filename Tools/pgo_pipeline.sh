@@ -0,0 +1,107 @@
+#!/usr/bin/env bash
+
+# Profile guided optimization pipeline:
+#   1. a plain build, used for the trace tools and as the untrained baseline
+#   2. training and evaluation traces are generated and recorded into op logs
+#   3. an instrumented build replays the training logs, writing the profiles
+#   4. an optimized build uses the profiles
+#   5. both builds replay the evaluation logs and run the benchmarks, report.md compares them
+#
+# usage: Tools/pgo_pipeline.sh [work-dir] [training ops]
+# extra cmake arguments for all three builds can be passed in CMAKE_ARGS, e.g. CMAKE_ARGS="-DWC_NATIVE=ON"
+
+set -e
+
+root=$(cd "$(dirname "$0")/.." && pwd)
+work=$(mkdir -p "${1:-$root/pgo-work}" && cd "${1:-$root/pgo-work}" && pwd)
+ops=${2:-2000000}
+bench_args=(--sizes 10000,100000 --dist uniform,zipf --ops 50000 --csv)
+jobs=$(nproc 2>/dev/null || echo 2)
+
+configure_and_build() {
+    cmake -S "$root" -B "$work/$1" -DWC_BUILD_TESTS=OFF $CMAKE_ARGS "${@:2}" > /dev/null
+    cmake --build "$work/$1" -j"$jobs" > /dev/null
+}
+
+echo "building baseline"
+configure_and_build build-base -DWC_PGO=
+
+echo "recording traces ($ops training ops)"
+for wet in 1 2
+do
+    "$work/build-base/trace_gen" --wet$wet "$ops" 1 > "$work/train$wet.txt"
+    "$work/build-base/trace_gen" --wet$wet "$ops" 2 > "$work/eval$wet.txt"
+    "$work/build-base/main23a$wet" --record "$work/train$wet.bin" < "$work/train$wet.txt" > /dev/null
+    "$work/build-base/main23a$wet" --record "$work/eval$wet.bin" < "$work/eval$wet.txt" > /dev/null
+done
+
+echo "training"
+rm -rf "$work/profiles"
+configure_and_build build-train -DWC_PGO=generate -DWC_PGO_DIR="$work/profiles"
+for wet in 1 2
+do
+    "$work/build-train/main23a$wet" --replay "$work/train$wet.bin" > /dev/null
+done
+if [ -n "$(ls "$work/profiles"/*.profraw 2> /dev/null)" ]
+then
+    # clang writes raw profiles that have to be merged first
+    llvm-profdata merge -o "$work/profiles/default.profdata" "$work/profiles"/*.profraw
+fi
+
+echo "building with the profiles"
+configure_and_build build-pgo -DWC_PGO=use -DWC_PGO_DIR="$work/profiles"
+
+echo "measuring"
+for build in base pgo
+do
+    for wet in 1 2
+    do
+        rm -f "$work/replay-$build$wet.txt"
+        for run in 1 2 3 4 5
+        do
+            "$work/build-$build/main23a$wet" --replay "$work/eval$wet.bin" >> "$work/replay-$build$wet.txt"
+        done
+        "$work/build-$build/bench23a$wet" "${bench_args[@]}" > "$work/bench-$build$wet.csv"
+    done
+done
+
+# best ops/s of the runs, from "replayed N ops in S s (X ops/s), M mismatches"
+replay_rate() {
+    sed -n 's/.*(\([0-9.e+]*\) ops\/s).*/\1/p' "$1" | sort -g | tail -1
+}
+
+{
+    echo "# PGO report"
+    echo
+    echo "Trained on $ops ops per exercise (seed 1), evaluated on a different trace (seed 2)."
+    echo "Replays are the best of 5 runs, benchmark rows a single run - rerun on a quiet machine before"
+    echo "reading much into differences of a few percent."
+    echo
+    echo "## Op log replay"
+    echo
+    echo "| exercise | untrained ops/s | trained ops/s | speedup |"
+    echo "|----------|-----------------|---------------|---------|"
+    for wet in 1 2
+    do
+        base=$(replay_rate "$work/replay-base$wet.txt")
+        pgo=$(replay_rate "$work/replay-pgo$wet.txt")
+        awk -v wet="$wet" -v base="$base" -v pgo="$pgo" \
+            'BEGIN { printf "| Wet%s | %.0f | %.0f | %.2fx |\n", wet, base, pgo, pgo / base }'
+    done
+    for wet in 1 2
+    do
+        echo
+        echo "## bench23a$wet (ns/op)"
+        echo
+        echo "| operation | size | dist | untrained | trained | speedup |"
+        echo "|-----------|------|------|-----------|---------|---------|"
+        awk -F, 'FNR == 1 { next }
+                 NR == FNR { base[$1 "," $2 "," $3] = $5; next }
+                 ($1 "," $2 "," $3) in base {
+                     old = base[$1 "," $2 "," $3]
+                     printf "| %s | %s | %s | %.1f | %.1f | %.2fx |\n", $1, $2, $3, old, $5, ($5 > 0 ? old / $5 : 0)
+                 }' "$work/bench-base$wet.csv" "$work/bench-pgo$wet.csv"
+    done
+} > "$work/report.md"
+
+cat "$work/report.md"
@@ -0,0 +1,88 @@
+//
+// Monte Carlo simulator for Wet2 - builds a league from text commands (or takes a snapshot image),
+// then runs random fixture lists with buy_team events over it and prints per team point histograms.
+//
+
+#include "Commands23a2.h"
+#include "Simulator.h"
+
+#include <chrono>
+
+namespace
+{
+    void printUsage(const char *program)
+    {
+        std::cerr << "usage: " << program << " [--image <snapshot>] [--runs <n>] [--events <n>] [--buy <chance>]"
+                  << " [--threads <n>] [--seed <n>] [--tasks <runs per task>] [< commands.txt]" << std::endl;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *imagePath = nullptr;
+    SimulationConfig config = defaultSimulationConfig();
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--image") == 0 && i + 1 < argc)
+            imagePath = argv[++i];
+        else if (std::strcmp(argv[i], "--runs") == 0 && i + 1 < argc)
+            config.runs = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--events") == 0 && i + 1 < argc)
+            config.events = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--buy") == 0 && i + 1 < argc)
+            config.buyChance = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            config.threads = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            config.seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--tasks") == 0 && i + 1 < argc)
+            config.runsPerTask = std::atoi(argv[++i]);
+        else
+        {
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+
+    Simulator *simulator;
+    try
+    {
+        if (imagePath != nullptr)
+        {
+            simulator = new Simulator(imagePath);
+        }
+        else
+        {
+            world_cup_t league;
+            std::string line;
+            OpRecord record;
+            while (std::getline(std::cin, line))
+            {
+                if (line.find_first_not_of(" \t\r") == std::string::npos)
+                    continue;
+                if (!parseTextCommand(line, 2, record))
+                {
+                    std::cerr << "bad command: " << line << std::endl;
+                    continue;
+                }
+                wet2::apply(league, record, nullptr);
+            }
+            simulator = new Simulator(league);
+        }
+    }
+    catch (const Simulator::ImageError &e)
+    {
+        std::cerr << (imagePath != nullptr ? imagePath : "league") << ": cannot use as a snapshot image" << std::endl;
+        return 1;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    SimulationResult result = simulator->run(config);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    result.print(std::cout);
+    std::cerr << result.runs << " runs in " << elapsed.count() << " s ("
+              << (elapsed.count() > 0 ? (double) result.runs / elapsed.count() : 0.0) << " runs/s)" << std::endl;
+    delete simulator;
+    return 0;
+}
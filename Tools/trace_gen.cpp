@@ -0,0 +1,232 @@
+//
+// Generates representative command traces (text, the course input format) for training and evaluation.
+//
+// usage: trace_gen --wet1|--wet2 <ops> [seed]
+//
+// Wet2 traces are dominated by play_match and get_partial_spirit with bursts of buy_team,
+// Wet1 traces by play_match, update_player_stats and neighbour queries with bursts of unite_teams.
+// Both start by building the teams and players the rest of the trace operates on.
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+    class Generator
+    {
+    public:
+        Generator(int ops, unsigned seed) : ops(ops), random(seed), nextTeam(1), nextPlayer(1)
+        {}
+
+        int below(int limit)
+        {
+            return (limit <= 0) ? 0 : (int) (random() % (unsigned) limit);
+        }
+
+        // skewed towards the front - a few teams play most of the matches
+        int skewed(int limit)
+        {
+            int first = below(limit), second = below(limit);
+            return std::min(first, second);
+        }
+
+        void generateWet2()
+        {
+            int teamCount = std::max(8, ops / 400);
+            int playerCount = std::max(64, ops / 20);
+            std::vector<int> teams;
+            std::vector<int> players;
+
+            for (int i = 0; i < teamCount; ++i)
+                addTeam(teams, "add_team %d\n");
+            for (int i = 0; i < playerCount; ++i)
+                addPlayerWet2(teams, players);
+
+            int emitted = teamCount + playerCount;
+            while (emitted < ops)
+            {
+                int dice = below(1000);
+                if (dice < 450)
+                {
+                    std::printf("play_match %d %d\n", teams[skewed(teams.size())], teams[below(teams.size())]);
+                }
+                else if (dice < 800)
+                {
+                    std::printf("get_partial_spirit %d\n", players[skewed(players.size())]);
+                }
+                else if (dice < 850)
+                {
+                    std::printf("num_played_games_for_player %d\n", players[below(players.size())]);
+                }
+                else if (dice < 900)
+                {
+                    std::printf("add_player_cards %d %d\n", players[below(players.size())], 1 + below(3));
+                }
+                else if (dice < 930)
+                {
+                    std::printf("get_team_points %d\n", teams[below(teams.size())]);
+                }
+                else if (dice < 950)
+                {
+                    std::printf("get_ith_pointless_ability %d\n", below(teams.size()));
+                }
+                else if (dice < 995)
+                {
+                    addPlayerWet2(teams, players);
+                }
+                else
+                {
+                    // a burst of purchases, the league is refilled with new teams
+                    int burst = 5 + below(20);
+                    for (int i = 0; i < burst && teams.size() > 2; ++i)
+                    {
+                        int buyer = below(teams.size());
+                        int bought = below(teams.size());
+                        if (buyer == bought)
+                            continue;
+                        std::printf("buy_team %d %d\n", teams[buyer], teams[bought]);
+                        teams.erase(teams.begin() + bought);
+                        addTeam(teams, "add_team %d\n");
+                        emitted += 2;
+                    }
+                }
+                emitted++;
+            }
+        }
+
+        void generateWet1()
+        {
+            int teamCount = std::max(8, ops / 600);
+            int playerCount = teamCount * 14;
+            std::vector<int> teams;
+            std::vector<std::vector<int>> rosters;
+            std::vector<int> players;
+
+            for (int i = 0; i < teamCount; ++i)
+            {
+                addTeam(teams, "add_team %d 0\n");
+                rosters.push_back(std::vector<int>());
+            }
+            for (int i = 0; i < playerCount; ++i)
+                addPlayerWet1(teams, rosters, players, i % teamCount, i < teamCount);
+
+            int emitted = teamCount + playerCount;
+            while (emitted < ops)
+            {
+                int dice = below(1000);
+                int team = skewed(teams.size());
+                if (dice < 350)
+                {
+                    std::printf("play_match %d %d\n", teams[team], teams[below(teams.size())]);
+                }
+                else if (dice < 550)
+                {
+                    if (!rosters[team].empty())
+                        std::printf("update_player_stats %d 1 %d %d\n", rosters[team][below(rosters[team].size())],
+                                    below(3), below(2));
+                }
+                else if (dice < 650)
+                {
+                    std::printf("get_num_played_games %d\n", players[below(players.size())]);
+                }
+                else if (dice < 750)
+                {
+                    if (!rosters[team].empty())
+                        std::printf("get_closest_player %d %d\n", rosters[team][below(rosters[team].size())],
+                                    teams[team]);
+                }
+                else if (dice < 800)
+                {
+                    int low = teams[below(teams.size())];
+                    std::printf("knockout_winner %d %d\n", low, low + below(nextTeam / 4 + 1));
+                }
+                else if (dice < 850)
+                {
+                    std::printf("get_top_scorer %d\n", (dice % 2 == 0) ? -1 : teams[team]);
+                }
+                else if (dice < 900)
+                {
+                    std::printf("get_team_points %d\n", teams[team]);
+                }
+                else if (dice < 995)
+                {
+                    addPlayerWet1(teams, rosters, players, team, false);
+                }
+                else
+                {
+                    // a burst of mergers, the league is refilled with new teams
+                    int burst = 2 + below(6);
+                    for (int i = 0; i < burst && teams.size() > 2; ++i)
+                    {
+                        int first = below(teams.size());
+                        int second = below(teams.size());
+                        if (first == second)
+                            continue;
+                        std::printf("unite_teams %d %d %d\n", teams[first], teams[second], teams[first]);
+                        rosters[first].insert(rosters[first].end(), rosters[second].begin(), rosters[second].end());
+                        teams.erase(teams.begin() + second);
+                        rosters.erase(rosters.begin() + second);
+                        addTeam(teams, "add_team %d 0\n");
+                        rosters.push_back(std::vector<int>());
+                        emitted += 2;
+                    }
+                }
+                emitted++;
+            }
+        }
+
+    private:
+        int ops;
+        std::mt19937 random;
+        int nextTeam;
+        int nextPlayer;
+
+        void addTeam(std::vector<int> &teams, const char *format)
+        {
+            std::printf(format, nextTeam);
+            teams.push_back(nextTeam++);
+        }
+
+        void addPlayerWet2(const std::vector<int> &teams, std::vector<int> &players)
+        {
+            int spirit[5] = {1, 2, 3, 4, 5};
+            std::shuffle(spirit, spirit + 5, random);
+            std::printf("add_player %d %d %d,%d,%d,%d,%d %d %d %d %s\n", nextPlayer, teams[skewed(teams.size())],
+                        spirit[0], spirit[1], spirit[2], spirit[3], spirit[4],
+                        below(10), below(100) - 20, below(5), below(8) == 0 ? "true" : "false");
+            players.push_back(nextPlayer++);
+        }
+
+        void addPlayerWet1(const std::vector<int> &teams, std::vector<std::vector<int>> &rosters,
+                           std::vector<int> &players, int team, bool goalKeeper)
+        {
+            std::printf("add_player %d %d %d %d %d %s\n", nextPlayer, teams[team], 1 + below(10), below(20),
+                        below(4), (goalKeeper || below(10) == 0) ? "true" : "false");
+            rosters[team].push_back(nextPlayer);
+            players.push_back(nextPlayer++);
+        }
+    };
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3 || (std::strcmp(argv[1], "--wet1") != 0 && std::strcmp(argv[1], "--wet2") != 0))
+    {
+        std::fprintf(stderr, "usage: %s --wet1|--wet2 <ops> [seed]\n", argv[0]);
+        return 2;
+    }
+    int ops = std::atoi(argv[2]);
+    unsigned seed = (argc > 3) ? (unsigned) std::atoi(argv[3]) : 1;
+
+    Generator generator(ops, seed);
+    if (std::strcmp(argv[1], "--wet1") == 0)
+        generator.generateWet1();
+    else
+        generator.generateWet2();
+    return 0;
+}
@@ -0,0 +1,171 @@
+//
+// Write-ahead log throughput at different group commit sizes, and recovery from snapshot + log (Wet2).
+//
+// usage: wal_bench [ops] [directory]
+//
+
+#include "Commands23a2.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Mutating commands only - a log never holds anything else
+    std::vector<OpRecord> generateWorkload(int count)
+    {
+        std::mt19937 random(2023);
+        std::vector<OpRecord> records;
+        records.reserve(count);
+        int nextTeam = 1, nextPlayer = 1;
+
+        while ((int) records.size() < count)
+        {
+            OpRecord record = OpRecord();
+            record.expectedStatus = OpRecord::NO_EXPECTATION;
+            int dice = (int) (random() % 100);
+            int team1 = 1 + (int) (random() % nextTeam);
+            int team2 = 1 + (int) (random() % nextTeam);
+
+            if (nextTeam < 16 || dice < 5)
+            {
+                record.op = (uint8_t) OpCode::ADD_TEAM;
+                record.args[0] = nextTeam++;
+            }
+            else if (dice < 55)
+            {
+                record.op = (uint8_t) OpCode::ADD_PLAYER;
+                record.args[0] = nextPlayer++;
+                record.args[1] = team1;
+                record.spirit = (uint8_t) (random() % 120);
+                record.args[2] = (int) (random() % 10);
+                record.args[3] = (int) (random() % 100) - 20;
+                record.args[4] = (int) (random() % 5);
+                record.flags = (random() % 8 == 0) ? OpRecord::FLAG_GOAL_KEEPER : 0;
+            }
+            else if (dice < 80)
+            {
+                record.op = (uint8_t) OpCode::PLAY_MATCH;
+                record.args[0] = team1;
+                record.args[1] = team2;
+            }
+            else if (dice < 92)
+            {
+                record.op = (uint8_t) OpCode::ADD_PLAYER_CARDS;
+                record.args[0] = 1 + (int) (random() % nextPlayer);
+                record.args[1] = (int) (random() % 3);
+            }
+            else if (dice < 97)
+            {
+                record.op = (uint8_t) OpCode::BUY_TEAM;
+                record.args[0] = team1;
+                record.args[1] = team2;
+            }
+            else
+            {
+                record.op = (uint8_t) OpCode::REMOVE_TEAM;
+                record.args[0] = team1;
+            }
+            records.push_back(record);
+        }
+        return records;
+    }
+
+    // Order dependent summary of the observable state, to compare a recovered world with the original
+    int32_t stateChecksum(world_cup_t &world, const std::vector<OpRecord> &records)
+    {
+        std::vector<int> values;
+        for (const OpRecord &record : records)
+        {
+            if ((OpCode) record.op == OpCode::ADD_TEAM)
+            {
+                output_t<int> points = world.get_team_points(record.args[0]);
+                values.push_back(points.status() == StatusType::SUCCESS ? points.ans() : -1);
+            }
+            else if ((OpCode) record.op == OpCode::ADD_PLAYER)
+            {
+                output_t<int> games = world.num_played_games_for_player(record.args[0]);
+                output_t<int> cards = world.get_player_cards(record.args[0]);
+                values.push_back(games.status() == StatusType::SUCCESS ? games.ans() : -1);
+                values.push_back(cards.status() == StatusType::SUCCESS ? cards.ans() : -1);
+            }
+        }
+        return checksum(values.data(), (int) values.size());
+    }
+
+    double seconds(std::chrono::steady_clock::time_point start)
+    {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int count = (argc > 1) ? std::atoi(argv[1]) : 20000;
+    std::string directory = (argc > 2) ? argv[2] : ".";
+    std::string walPath = directory + "/wal_bench.wal";
+    std::string snapshotPath = directory + "/wal_bench.snap";
+
+    std::vector<OpRecord> records = generateWorkload(count);
+    const int GROUP_SIZES[] = {1, 4, 16, 64, 256, 1024, 0};
+
+    std::printf("%d mutating ops\n", count);
+    std::printf("%8s %12s %10s %10s %12s\n", "group", "ops/s", "us/op", "fsyncs", "recovered");
+
+    for (int groupSize : GROUP_SIZES)
+    {
+        std::remove(walPath.c_str());
+        std::remove(snapshotPath.c_str());
+
+        world_cup_t *world = new world_cup_t();
+        WriteAheadLog wal;
+        if (!wal.open(walPath.c_str(), 2, groupSize))
+        {
+            std::fprintf(stderr, "%s: cannot write\n", walPath.c_str());
+            return 1;
+        }
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int i = 0; i < count; ++i)
+        {
+            wal.append(records[i]);
+            wet2::apply(*world, records[i], nullptr);
+
+            // checkpoint half way, so recovery has to combine a snapshot with the rest of the log
+            if (i == count / 2)
+                world->saveSnapshot(snapshotPath.c_str(), wal.getSequence());
+        }
+        wal.close();
+        double elapsed = seconds(start);
+
+        uint64_t sequence = 0;
+        world_cup_t *recovered = recoverWorld<world_cup_t>(snapshotPath.c_str(), walPath.c_str(), 2,
+                                                           wet2::apply, &sequence);
+        bool same = recovered != nullptr && sequence == (uint64_t) count &&
+                    stateChecksum(*world, records) == stateChecksum(*recovered, records);
+
+        std::printf("%8s %12.0f %10.2f %10llu %12s\n",
+                    groupSize > 0 ? std::to_string(groupSize).c_str() : "close",
+                    count / elapsed, elapsed * 1e6 / count, (unsigned long long) wal.getSyncCount(),
+                    same ? "same" : "DIFFERENT");
+
+        delete world;
+        delete recovered;
+    }
+
+    // recovery cost alone: the whole log on an empty world
+    std::remove(snapshotPath.c_str());
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint64_t sequence = 0;
+    world_cup_t *recovered = recoverWorld<world_cup_t>(nullptr, walPath.c_str(), 2, wet2::apply, &sequence);
+    double elapsed = seconds(start);
+    std::printf("recovery from the log alone: %llu ops in %.3f s\n", (unsigned long long) sequence, elapsed);
+    delete recovered;
+
+    std::remove(walPath.c_str());
+    return 0;
+}
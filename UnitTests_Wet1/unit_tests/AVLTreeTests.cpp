@@ -0,0 +1,438 @@
+#include "catch.hpp"
+#include "AVLTree.h"
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    struct Item
+    {
+        int key;
+    };
+
+    typedef AVLTree<int, Item> Tree;
+
+    // the trees store &items[k] under the key &items[k].key
+    const int MAX_KEY = 4096;
+    Item items[MAX_KEY];
+
+    Item *item(int k)
+    {
+        items[k].key = k;
+        return &items[k];
+    }
+
+    void insertKeys(Tree &tree, const vector<int> &keys)
+    {
+        for (int k : keys)
+            tree.insert(&item(k)->key, item(k));
+    }
+
+    void requireKeys(Tree &tree, vector<int> keys)
+    {
+        sort(keys.begin(), keys.end());
+        REQUIRE(tree.isValid());
+        REQUIRE(tree.getSize() == (int) keys.size());
+
+        vector<Item *> values(keys.size() + 1);
+        tree.arrayInOrder(values.data());
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            REQUIRE(values[i]->key == keys[i]);
+            REQUIRE(tree.select((int) i)->key == keys[i]);
+            REQUIRE(tree.find(&keys[i]) != nullptr);
+        }
+        if (keys.empty())
+        {
+            REQUIRE(tree.findMin() == nullptr);
+            REQUIRE(tree.findMax() == nullptr);
+        }
+        else
+        {
+            REQUIRE(tree.findMin()->key == keys.front());
+            REQUIRE(tree.findMax()->key == keys.back());
+        }
+    }
+
+    // count keys from first on with the given step, in an order that makes every kind of rotation
+    vector<int> keysFrom(int first, int count, int step)
+    {
+        vector<int> keys;
+        for (int i = 0; i < count; ++i)
+            keys.push_back(first + ((i * 37) % count) * step);
+        return keys;
+    }
+
+    /*
+     * Merges a tree of keys2 into one of keys1, both from the same counting allocator, and checks
+     * the result, that other is left empty and that nothing was allocated.
+     */
+    void checkMerge(const vector<int> &keys1, const vector<int> &keys2)
+    {
+        CountingAllocator allocator;
+        {
+            Tree tree(allocator);
+            Tree other(allocator);
+            insertKeys(tree, keys1);
+            insertKeys(other, keys2);
+            uint64_t allocations = allocator.getAllocations();
+
+            tree.merge(other);
+            REQUIRE(allocator.getAllocations() == allocations);
+            vector<int> all(keys1);
+            all.insert(all.end(), keys2.begin(), keys2.end());
+            requireKeys(tree, all);
+            requireKeys(other, vector<int>());
+
+            // both trees keep working on the moved nodes
+            if (!all.empty())
+            {
+                tree.remove(&all.front());
+                all.erase(all.begin());
+            }
+            other.insert(&item(MAX_KEY - 1)->key, item(MAX_KEY - 1));
+            requireKeys(tree, all);
+            requireKeys(other, vector<int>(1, MAX_KEY - 1));
+        }
+        REQUIRE(allocator.getLive() == 0);
+    }
+}
+
+TEST_CASE("avl tree merge")
+{
+    SECTION("empty trees")
+    {
+        checkMerge(vector<int>(), vector<int>());
+        checkMerge(keysFrom(0, 10, 1), vector<int>());
+        checkMerge(vector<int>(), keysFrom(0, 10, 1));
+    }
+
+    SECTION("a much smaller tree is linked in node by node")
+    {
+        checkMerge(keysFrom(0, 1000, 2), keysFrom(1, 3, 2));
+        checkMerge(keysFrom(1, 3, 2), keysFrom(0, 1000, 2));
+        checkMerge(keysFrom(0, 1, 1), keysFrom(1, 1, 1));
+        // below and above every key of the larger tree
+        checkMerge(keysFrom(100, 900, 1), keysFrom(0, 5, 1));
+        checkMerge(keysFrom(2000, 5, 1), keysFrom(100, 900, 1));
+    }
+
+    SECTION("trees of similar size are merged as lists")
+    {
+        checkMerge(keysFrom(0, 300, 2), keysFrom(1, 400, 2));
+        checkMerge(keysFrom(1, 400, 2), keysFrom(0, 300, 2));
+        checkMerge(keysFrom(0, 500, 1), keysFrom(500, 500, 1));
+        checkMerge(keysFrom(500, 500, 1), keysFrom(0, 500, 1));
+        checkMerge(keysFrom(0, 1023, 3), keysFrom(1, 1024, 3));
+    }
+
+    SECTION("merged trees stay balanced through more merges")
+    {
+        CountingAllocator allocator;
+        {
+            Tree tree(allocator);
+            vector<int> all;
+            for (int round = 0; round < 8; ++round)
+            {
+                Tree other(allocator);
+                vector<int> keys = keysFrom(round, 1 << (round + 2), 8);
+                insertKeys(other, keys);
+                tree.merge(other);
+                all.insert(all.end(), keys.begin(), keys.end());
+                requireKeys(tree, all);
+            }
+        }
+        REQUIRE(allocator.getLive() == 0);
+    }
+}
+
+namespace
+{
+    /*
+     * Items whose keys change, for the tests of rekey and of the smallest and largest keys.
+     * keys holds the keys in the tree, so the nodes of min and max can be checked after every change.
+     */
+    class KeyedItems
+    {
+    public:
+        explicit KeyedItems(int count) : pool(count), used(0)
+        {}
+
+        Item *add(Tree &tree, int key)
+        {
+            Item *added = &pool[used++];
+            added->key = key;
+            tree.insert(&added->key, added);
+            keys[key] = added;
+            return added;
+        }
+
+        void remove(Tree &tree, int key)
+        {
+            tree.remove(&keys[key]->key);
+            keys.erase(key);
+        }
+
+        // rekey of the item with key to newKey, which has to be free
+        void rekey(Tree &tree, int key, int newKey, Item **previous = nullptr, Item **next = nullptr)
+        {
+            Item *moved = keys[key];
+            tree.rekey(&moved->key, [moved, newKey]()
+            {
+                moved->key = newKey;
+            }, previous, next);
+            keys.erase(key);
+            keys[newKey] = moved;
+        }
+
+        void requireEnds(Tree &tree)
+        {
+            REQUIRE(tree.isValid());
+            REQUIRE(tree.getSize() == (int) keys.size());
+            if (keys.empty())
+            {
+                REQUIRE(tree.findMin() == nullptr);
+                REQUIRE(tree.findMax() == nullptr);
+                return;
+            }
+            REQUIRE(tree.findMin() == keys.begin()->second);
+            REQUIRE(tree.findMax() == keys.rbegin()->second);
+        }
+
+        vector<Item> pool;
+        int used;
+        map<int, Item *> keys;
+    };
+}
+
+TEST_CASE("avl tree smallest and largest keys")
+{
+    SECTION("single changes at the ends")
+    {
+        Tree tree;
+        KeyedItems items(64);
+        items.requireEnds(tree);
+        items.add(tree, 50);
+        items.requireEnds(tree);
+        items.remove(tree, 50);
+        items.requireEnds(tree);
+
+        for (int key : {50, 30, 70, 20, 40, 60, 80, 35, 65})
+        {
+            items.add(tree, key);
+            items.requireEnds(tree);
+        }
+        // the smallest key with a right child, the largest with a left one
+        items.add(tree, 25);
+        items.remove(tree, 20);
+        items.requireEnds(tree);
+        items.add(tree, 75);
+        items.remove(tree, 80);
+        items.requireEnds(tree);
+
+        // ends moved past each other, and inner keys moved to the ends
+        items.rekey(tree, 25, 90);
+        items.requireEnds(tree);
+        items.rekey(tree, 90, 10);
+        items.requireEnds(tree);
+        items.rekey(tree, 50, 5);
+        items.requireEnds(tree);
+        items.rekey(tree, 60, 95);
+        items.requireEnds(tree);
+        // an end that keeps its place
+        items.rekey(tree, 95, 96);
+        items.requireEnds(tree);
+
+        // the root, which has both children, and everything else
+        while (!items.keys.empty())
+        {
+            items.remove(tree, items.keys.rbegin()->first);
+            items.requireEnds(tree);
+            if (!items.keys.empty())
+            {
+                items.remove(tree, items.keys.begin()->first);
+                items.requireEnds(tree);
+            }
+        }
+    }
+
+    SECTION("merges bring new ends")
+    {
+        Tree tree;
+        Tree other;
+        KeyedItems items(64);
+        KeyedItems otherItems(64);
+        for (int key = 20; key < 40; ++key)
+            items.add(tree, key);
+        for (int key : {5, 45})
+            otherItems.add(other, key);
+        tree.merge(other);
+        items.keys.insert(otherItems.keys.begin(), otherItems.keys.end());
+        otherItems.keys.clear();
+        items.requireEnds(tree);
+        otherItems.requireEnds(other);
+
+        // into an empty tree, and from one
+        Tree empty;
+        empty.merge(tree);
+        otherItems.requireEnds(tree);
+        items.requireEnds(empty);
+        empty.merge(tree);
+        items.requireEnds(empty);
+    }
+
+    SECTION("random changes")
+    {
+        std::mt19937 random(43);
+        Tree tree;
+        KeyedItems items(20000);
+        for (int step = 0; step < 5000; ++step)
+        {
+            int key = (int) (random() % 100000);
+            int choice = (int) (random() % 8);
+            if (items.keys.empty() || choice < 3)
+            {
+                if (items.keys.count(key) == 0)
+                    items.add(tree, key);
+            }
+            else if (choice < 5)
+            {
+                map<int, Item *>::iterator it = items.keys.lower_bound(key);
+                if (it == items.keys.end())
+                    it = items.keys.begin();
+                items.remove(tree, it->first);
+            }
+            else if (choice < 7)
+            {
+                map<int, Item *>::iterator it = items.keys.lower_bound(key);
+                if (it == items.keys.end())
+                    --it;
+                int newKey = (int) (random() % 100000);
+                if (items.keys.count(newKey) == 0)
+                    items.rekey(tree, it->first, newKey);
+            }
+            else
+            {
+                Tree other;
+                KeyedItems otherItems(16);
+                for (int i = 0; i < (int) (random() % 16); ++i)
+                {
+                    int otherKey = (int) (random() % 100000);
+                    if (items.keys.count(otherKey) == 0 && otherItems.keys.count(otherKey) == 0)
+                        otherItems.add(other, otherKey);
+                }
+                tree.merge(other);
+                items.keys.insert(otherItems.keys.begin(), otherItems.keys.end());
+                items.requireEnds(tree);
+                // the merged items live in otherItems, which goes out of scope
+                for (map<int, Item *>::iterator it = otherItems.keys.begin(); it != otherItems.keys.end(); ++it)
+                    items.remove(tree, it->first);
+            }
+            items.requireEnds(tree);
+        }
+    }
+}
+
+namespace
+{
+    // rekeys key to newKey and checks the neighbours it returns against the keys after the change
+    void checkRekey(Tree &tree, KeyedItems &items, int key, int newKey)
+    {
+        Item *before = &items.pool[0];
+        Item *after = &items.pool[0];
+        items.rekey(tree, key, newKey, &before, &after);
+        items.requireEnds(tree);
+
+        map<int, Item *>::iterator it = items.keys.find(newKey);
+        REQUIRE(tree.find(&newKey) == it->second);
+        if (it == items.keys.begin())
+            REQUIRE(before == nullptr);
+        else
+            REQUIRE(before == prev(it)->second);
+        if (next(it) == items.keys.end())
+            REQUIRE(after == nullptr);
+        else
+            REQUIRE(after == next(it)->second);
+    }
+}
+
+TEST_CASE("avl tree rekey")
+{
+    CountingAllocator allocator;
+    {
+        Tree tree(allocator);
+        KeyedItems items(2000);
+
+        SECTION("a single key")
+        {
+            items.add(tree, 10);
+            checkRekey(tree, items, 10, 20);
+            checkRekey(tree, items, 20, 5);
+        }
+
+        SECTION("keys that keep their order")
+        {
+            for (int key = 10; key <= 100; key += 10)
+                items.add(tree, key);
+            uint64_t allocations = allocator.getAllocations();
+            checkRekey(tree, items, 50, 55);
+            checkRekey(tree, items, 55, 41);
+            checkRekey(tree, items, 10, 1);
+            checkRekey(tree, items, 100, 200);
+            REQUIRE(allocator.getAllocations() == allocations);
+        }
+
+        SECTION("keys that move")
+        {
+            for (int key = 10; key <= 100; key += 10)
+                items.add(tree, key);
+            uint64_t allocations = allocator.getAllocations();
+            // past one neighbour, across the tree, and to either end
+            checkRekey(tree, items, 50, 65);
+            checkRekey(tree, items, 20, 95);
+            checkRekey(tree, items, 90, 0);
+            checkRekey(tree, items, 0, 300);
+            checkRekey(tree, items, 300, 15);
+            REQUIRE(allocator.getAllocations() == allocations);
+        }
+
+        SECTION("a missing key")
+        {
+            items.add(tree, 10);
+            int missing = 11;
+            bool called = false;
+            REQUIRE_THROWS_AS(tree.rekey(&missing, [&called]()
+            {
+                called = true;
+            }), Tree::KeyDoesNotExist);
+            REQUIRE(!called);
+            items.requireEnds(tree);
+        }
+
+        SECTION("random keys")
+        {
+            std::mt19937 random(44);
+            for (int i = 0; i < 1000; ++i)
+            {
+                int key = (int) (random() % 100000);
+                if (items.keys.count(key) == 0)
+                    items.add(tree, key);
+            }
+            for (int step = 0; step < 3000; ++step)
+            {
+                map<int, Item *>::iterator it = items.keys.lower_bound((int) (random() % 100000));
+                if (it == items.keys.end())
+                    it = items.keys.begin();
+                // mostly small steps, which tend to keep the order
+                int newKey = (step % 2 == 0) ? it->first + (int) (random() % 7) - 3 : (int) (random() % 100000);
+                if (newKey != it->first && items.keys.count(newKey) == 0)
+                    checkRekey(tree, items, it->first, newKey);
+            }
+        }
+    }
+    REQUIRE(allocator.getLive() == 0);
+}
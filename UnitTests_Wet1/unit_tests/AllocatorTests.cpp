@@ -0,0 +1,136 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "worldcup23a1.h"
+#include "WorldTestUtil.h"
+#include <functional>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    const int TEAMS = 8;
+    const int PLAYERS_PER_TEAM = 4;
+    // unite_teams may give the united team an id past the ones added
+    const int MAX_TEAM_ID = 2 * TEAMS;
+
+    /*
+     * Runs operation on tested with the k-th allocation failing, for k = 0, 1, ... until it gets
+     * through. Every failure has to leave tested like expected, then expected catches up.
+     * @return the number of failures injected
+     */
+    int failEveryAllocation(CountingAllocator &allocator, world_cup_t *expected, world_cup_t *tested,
+                            const function<StatusType(world_cup_t *)> &operation)
+    {
+        int failures = 0;
+        while (true)
+        {
+            allocator.failAfter(failures);
+            StatusType status = operation(tested);
+            allocator.failAfter(-1);
+            if (status != StatusType::ALLOCATION_ERROR)
+            {
+                REQUIRE(status == operation(expected));
+                requireSameState(expected, tested, MAX_TEAM_ID, PLAYERS_PER_TEAM);
+                return failures;
+            }
+            requireSameState(expected, tested, MAX_TEAM_ID, PLAYERS_PER_TEAM);
+            failures++;
+        }
+    }
+}
+
+TEST_CASE("allocator")
+{
+    SECTION("counts the allocations of every operation")
+    {
+        CountingAllocator allocator;
+        world_cup_t *obj = new world_cup_t(allocator);
+        uint64_t before = allocator.getAllocations();
+        REQUIRE(obj->add_team(1, 0) == StatusType::SUCCESS);
+        REQUIRE(allocator.getAllocations() > before);
+
+        before = allocator.getAllocations();
+        REQUIRE(obj->add_player(1, 1, 1, 5, 0, true) == StatusType::SUCCESS);
+        REQUIRE(allocator.getAllocations() > before);
+
+        before = allocator.getAllocations();
+        REQUIRE(obj->get_team_points(1).status() == StatusType::SUCCESS);
+        REQUIRE(obj->get_num_played_games(1).status() == StatusType::SUCCESS);
+        REQUIRE(allocator.getAllocations() == before);
+
+        delete obj;
+        REQUIRE(allocator.getLive() == 0);
+        REQUIRE(allocator.getLiveBytes() == 0);
+    }
+
+    SECTION("allocation failures roll back")
+    {
+        CountingAllocator allocator;
+        world_cup_t *expected = new world_cup_t();
+        world_cup_t *tested = new world_cup_t(allocator);
+        int failures = 0;
+
+        for (int team = 1; team <= TEAMS; ++team)
+        {
+            failures += failEveryAllocation(allocator, expected, tested, [team](world_cup_t *world)
+            {
+                return world->add_team(team, team % 3);
+            });
+            for (int i = 0; i < PLAYERS_PER_TEAM; ++i)
+            {
+                failures += failEveryAllocation(allocator, expected, tested, [team, i](world_cup_t *world)
+                {
+                    return world->add_player(playerId(team, i), team, i + 1, (team * 7 + i * 3) % 11, i % 2, i == 0);
+                });
+            }
+        }
+        REQUIRE(failures > 0);
+
+        for (int team = 1; team <= TEAMS; ++team)
+        {
+            // goals move the players in the sorted tree, games only go into the union find
+            failEveryAllocation(allocator, expected, tested, [team](world_cup_t *world)
+            {
+                return world->update_player_stats(playerId(team, 1), 1, team % 4, 0);
+            });
+            failEveryAllocation(allocator, expected, tested, [team](world_cup_t *world)
+            {
+                return world->update_player_stats(playerId(team, 2), 2, 0, 1);
+            });
+        }
+
+        REQUIRE(expected->play_match(1, 2) == tested->play_match(1, 2));
+        REQUIRE(expected->play_match(3, 4) == tested->play_match(3, 4));
+        // into the first team, into the second and into a new id
+        REQUIRE(failEveryAllocation(allocator, expected, tested, [](world_cup_t *world)
+        {
+            return world->unite_teams(1, 2, 1);
+        }) > 0);
+        failEveryAllocation(allocator, expected, tested, [](world_cup_t *world)
+        {
+            return world->unite_teams(3, 4, 4);
+        });
+        failEveryAllocation(allocator, expected, tested, [](world_cup_t *world)
+        {
+            return world->unite_teams(5, 6, TEAMS + 1);
+        });
+        failEveryAllocation(allocator, expected, tested, [](world_cup_t *world)
+        {
+            return world->unite_teams(1, 4, 1);
+        });
+        failEveryAllocation(allocator, expected, tested, [](world_cup_t *world)
+        {
+            return world->update_player_stats(playerId(3, 0), 1, 5, 1);
+        });
+        failEveryAllocation(allocator, expected, tested, [](world_cup_t *world)
+        {
+            return world->add_player(playerId(TEAMS + 1, 0), TEAMS + 1, 2, 9, 0, false);
+        });
+
+        delete tested;
+        delete expected;
+        REQUIRE(allocator.getLive() == 0);
+        REQUIRE(allocator.getLiveBytes() == 0);
+    }
+}
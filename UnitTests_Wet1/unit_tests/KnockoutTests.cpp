@@ -0,0 +1,333 @@
+#include "catch.hpp"
+#include "worldcup23a1.h"
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    const int TEAM_SIZE = 11;
+
+    /*
+     * A league kept both in a world and by hand, so knockout_winner can be checked against
+     * the plain bracket over every playable team in the range.
+     */
+    class League
+    {
+    public:
+        struct TeamModel
+        {
+            int points;
+            int score; // points + goals - cards
+            int players;
+            int goalKeepers;
+        };
+
+        struct PlayerModel
+        {
+            int team;
+            int goals;
+            int cards;
+            bool goalKeeper;
+        };
+
+        League() : world(new world_cup_t()), nextPlayer(1)
+        {}
+
+        ~League()
+        {
+            delete world;
+        }
+
+        void addTeam(int team, int points, int players)
+        {
+            REQUIRE(world->add_team(team, points) == StatusType::SUCCESS);
+            teams[team] = TeamModel{points, points, 0, 0};
+            for (int i = 0; i < players; ++i)
+                addPlayer(team, (team * 7 + i) % 5, (team + i) % 3, i == 0);
+        }
+
+        int addPlayer(int team, int goals, int cards, bool goalKeeper)
+        {
+            int id = nextPlayer++;
+            REQUIRE(world->add_player(id, team, 1, goals, cards, goalKeeper) == StatusType::SUCCESS);
+            players[id] = PlayerModel{team, goals, cards, goalKeeper};
+            TeamModel &model = teams[team];
+            model.score += goals - cards;
+            model.players++;
+            model.goalKeepers += goalKeeper ? 1 : 0;
+            return id;
+        }
+
+        void removePlayer(int id)
+        {
+            REQUIRE(world->remove_player(id) == StatusType::SUCCESS);
+            PlayerModel &player = players[id];
+            TeamModel &model = teams[player.team];
+            model.score -= player.goals - player.cards;
+            model.players--;
+            model.goalKeepers -= player.goalKeeper ? 1 : 0;
+            players.erase(id);
+        }
+
+        void updatePlayer(int id, int goals, int cards)
+        {
+            REQUIRE(world->update_player_stats(id, 1, goals, cards) == StatusType::SUCCESS);
+            PlayerModel &player = players[id];
+            player.goals += goals;
+            player.cards += cards;
+            teams[player.team].score += goals - cards;
+        }
+
+        void playMatch(int team1, int team2)
+        {
+            REQUIRE(world->play_match(team1, team2) == StatusType::SUCCESS);
+            TeamModel &model1 = teams[team1];
+            TeamModel &model2 = teams[team2];
+            int points1 = (model1.score > model2.score) ? 3 : (model1.score == model2.score ? 1 : 0);
+            int points2 = (model2.score > model1.score) ? 3 : (model1.score == model2.score ? 1 : 0);
+            model1.points += points1;
+            model1.score += points1;
+            model2.points += points2;
+            model2.score += points2;
+        }
+
+        void unite(int team1, int team2, int newTeam)
+        {
+            REQUIRE(world->unite_teams(team1, team2, newTeam) == StatusType::SUCCESS);
+            TeamModel united = teams[team1];
+            TeamModel &model2 = teams[team2];
+            united.points += model2.points;
+            united.score += model2.score;
+            united.players += model2.players;
+            united.goalKeepers += model2.goalKeepers;
+            for (auto &entry : players)
+            {
+                if (entry.second.team == team1 || entry.second.team == team2)
+                    entry.second.team = newTeam;
+            }
+            teams.erase(team1);
+            teams.erase(team2);
+            teams[newTeam] = united;
+        }
+
+        void removeTeam(int team)
+        {
+            vector<int> ids;
+            for (auto &entry : players)
+            {
+                if (entry.second.team == team)
+                    ids.push_back(entry.first);
+            }
+            for (int id : ids)
+                removePlayer(id);
+            REQUIRE(world->remove_team(team) == StatusType::SUCCESS);
+            teams.erase(team);
+        }
+
+        // the bracket of the teams in order, the way knockout_winner is defined
+        output_t<int> plainWinner(int minTeamId, int maxTeamId) const
+        {
+            vector<pair<int, int>> bracket;
+            for (map<int, TeamModel>::const_iterator it = teams.lower_bound(minTeamId);
+                 it != teams.end() && it->first <= maxTeamId; ++it)
+            {
+                if (it->second.players >= TEAM_SIZE && it->second.goalKeepers > 0)
+                    bracket.push_back(make_pair(it->first, it->second.score));
+            }
+            if (bracket.empty())
+                return StatusType::FAILURE;
+            for (size_t step = 1; step < bracket.size(); step *= 2)
+            {
+                for (size_t i = 0; i + step < bracket.size(); i += 2 * step)
+                {
+                    if (bracket[i].second <= bracket[i + step].second)
+                        bracket[i].first = bracket[i + step].first;
+                    bracket[i].second += bracket[i + step].second + 3;
+                }
+            }
+            return bracket[0].first;
+        }
+
+        void requireWinner(int minTeamId, int maxTeamId)
+        {
+            output_t<int> expected = plainWinner(minTeamId, maxTeamId);
+            output_t<int> actual = world->knockout_winner(minTeamId, maxTeamId);
+            REQUIRE(actual.status() == expected.status());
+            REQUIRE(actual.ans() == expected.ans());
+        }
+
+        world_cup_t *world;
+        map<int, TeamModel> teams;
+        map<int, PlayerModel> players;
+        int nextPlayer;
+    };
+
+    // teams 1..count, every seventh one short of players so it is not playable
+    void buildLeague(League &league, int count)
+    {
+        for (int team = 1; team <= count; ++team)
+            league.addTeam(team, (team * 13) % 17, team % 7 == 0 ? TEAM_SIZE - 1 : TEAM_SIZE);
+    }
+
+    void requireRanges(League &league, const vector<pair<int, int>> &ranges)
+    {
+        for (const pair<int, int> &range : ranges)
+            league.requireWinner(range.first, range.second);
+    }
+}
+
+TEST_CASE("knockout winner")
+{
+    SECTION("small and empty ranges")
+    {
+        League league;
+        REQUIRE(league.world->knockout_winner(1, 1).status() == StatusType::FAILURE);
+        REQUIRE(league.world->knockout_winner(2, 1).status() == StatusType::INVALID_INPUT);
+        buildLeague(league, 40);
+        for (int first = 0; first <= 41; ++first)
+        {
+            for (int last = first; last <= 41; ++last)
+                league.requireWinner(first, last);
+        }
+    }
+
+    SECTION("stale cache entries after a mutation")
+    {
+        League league;
+        buildLeague(league, 300);
+        vector<pair<int, int>> ranges = {{1, 300}, {1, 64}, {33, 96}, {100, 299}, {0, 1000}, {65, 128}};
+        requireRanges(league, ranges);
+
+        // every change that can move a team's score or playability, each followed by the same ranges
+        league.updatePlayer(5 * TEAM_SIZE, 10, 0);
+        requireRanges(league, ranges);
+        league.playMatch(40, 41);
+        requireRanges(league, ranges);
+        league.addPlayer(7, 0, 0, false);
+        requireRanges(league, ranges);
+        league.removePlayer(league.addPlayer(50, 9, 0, false));
+        requireRanges(league, ranges);
+        league.removePlayer(12 * TEAM_SIZE);
+        requireRanges(league, ranges);
+        league.unite(60, 61, 60);
+        requireRanges(league, ranges);
+        league.unite(90, 200, 1000);
+        requireRanges(league, ranges);
+        league.removeTeam(33);
+        requireRanges(league, ranges);
+        league.addTeam(33, 50, TEAM_SIZE);
+        requireRanges(league, ranges);
+        league.addTeam(301, 0, TEAM_SIZE);
+        requireRanges(league, ranges);
+
+        // rejected calls change nothing, the blocks cached before them still answer
+        world_cup_t *world = league.world;
+        REQUIRE(world->add_team(40, 0) == StatusType::FAILURE);
+        REQUIRE(world->add_team(0, 0) == StatusType::INVALID_INPUT);
+        REQUIRE(world->remove_team(40) == StatusType::FAILURE);
+        REQUIRE(world->add_player(1, 40, 1, 0, 0, false) == StatusType::FAILURE);
+        REQUIRE(world->add_player(-1, 40, 1, 0, 0, false) == StatusType::INVALID_INPUT);
+        REQUIRE(world->remove_player(0) == StatusType::INVALID_INPUT);
+        REQUIRE(world->update_player_stats(1, -1, 0, 0) == StatusType::INVALID_INPUT);
+        REQUIRE(world->play_match(40, 40) == StatusType::INVALID_INPUT);
+        REQUIRE(world->play_match(40, 5000) == StatusType::FAILURE);
+        REQUIRE(world->unite_teams(40, 5000, 40) == StatusType::FAILURE);
+        requireRanges(league, ranges);
+    }
+
+    SECTION("ranges that share blocks")
+    {
+        League league;
+        buildLeague(league, 700);
+        // aligned blocks seen again from ranges that start and end anywhere around them
+        vector<pair<int, int>> ranges;
+        for (int first : {1, 2, 31, 32, 33, 64, 65, 129, 300})
+        {
+            for (int last : {64, 96, 128, 256, 257, 511, 512, 700})
+            {
+                if (first <= last)
+                    ranges.push_back(make_pair(first, last));
+            }
+        }
+        requireRanges(league, ranges);
+        // the same ranges once the cache is warm, and backwards
+        requireRanges(league, vector<pair<int, int>>(ranges.rbegin(), ranges.rend()));
+    }
+
+    SECTION("slot collisions")
+    {
+        League league;
+        buildLeague(league, 3000);
+        std::mt19937 random(41);
+        // far more blocks than cache slots, so blocks keep taking each other's slots
+        vector<pair<int, int>> ranges;
+        for (int i = 0; i < 400; ++i)
+        {
+            int first = (int) (random() % 3000) + 1;
+            int last = first + (int) (random() % (3001 - first));
+            ranges.push_back(make_pair(first, last));
+        }
+        requireRanges(league, ranges);
+        requireRanges(league, ranges);
+        league.playMatch(1500, 1501);
+        requireRanges(league, ranges);
+    }
+}
+
+namespace
+{
+    const int PARALLEL_TEAMS = (1 << 16) + 3000;
+
+    void buildPlayableTeams(world_cup_t *world, int count)
+    {
+        int player = 1;
+        for (int team = 1; team <= count; ++team)
+        {
+            REQUIRE(world->add_team(team, (team * 13) % 17) == StatusType::SUCCESS);
+            for (int i = 0; i < TEAM_SIZE; ++i)
+            {
+                REQUIRE(world->add_player(player++, team, 1, (team * 7 + i) % 5, (team + i) % 3, i == 0)
+                        == StatusType::SUCCESS);
+            }
+        }
+    }
+
+    void requireSameWinner(world_cup_t *serial, world_cup_t *parallel, int minTeamId, int maxTeamId)
+    {
+        output_t<int> expected = serial->knockout_winner(minTeamId, maxTeamId);
+        output_t<int> actual = parallel->knockout_winner(minTeamId, maxTeamId);
+        REQUIRE(expected.status() == StatusType::SUCCESS);
+        REQUIRE(actual.status() == StatusType::SUCCESS);
+        REQUIRE(actual.ans() == expected.ans());
+    }
+}
+
+TEST_CASE("parallel knockout winner")
+{
+    world_cup_t *serial = new world_cup_t();
+    world_cup_t *parallel = new world_cup_t();
+    buildPlayableTeams(serial, PARALLEL_TEAMS);
+    buildPlayableTeams(parallel, PARALLEL_TEAMS);
+
+    // whole ranges and ones that cut blocks of the threads at both ends, each with a cold cache first
+    const pair<int, int> ranges[] = {{1, PARALLEL_TEAMS}, {0, 2 * PARALLEL_TEAMS}, {777, PARALLEL_TEAMS - 1234}};
+    for (int threads : {2, 3, 8})
+    {
+        parallel->setKnockoutThreads(threads);
+        for (const pair<int, int> &range : ranges)
+            requireSameWinner(serial, parallel, range.first, range.second);
+
+        // a change to one team has to reach the blocks the threads cached
+        REQUIRE(serial->play_match(100 * threads, 100 * threads + 1) == StatusType::SUCCESS);
+        REQUIRE(parallel->play_match(100 * threads, 100 * threads + 1) == StatusType::SUCCESS);
+        REQUIRE(serial->update_player_stats(40000 + threads, 1, 20, 0) == StatusType::SUCCESS);
+        REQUIRE(parallel->update_player_stats(40000 + threads, 1, 20, 0) == StatusType::SUCCESS);
+        for (const pair<int, int> &range : ranges)
+            requireSameWinner(serial, parallel, range.first, range.second);
+    }
+    delete parallel;
+    delete serial;
+}
@@ -0,0 +1,149 @@
+#include "catch.hpp"
+#include "worldcup23a1.h"
+#include "WorldTestUtil.h"
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    const int TEAMS = 6;
+    const int PLAYERS_PER_TEAM = 7;
+
+    void buildWorld(world_cup_t *obj)
+    {
+        for (int team = 1; team <= TEAMS; ++team)
+        {
+            REQUIRE(obj->add_team(team, 0) == StatusType::SUCCESS);
+            for (int i = 0; i < PLAYERS_PER_TEAM; ++i)
+            {
+                REQUIRE(obj->add_player(playerId(team, i), team, 1, (team * 5 + i) % 4, (team + i) % 3, i == 0)
+                        == StatusType::SUCCESS);
+            }
+        }
+    }
+
+    vector<int> allPlayers(world_cup_t *obj)
+    {
+        output_t<int> count = obj->get_all_players_count(-1);
+        REQUIRE(count.status() == StatusType::SUCCESS);
+        vector<int> ids(count.ans());
+        if (!ids.empty())
+            REQUIRE(obj->get_all_players(-1, ids.data()) == StatusType::SUCCESS);
+        return ids;
+    }
+
+    // every page is full but the last one, and after it a page comes back empty
+    vector<int> readPages(world_cup_t *obj, int pageSize)
+    {
+        vector<int> ids;
+        vector<int> page(pageSize);
+        int after = 0;
+        while (true)
+        {
+            output_t<int> written = obj->getPlayersPage(after, pageSize, page.data());
+            REQUIRE(written.status() == StatusType::SUCCESS);
+            REQUIRE(written.ans() >= 0);
+            REQUIRE(written.ans() <= pageSize);
+            if (written.ans() == 0)
+                return ids;
+            ids.insert(ids.end(), page.begin(), page.begin() + written.ans());
+            after = ids.back();
+            if (written.ans() < pageSize)
+            {
+                REQUIRE(obj->getPlayersPage(after, pageSize, page.data()).ans() == 0);
+                return ids;
+            }
+        }
+    }
+}
+
+TEST_CASE("players page")
+{
+    world_cup_t *obj = new world_cup_t();
+    int page[TEAMS * PLAYERS_PER_TEAM + 1];
+
+    SECTION("an empty world")
+    {
+        output_t<int> written = obj->getPlayersPage(0, 5, page);
+        REQUIRE(written.status() == StatusType::SUCCESS);
+        REQUIRE(written.ans() == 0);
+    }
+
+    SECTION("paging through every player")
+    {
+        buildWorld(obj);
+        vector<int> expected = allPlayers(obj);
+        REQUIRE(expected.size() == TEAMS * PLAYERS_PER_TEAM);
+        for (int pageSize : {1, 2, 5, 7, TEAMS * PLAYERS_PER_TEAM - 1, TEAMS * PLAYERS_PER_TEAM,
+                             TEAMS * PLAYERS_PER_TEAM + 1})
+            REQUIRE(readPages(obj, pageSize) == expected);
+
+        // the order follows the players as their stats change and teams go
+        REQUIRE(obj->update_player_stats(playerId(2, 3), 1, 10, 0) == StatusType::SUCCESS);
+        REQUIRE(obj->remove_player(playerId(4, 0)) == StatusType::SUCCESS);
+        REQUIRE(obj->unite_teams(5, 6, 5) == StatusType::SUCCESS);
+        REQUIRE(obj->add_player(playerId(1, 50), 1, 1, 0, 9, false) == StatusType::SUCCESS);
+        expected = allPlayers(obj);
+        for (int pageSize : {1, 4, TEAMS * PLAYERS_PER_TEAM})
+            REQUIRE(readPages(obj, pageSize) == expected);
+    }
+
+    SECTION("starting after any player")
+    {
+        buildWorld(obj);
+        vector<int> expected = allPlayers(obj);
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            output_t<int> written = obj->getPlayersPage(expected[i], 3, page);
+            REQUIRE(written.status() == StatusType::SUCCESS);
+            REQUIRE(written.ans() == (int) min<size_t>(3, expected.size() - i - 1));
+            for (int j = 0; j < written.ans(); ++j)
+                REQUIRE(page[j] == expected[i + 1 + j]);
+        }
+    }
+
+    SECTION("the last page")
+    {
+        buildWorld(obj);
+        vector<int> expected = allPlayers(obj);
+        int size = (int) expected.size();
+
+        // a page reaching past the end holds what is left
+        output_t<int> written = obj->getPlayersPage(expected[size - 3], 10, page);
+        REQUIRE(written.ans() == 2);
+        REQUIRE(page[0] == expected[size - 2]);
+        REQUIRE(page[1] == expected[size - 1]);
+
+        // a page ending exactly on the last player, then nothing after it
+        REQUIRE(obj->getPlayersPage(expected[size - 3], 2, page).ans() == 2);
+        page[0] = -1;
+        output_t<int> after = obj->getPlayersPage(expected[size - 1], 10, page);
+        REQUIRE(after.status() == StatusType::SUCCESS);
+        REQUIRE(after.ans() == 0);
+        REQUIRE(page[0] == -1);
+    }
+
+    SECTION("an unknown player to start after")
+    {
+        buildWorld(obj);
+        REQUIRE(obj->getPlayersPage(1, 5, page).status() == StatusType::FAILURE);
+        REQUIRE(obj->getPlayersPage(playerId(TEAMS + 1, 0), 5, page).status() == StatusType::FAILURE);
+        REQUIRE(obj->remove_player(playerId(3, 2)) == StatusType::SUCCESS);
+        REQUIRE(obj->getPlayersPage(playerId(3, 2), 5, page).status() == StatusType::FAILURE);
+    }
+
+    SECTION("invalid input")
+    {
+        buildWorld(obj);
+        REQUIRE(obj->getPlayersPage(0, 0, page).status() == StatusType::INVALID_INPUT);
+        REQUIRE(obj->getPlayersPage(playerId(1, 0), 0, page).status() == StatusType::INVALID_INPUT);
+        // count is checked before the player is looked up
+        REQUIRE(obj->getPlayersPage(1, 0, page).status() == StatusType::INVALID_INPUT);
+        REQUIRE(obj->getPlayersPage(0, -1, page).status() == StatusType::INVALID_INPUT);
+        REQUIRE(obj->getPlayersPage(-1, 5, page).status() == StatusType::INVALID_INPUT);
+        REQUIRE(obj->getPlayersPage(0, 5, nullptr).status() == StatusType::INVALID_INPUT);
+    }
+
+    delete obj;
+}
@@ -0,0 +1,249 @@
+#include "catch.hpp"
+#include "worldcup23a1.h"
+#include "WorldTestUtil.h"
+#include "SnapshotFile.h"
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    const char *SNAPSHOT_PATH = "wet1_snapshot_test.img";
+    const int TEAMS = 10;
+    const int MAX_TEAM_ID = 2 * TEAMS;
+    const int PLAYERS_PER_TEAM = 12;
+
+    // even teams are playable, odd ones are a player short
+    world_cup_t *buildLeague()
+    {
+        world_cup_t *obj = new world_cup_t();
+        for (int team = 1; team <= TEAMS; ++team)
+        {
+            REQUIRE(obj->add_team(team, team % 4) == StatusType::SUCCESS);
+            int players = (team % 2 == 0) ? PLAYERS_PER_TEAM : 10;
+            for (int i = 0; i < players; ++i)
+            {
+                REQUIRE(obj->add_player(playerId(team, i), team, 1 + i % 3, (team + i) % 4, i % 3, i == 0)
+                        == StatusType::SUCCESS);
+            }
+        }
+        REQUIRE(obj->play_match(2, 4) == StatusType::SUCCESS);
+        REQUIRE(obj->play_match(6, 8) == StatusType::SUCCESS);
+        REQUIRE(obj->update_player_stats(playerId(3, 2), 2, 5, 1) == StatusType::SUCCESS);
+        REQUIRE(obj->unite_teams(1, 3, 15) == StatusType::SUCCESS);
+        REQUIRE(obj->unite_teams(4, 5, 4) == StatusType::SUCCESS);
+        REQUIRE(obj->play_match(4, 15) == StatusType::SUCCESS);
+        REQUIRE(obj->remove_player(playerId(10, 11)) == StatusType::SUCCESS);
+        REQUIRE(obj->add_team(TEAMS + 1, 7) == StatusType::SUCCESS);
+        return obj;
+    }
+
+    // the same changes on both worlds, then they have to agree again
+    void requireSameAfterChanges(world_cup_t *expected, world_cup_t *actual)
+    {
+        for (world_cup_t *world : {expected, actual})
+        {
+            REQUIRE(world->add_player(playerId(TEAMS + 1, 0), TEAMS + 1, 1, 9, 0, true) == StatusType::SUCCESS);
+            REQUIRE(world->update_player_stats(playerId(2, 5), 1, 3, 0) == StatusType::SUCCESS);
+            REQUIRE(world->play_match(2, 6) == StatusType::SUCCESS);
+            REQUIRE(world->unite_teams(7, 9, 7) == StatusType::SUCCESS);
+            REQUIRE(world->remove_player(playerId(8, 3)) == StatusType::SUCCESS);
+        }
+        requireSameState(expected, actual, MAX_TEAM_ID, PLAYERS_PER_TEAM);
+    }
+
+    vector<char> readImage(const char *path)
+    {
+        ifstream in(path, ios::binary);
+        return vector<char>(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    }
+
+    void writeImage(const char *path, const vector<char> &image)
+    {
+        ofstream out(path, ios::binary | ios::trunc);
+        out.write(image.data(), image.size());
+    }
+
+    /*
+     * Writes image with its records changed by corrupt and requires that it is not loaded
+     */
+    void requireRejected(const vector<char> &image,
+                         const function<void(SnapshotHeader *, TeamRecord *, PlayerRecord *, uint32_t *)> &corrupt)
+    {
+        vector<char> copy(image);
+        SnapshotHeader *header = reinterpret_cast<SnapshotHeader *>(copy.data());
+        TeamRecord *teams = reinterpret_cast<TeamRecord *>(copy.data() + sizeof(SnapshotHeader));
+        PlayerRecord *players = reinterpret_cast<PlayerRecord *>(teams + header->teamCount);
+        corrupt(header, teams, players, reinterpret_cast<uint32_t *>(players + header->playerCount));
+        writeImage(SNAPSHOT_PATH, copy);
+        REQUIRE(world_cup_t::loadSnapshot(SNAPSHOT_PATH) == nullptr);
+    }
+}
+
+TEST_CASE("wet1 snapshot")
+{
+    SECTION("save and load an empty world")
+    {
+        world_cup_t *obj = new world_cup_t();
+        REQUIRE(obj->saveSnapshot(SNAPSHOT_PATH, 3) == StatusType::SUCCESS);
+        uint64_t sequence = 0;
+        world_cup_t *loaded = world_cup_t::loadSnapshot(SNAPSHOT_PATH, &sequence);
+        REQUIRE(loaded != nullptr);
+        REQUIRE(sequence == 3);
+        REQUIRE(loaded->get_all_players_count(-1).ans() == 0);
+        REQUIRE(loaded->knockout_winner(0, 10).status() == StatusType::FAILURE);
+        REQUIRE(loaded->add_team(1, 0) == StatusType::SUCCESS);
+
+        delete obj;
+        delete loaded;
+        std::remove(SNAPSHOT_PATH);
+    }
+
+    SECTION("loaded world answers like the original")
+    {
+        world_cup_t *obj = buildLeague();
+        REQUIRE(obj->saveSnapshot(SNAPSHOT_PATH, 42) == StatusType::SUCCESS);
+        uint64_t sequence = 0;
+        world_cup_t *loaded = world_cup_t::loadSnapshot(SNAPSHOT_PATH, &sequence);
+        REQUIRE(loaded != nullptr);
+        REQUIRE(sequence == 42);
+        requireSameState(obj, loaded, MAX_TEAM_ID, PLAYERS_PER_TEAM);
+        requireSameAfterChanges(obj, loaded);
+
+        // a loaded world saves the same image again
+        vector<char> image = readImage(SNAPSHOT_PATH);
+        REQUIRE(loaded->saveSnapshot(SNAPSHOT_PATH, 42) == StatusType::SUCCESS);
+        REQUIRE(obj->saveSnapshot("wet1_snapshot_test2.img", 42) == StatusType::SUCCESS);
+        REQUIRE(readImage(SNAPSHOT_PATH) == readImage("wet1_snapshot_test2.img"));
+        REQUIRE(readImage(SNAPSHOT_PATH) != image);
+
+        delete obj;
+        delete loaded;
+        std::remove(SNAPSHOT_PATH);
+        std::remove("wet1_snapshot_test2.img");
+    }
+
+    SECTION("a loaded world takes its memory from the given allocator")
+    {
+        world_cup_t *obj = buildLeague();
+        REQUIRE(obj->saveSnapshot(SNAPSHOT_PATH) == StatusType::SUCCESS);
+
+        // the k-th allocation failing gives nothing back and leaves nothing behind
+        CountingAllocator allocator;
+        world_cup_t *loaded = nullptr;
+        int failures = 0;
+        while (true)
+        {
+            allocator.failAfter(failures);
+            loaded = world_cup_t::loadSnapshot(SNAPSHOT_PATH, nullptr, allocator);
+            allocator.failAfter(-1);
+            if (loaded != nullptr)
+                break;
+            REQUIRE(allocator.getLive() == 0);
+            failures++;
+        }
+        REQUIRE(failures > TEAMS);
+        requireSameState(obj, loaded, MAX_TEAM_ID, PLAYERS_PER_TEAM);
+        requireSameAfterChanges(obj, loaded);
+
+        delete loaded;
+        REQUIRE(allocator.getLive() == 0);
+        REQUIRE(allocator.getLiveBytes() == 0);
+        delete obj;
+        std::remove(SNAPSHOT_PATH);
+    }
+
+    SECTION("corrupt files are rejected")
+    {
+        world_cup_t *obj = buildLeague();
+        REQUIRE(obj->saveSnapshot(SNAPSHOT_PATH) == StatusType::SUCCESS);
+        delete obj;
+        vector<char> image = readImage(SNAPSHOT_PATH);
+        world_cup_t *loaded = world_cup_t::loadSnapshot(SNAPSHOT_PATH);
+        REQUIRE(loaded != nullptr);
+        delete loaded;
+
+        REQUIRE(world_cup_t::loadSnapshot("wet1_snapshot_missing.img") == nullptr);
+
+        writeImage(SNAPSHOT_PATH, vector<char>(image.begin(), image.end() - 1));
+        REQUIRE(world_cup_t::loadSnapshot(SNAPSHOT_PATH) == nullptr);
+        writeImage(SNAPSHOT_PATH, vector<char>(image.begin(), image.begin() + 5));
+        REQUIRE(world_cup_t::loadSnapshot(SNAPSHOT_PATH) == nullptr);
+
+        requireRejected(image, [](SnapshotHeader *header, TeamRecord *, PlayerRecord *, uint32_t *)
+        {
+            header->magic[0] = 'X';
+        });
+        requireRejected(image, [](SnapshotHeader *header, TeamRecord *, PlayerRecord *, uint32_t *)
+        {
+            header->version++;
+        });
+        requireRejected(image, [](SnapshotHeader *header, TeamRecord *, PlayerRecord *, uint32_t *)
+        {
+            header->playerCount--;
+        });
+
+        // teams out of order or repeated
+        requireRejected(image, [](SnapshotHeader *, TeamRecord *teams, PlayerRecord *, uint32_t *)
+        {
+            std::swap(teams[0].id, teams[1].id);
+        });
+        requireRejected(image, [](SnapshotHeader *, TeamRecord *teams, PlayerRecord *, uint32_t *)
+        {
+            teams[1].id = teams[0].id;
+        });
+        requireRejected(image, [](SnapshotHeader *, TeamRecord *teams, PlayerRecord *, uint32_t *)
+        {
+            teams[0].id = 0;
+        });
+
+        // a player's team out of range
+        requireRejected(image, [](SnapshotHeader *header, TeamRecord *, PlayerRecord *players, uint32_t *)
+        {
+            players[3].team = (int32_t) header->teamCount;
+        });
+        requireRejected(image, [](SnapshotHeader *, TeamRecord *, PlayerRecord *players, uint32_t *)
+        {
+            players[3].team = -1;
+        });
+
+        // players out of playersSorted order
+        requireRejected(image, [](SnapshotHeader *, TeamRecord *, PlayerRecord *players, uint32_t *)
+        {
+            std::swap(players[0], players[1]);
+        });
+        requireRejected(image, [](SnapshotHeader *header, TeamRecord *, PlayerRecord *players, uint32_t *)
+        {
+            players[0].goals = players[header->playerCount - 1].goals + 1;
+        });
+        requireRejected(image, [](SnapshotHeader *, TeamRecord *, PlayerRecord *players, uint32_t *)
+        {
+            players[1] = players[0];
+        });
+
+        // the id order not a permutation, or not by id
+        requireRejected(image, [](SnapshotHeader *header, TeamRecord *, PlayerRecord *, uint32_t *idOrder)
+        {
+            idOrder[2] = header->playerCount;
+        });
+        requireRejected(image, [](SnapshotHeader *, TeamRecord *, PlayerRecord *, uint32_t *idOrder)
+        {
+            idOrder[2] = idOrder[1];
+        });
+        requireRejected(image, [](SnapshotHeader *, TeamRecord *, PlayerRecord *, uint32_t *idOrder)
+        {
+            std::swap(idOrder[2], idOrder[5]);
+        });
+
+        // and the untouched image still loads
+        writeImage(SNAPSHOT_PATH, image);
+        loaded = world_cup_t::loadSnapshot(SNAPSHOT_PATH);
+        REQUIRE(loaded != nullptr);
+        delete loaded;
+        std::remove(SNAPSHOT_PATH);
+    }
+}
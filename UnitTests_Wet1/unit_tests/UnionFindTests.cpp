@@ -0,0 +1,170 @@
+#include "catch.hpp"
+#include "worldcup23a1.h"
+#include "WorldTestUtil.h"
+#include <map>
+
+using namespace std;
+
+namespace
+{
+    const int PLAYERS_PER_TEAM = 11;
+
+    /*
+     * What get_num_played_games has to answer: the games of every player, counted by hand
+     */
+    class GamesModel
+    {
+    public:
+        void addTeam(world_cup_t *world, int team)
+        {
+            REQUIRE(world->add_team(team, 0) == StatusType::SUCCESS);
+            for (int i = 0; i < PLAYERS_PER_TEAM; ++i)
+                addPlayer(world, playerId(team, i), team, i + 1);
+        }
+
+        void addPlayer(world_cup_t *world, int player, int team, int gamesPlayed)
+        {
+            REQUIRE(world->add_player(player, team, gamesPlayed, 0, 0, player % 100 == 0) == StatusType::SUCCESS);
+            games[player] = gamesPlayed;
+            teamOf[player] = team;
+        }
+
+        void removePlayer(world_cup_t *world, int player)
+        {
+            REQUIRE(world->remove_player(player) == StatusType::SUCCESS);
+            games.erase(player);
+            teamOf.erase(player);
+            removed[player] = true;
+        }
+
+        void playMatch(world_cup_t *world, int team1, int team2)
+        {
+            REQUIRE(world->play_match(team1, team2) == StatusType::SUCCESS);
+            for (auto &entry : teamOf)
+            {
+                if (entry.second == team1 || entry.second == team2)
+                    games[entry.first]++;
+            }
+        }
+
+        void unite(world_cup_t *world, int team1, int team2, int newTeam)
+        {
+            REQUIRE(world->unite_teams(team1, team2, newTeam) == StatusType::SUCCESS);
+            for (auto &entry : teamOf)
+            {
+                if (entry.second == team1 || entry.second == team2)
+                    entry.second = newTeam;
+            }
+        }
+
+        void requireGames(world_cup_t *world)
+        {
+            for (auto &entry : games)
+            {
+                output_t<int> result = world->get_num_played_games(entry.first);
+                REQUIRE(result.status() == StatusType::SUCCESS);
+                REQUIRE(result.ans() == entry.second);
+            }
+            for (auto &entry : removed)
+            {
+                if (games.count(entry.first) == 0)
+                    REQUIRE(world->get_num_played_games(entry.first).status() == StatusType::FAILURE);
+            }
+        }
+
+        map<int, int> games;
+        map<int, int> teamOf;
+        map<int, bool> removed;
+    };
+}
+
+TEST_CASE("games played through the union find")
+{
+    CountingAllocator allocator;
+    world_cup_t *obj = new world_cup_t(allocator);
+    GamesModel model;
+    for (int team = 1; team <= 6; ++team)
+        model.addTeam(obj, team);
+
+    SECTION("chained unites and matches")
+    {
+        model.playMatch(obj, 1, 2);
+        model.playMatch(obj, 1, 3);
+        model.unite(obj, 1, 2, 1);
+        model.requireGames(obj);
+        model.playMatch(obj, 1, 4);
+        // the united team is absorbed in turn, under a new id and then under an old one
+        model.unite(obj, 3, 1, 7);
+        model.playMatch(obj, 7, 5);
+        model.playMatch(obj, 6, 7);
+        model.requireGames(obj);
+        model.unite(obj, 5, 7, 5);
+        model.playMatch(obj, 5, 4);
+        model.unite(obj, 4, 6, 8);
+        model.playMatch(obj, 8, 5);
+        model.unite(obj, 5, 8, 9);
+        model.addTeam(obj, 10);
+        model.playMatch(obj, 10, 9);
+        model.requireGames(obj);
+    }
+
+    SECTION("players removed from absorbed teams")
+    {
+        model.playMatch(obj, 1, 2);
+        model.unite(obj, 1, 2, 1);
+        model.playMatch(obj, 1, 3);
+        model.unite(obj, 3, 1, 3);
+        for (int i = 1; i < PLAYERS_PER_TEAM; i += 2)
+        {
+            model.removePlayer(obj, playerId(2, i));
+            model.removePlayer(obj, playerId(1, i));
+        }
+        model.requireGames(obj);
+        model.playMatch(obj, 3, 4);
+        // every player of the first team goes, the set it had stays for the others below it
+        for (int i = 0; i < PLAYERS_PER_TEAM; i += 2)
+            model.removePlayer(obj, playerId(1, i));
+        model.playMatch(obj, 3, 5);
+        model.requireGames(obj);
+
+        // a removed id comes back as a new player, without the games of the old one
+        model.addPlayer(obj, playerId(1, 1), 6, 2);
+        model.addPlayer(obj, playerId(2, 1), 3, 4);
+        model.playMatch(obj, 3, 6);
+        model.requireGames(obj);
+    }
+
+    SECTION("the surviving team removed")
+    {
+        model.playMatch(obj, 1, 2);
+        model.unite(obj, 1, 2, 2);
+        model.playMatch(obj, 2, 3);
+        model.unite(obj, 3, 2, 3);
+        model.requireGames(obj);
+
+        for (int team = 1; team <= 3; ++team)
+        {
+            for (int i = 0; i < PLAYERS_PER_TEAM; ++i)
+                model.removePlayer(obj, playerId(team, i));
+        }
+        REQUIRE(obj->remove_team(3) == StatusType::SUCCESS);
+        model.requireGames(obj);
+
+        // the id starts over with nothing of the old team's games
+        model.addTeam(obj, 3);
+        model.playMatch(obj, 3, 4);
+        model.requireGames(obj);
+
+        for (int team = 3; team <= 6; ++team)
+        {
+            for (int i = 0; i < PLAYERS_PER_TEAM; ++i)
+                model.removePlayer(obj, playerId(team, i));
+            REQUIRE(obj->remove_team(team) == StatusType::SUCCESS);
+        }
+        // every set went with the last player and team pointing to it
+        REQUIRE(allocator.getLive() == 0);
+    }
+
+    delete obj;
+    REQUIRE(allocator.getLive() == 0);
+}
@@ -0,0 +1,139 @@
+#include "catch.hpp"
+#include "worldcup23a1.h"
+#include "WorldTestUtil.h"
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    const int OPPONENT = 3;
+    const int OPPONENT_SIZE = 11;
+
+    void addPlayers(world_cup_t *world, int team, int count)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            int id = playerId(team, i);
+            REQUIRE(world->add_player(id, team, 1 + i % 4, (id * 7) % 13, id % 3, i == 0) == StatusType::SUCCESS);
+        }
+    }
+
+    void requireSameTeam(world_cup_t *expected, world_cup_t *actual, int team)
+    {
+        REQUIRE(expected->get_team_points(team).ans() == actual->get_team_points(team).ans());
+        REQUIRE(expected->get_top_scorer(team).ans() == actual->get_top_scorer(team).ans());
+        output_t<int> count1 = expected->get_all_players_count(team);
+        output_t<int> count2 = actual->get_all_players_count(team);
+        REQUIRE(count2.status() == StatusType::SUCCESS);
+        REQUIRE(count1.ans() == count2.ans());
+
+        vector<int> players1(count1.ans());
+        vector<int> players2(count2.ans());
+        REQUIRE(expected->get_all_players(team, players1.data()) == StatusType::SUCCESS);
+        REQUIRE(actual->get_all_players(team, players2.data()) == StatusType::SUCCESS);
+        REQUIRE(players1 == players2);
+        for (int id : players1)
+        {
+            REQUIRE(expected->get_num_played_games(id).ans() == actual->get_num_played_games(id).ans());
+            REQUIRE(expected->get_closest_player(id, team).ans() == actual->get_closest_player(id, team).ans());
+        }
+        REQUIRE(expected->knockout_winner(1, 100).ans() == actual->knockout_winner(1, 100).ans());
+    }
+
+    /*
+     * Unites teams 1 and 2 (size1 and size2 players, both play a match first if they can) into
+     * newTeam, and checks the result against a world where newTeam was added with all of their
+     * players right away. Then both play on under the new id and are checked again.
+     */
+    void checkUnite(int size1, int size2, int newTeam)
+    {
+        world_cup_t *tested = new world_cup_t();
+        REQUIRE(tested->add_team(1, 4) == StatusType::SUCCESS);
+        REQUIRE(tested->add_team(2, 7) == StatusType::SUCCESS);
+        REQUIRE(tested->add_team(OPPONENT, 0) == StatusType::SUCCESS);
+        addPlayers(tested, 1, size1);
+        addPlayers(tested, 2, size2);
+        addPlayers(tested, OPPONENT, OPPONENT_SIZE);
+        for (int team = 1; team <= 2; ++team)
+        {
+            StatusType expected = (team == 1 ? size1 : size2) >= 11 ? StatusType::SUCCESS : StatusType::FAILURE;
+            REQUIRE(tested->play_match(team, OPPONENT) == expected);
+        }
+
+        // the united team as it should be: every player with the games it has now
+        world_cup_t *reference = new world_cup_t();
+        int points = tested->get_team_points(1).ans() + tested->get_team_points(2).ans();
+        REQUIRE(reference->add_team(newTeam, points) == StatusType::SUCCESS);
+        REQUIRE(reference->add_team(OPPONENT, tested->get_team_points(OPPONENT).ans()) == StatusType::SUCCESS);
+        for (int team = 1; team <= 2; ++team)
+        {
+            for (int i = 0; i < (team == 1 ? size1 : size2); ++i)
+            {
+                int id = playerId(team, i);
+                REQUIRE(reference->add_player(id, newTeam, tested->get_num_played_games(id).ans(), (id * 7) % 13,
+                                              id % 3, i == 0) == StatusType::SUCCESS);
+            }
+        }
+        addPlayers(reference, OPPONENT, OPPONENT_SIZE);
+        for (int i = 0; i < OPPONENT_SIZE; ++i)
+        {
+            int id = playerId(OPPONENT, i);
+            int games = tested->get_num_played_games(id).ans() - reference->get_num_played_games(id).ans();
+            REQUIRE(reference->update_player_stats(id, games, 0, 0) == StatusType::SUCCESS);
+        }
+
+        REQUIRE(tested->unite_teams(1, 2, newTeam) == StatusType::SUCCESS);
+        for (int team : {1, 2})
+        {
+            if (team != newTeam)
+                REQUIRE(tested->get_team_points(team).status() == StatusType::FAILURE);
+        }
+        requireSameTeam(reference, tested, newTeam);
+
+        // games keep counting under the new id, for the players of either team
+        for (int match = 0; match < 3; ++match)
+        {
+            REQUIRE(tested->play_match(newTeam, OPPONENT) == StatusType::SUCCESS);
+            REQUIRE(reference->play_match(newTeam, OPPONENT) == StatusType::SUCCESS);
+        }
+        int scorer = (size1 > 0) ? playerId(1, 0) : playerId(2, 0);
+        REQUIRE(tested->update_player_stats(scorer, 1, 20, 0) == StatusType::SUCCESS);
+        REQUIRE(reference->update_player_stats(scorer, 1, 20, 0) == StatusType::SUCCESS);
+        requireSameTeam(reference, tested, newTeam);
+
+        delete reference;
+        delete tested;
+    }
+}
+
+TEST_CASE("unite teams")
+{
+    SECTION("the first team is the larger one")
+    {
+        checkUnite(16, 11, 1);
+        checkUnite(16, 11, 2);
+        checkUnite(16, 11, 40);
+        checkUnite(20, 2, 2);
+    }
+
+    SECTION("the second team is the larger one")
+    {
+        checkUnite(11, 16, 1);
+        checkUnite(11, 16, 2);
+        checkUnite(11, 16, 40);
+        checkUnite(2, 20, 1);
+    }
+
+    SECTION("teams of the same size")
+    {
+        checkUnite(11, 11, 1);
+        checkUnite(11, 11, 2);
+    }
+
+    SECTION("an empty team")
+    {
+        checkUnite(0, 12, 1);
+        checkUnite(12, 0, 2);
+    }
+}
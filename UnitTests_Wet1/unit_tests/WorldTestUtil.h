@@ -0,0 +1,79 @@
+#ifndef WORLD_TEST_UTIL_H_
+#define WORLD_TEST_UTIL_H_
+
+#include "catch.hpp"
+#include "worldcup23a1.h"
+#include <vector>
+
+/*
+ * Helpers shared by the world tests
+ */
+
+inline int playerId(int team, int i)
+{
+    return team * 100 + i;
+}
+
+/**
+ * Requires both worlds to answer every query alike: the team queries for teams -1..maxTeamId (all
+ * players for -1), games and closest players of playerId(team, 0..playersPerTeam - 1), and knockouts
+ * over ranges of those teams.
+ * @param maxTeamId - unite_teams may give the united team an id past the ones added
+ */
+inline void requireSameState(world_cup_t *expected, world_cup_t *actual, int maxTeamId, int playersPerTeam)
+{
+    for (int team = -1; team <= maxTeamId; ++team)
+    {
+        if (team == 0)
+            continue;
+        if (team > 0)
+        {
+            output_t<int> points1 = expected->get_team_points(team);
+            output_t<int> points2 = actual->get_team_points(team);
+            REQUIRE(points1.status() == points2.status());
+            REQUIRE(points1.ans() == points2.ans());
+        }
+
+        output_t<int> scorer1 = expected->get_top_scorer(team);
+        output_t<int> scorer2 = actual->get_top_scorer(team);
+        REQUIRE(scorer1.status() == scorer2.status());
+        REQUIRE(scorer1.ans() == scorer2.ans());
+
+        output_t<int> count1 = expected->get_all_players_count(team);
+        output_t<int> count2 = actual->get_all_players_count(team);
+        REQUIRE(count1.status() == count2.status());
+        REQUIRE(count1.ans() == count2.ans());
+        if (count1.status() == StatusType::SUCCESS && count1.ans() > 0)
+        {
+            std::vector<int> players1(count1.ans());
+            std::vector<int> players2(count2.ans());
+            REQUIRE(expected->get_all_players(team, players1.data()) == StatusType::SUCCESS);
+            REQUIRE(actual->get_all_players(team, players2.data()) == StatusType::SUCCESS);
+            REQUIRE(players1 == players2);
+        }
+    }
+    for (int team = 1; team <= maxTeamId; ++team)
+    {
+        for (int i = 0; i < playersPerTeam; ++i)
+        {
+            output_t<int> games1 = expected->get_num_played_games(playerId(team, i));
+            output_t<int> games2 = actual->get_num_played_games(playerId(team, i));
+            REQUIRE(games1.status() == games2.status());
+            REQUIRE(games1.ans() == games2.ans());
+
+            output_t<int> closest1 = expected->get_closest_player(playerId(team, i), team);
+            output_t<int> closest2 = actual->get_closest_player(playerId(team, i), team);
+            REQUIRE(closest1.status() == closest2.status());
+            REQUIRE(closest1.ans() == closest2.ans());
+        }
+    }
+    for (int first = 0; first <= maxTeamId; first += 3)
+    {
+        output_t<int> winner1 = expected->knockout_winner(first, maxTeamId - first / 2);
+        output_t<int> winner2 = actual->knockout_winner(first, maxTeamId - first / 2);
+        REQUIRE(winner1.status() == winner2.status());
+        REQUIRE(winner1.ans() == winner2.ans());
+    }
+}
+
+#endif //WORLD_TEST_UTIL_H_
@@ -1,63 +1,70 @@
 #!/usr/bin/env bash
 
-green=`tput setaf 2`
-yellow=`tput setaf 3`
-reset=`tput sgr0`
+# usage: ./unit_test_runner.sh [--no-compile] [--no-run] [--valgrind]
+#   compiles and runs the tests by default, no questions asked
 
+green=`tput setaf 2 2>/dev/null`
+yellow=`tput setaf 3 2>/dev/null`
+reset=`tput sgr0 2>/dev/null`
 
-function checkanswer {
-    if [ "$1" != "y" ] && [ "$1" != "n" ]
-    then
-        echo "${yellow}bad input, please run again (make sure you use lowercase 'y' and 'n' only)${reset}"
-        echo "${green}finish${reset}"
-        exit
-    fi    
-}
-
-#-------------------------------------------------------------------------------
-
-compile_q="${yellow}compile? [y\n]${reset}"
-run_q="${yellow}run? [y\n]${reset}"
-valgrind_q="${yellow}with valgrind? [y\n]${reset}"
+compile_var="y"
+run_var="y"
+val_var="n"
 
-echo $compile_q
-read compile_var
-checkanswer $compile_var $compile_q
+for arg in "$@"
+do
+    case "$arg" in
+        --no-compile) compile_var="n" ;;
+        --no-run) run_var="n" ;;
+        --valgrind) val_var="y" ;;
+        *)
+            echo "${yellow}usage: $0 [--no-compile] [--no-run] [--valgrind]${reset}"
+            exit 2
+            ;;
+    esac
+done
 
-echo $run_q
-read run_var
-checkanswer $run_var $run_q
-if [ "$run_var" == "y" ]
-then
-    echo $valgrind_q
-    read val_var
-    checkanswer $val_var $valgrind_q
-fi
+#-------------------------------------------------------------------------------
 
 if [ "$compile_var" == "y" ]
 then
     rm -f unit_test_exec
+    tests=(./unit_tests/*.cpp)
+    tools=()
+    tools_dir="$(dirname "$0")/../Tools"
+    if [ -e "$tools_dir/Simulator.cpp" ]
+    then
+        # the simulator tests also need the simulator from the repository's Tools
+        tools=(-I"$tools_dir" "$tools_dir/Simulator.cpp" "$tools_dir/WorkStealingPool.cpp")
+    else
+        echo "${yellow}no Tools folder next to this one - skipping the simulator tests${reset}"
+        tests=(${tests[@]/*SimulatorTests.cpp/})
+    fi
     echo "${yellow}compiling${reset}"
-    g++ -std=c++11 -g -Wall -Werror -pedantic-errors -ggdb3 -DNDEBUG ./unit_tests/*.cpp ./*.cpp -o unit_test_exec
+    g++ -std=c++11 -g -Wall -Werror -pedantic-errors -ggdb3 -DNDEBUG -pthread -I. "${tools[@]}" "${tests[@]}" ./*.cpp \
+        -o unit_test_exec || exit 1
 fi
 
+status=0
 if [ "$run_var" == "y" ]
 then
     if [ -e ./unit_test_exec ]
     then
     if [ "$val_var" == "y" ]
-    then    
-        echo "${yellow}running with valgrind${reset}"
-        valgrind --leak-check=full -s ./unit_test_exec
-    elif [ "$val_var" == "n" ]
     then
+        echo "${yellow}running with valgrind${reset}"
+        valgrind --leak-check=full -s --error-exitcode=1 ./unit_test_exec
+        status=$?
+    else
         echo "${yellow}running${reset}"
         ./unit_test_exec
+        status=$?
     fi
     else
         echo "${yellow}can't run - no executable present${reset}"
+        status=1
     fi
 fi
 
 echo "${green}finish${reset}"
-
+exit $status
@@ -0,0 +1,282 @@
+#include "catch.hpp"
+#include "wet2util_override.h"
+#include "worldcup23a2.h"
+#include "WorldTestUtil.h"
+#include <cstdio>
+#include <functional>
+
+using namespace std;
+
+namespace
+{
+    const int TEAMS = 8;
+    const int PLAYERS_PER_TEAM = 4;
+
+    /*
+     * Runs operation on tested with the k-th allocation failing, for k = 0, 1, ... until it gets
+     * through. Every failure has to leave tested like expected, then expected catches up.
+     * @return the number of failures injected
+     */
+    int failEveryAllocation(CountingAllocator &allocator, world_cup_t *expected, world_cup_t *tested,
+                            const function<StatusType(world_cup_t *)> &operation)
+    {
+        int failures = 0;
+        while (true)
+        {
+            allocator.failAfter(failures);
+            StatusType status = operation(tested);
+            allocator.failAfter(-1);
+            if (status != StatusType::ALLOCATION_ERROR)
+            {
+                REQUIRE(status == operation(expected));
+                requireSameState(expected, tested, TEAMS, PLAYERS_PER_TEAM);
+                return failures;
+            }
+            requireSameState(expected, tested, TEAMS, PLAYERS_PER_TEAM);
+            failures++;
+        }
+    }
+}
+
+TEST_CASE("allocator")
+{
+    SECTION("counts the allocations of every operation")
+    {
+        CountingAllocator allocator;
+        world_cup_t *obj = new world_cup_t(allocator);
+        uint64_t before = allocator.getAllocations();
+        REQUIRE(obj->add_team(1) == StatusType::SUCCESS);
+        // the team and a node in each of the two team trees
+        REQUIRE(allocator.getAllocations() - before == 3);
+
+        int spirit[5] = {0, 1, 2, 3, 4};
+        before = allocator.getAllocations();
+        REQUIRE(obj->add_player(1, 1, permutation_t(spirit), 0, 5, 0, true) == StatusType::SUCCESS);
+        REQUIRE(allocator.getAllocations() - before >= 2);
+
+        before = allocator.getAllocations();
+        REQUIRE(obj->play_match(1, 1).status() == StatusType::INVALID_INPUT);
+        REQUIRE(obj->get_team_points(1).status() == StatusType::SUCCESS);
+        REQUIRE(allocator.getAllocations() == before);
+
+        delete obj;
+        REQUIRE(allocator.getLive() == 0);
+        REQUIRE(allocator.getLiveBytes() == 0);
+    }
+
+    SECTION("allocation failures roll back")
+    {
+        CountingAllocator allocator;
+        world_cup_t *expected = new world_cup_t();
+        world_cup_t *tested = new world_cup_t(allocator);
+        int spirit[5] = {3, 1, 4, 0, 2};
+        int failures = 0;
+
+        for (int team = 1; team <= TEAMS; ++team)
+        {
+            failures += failEveryAllocation(allocator, expected, tested, [team](world_cup_t *world)
+            {
+                return world->add_team(team);
+            });
+            for (int i = 0; i < PLAYERS_PER_TEAM; ++i)
+            {
+                permutation_t permutation(spirit);
+                failures += failEveryAllocation(allocator, expected, tested, [team, i, permutation](world_cup_t *world)
+                {
+                    return world->add_player(playerId(team, i), team, permutation, i, team - 2 * i, i, i == 0);
+                });
+                int first = spirit[0];
+                for (int j = 0; j < 4; ++j)
+                    spirit[j] = spirit[j + 1];
+                spirit[4] = first;
+            }
+        }
+        REQUIRE(failures > 0);
+
+        REQUIRE(expected->play_match(1, 2).status() == tested->play_match(1, 2).status());
+        failEveryAllocation(allocator, expected, tested, [](world_cup_t *world)
+        {
+            return world->buy_team(1, 2);
+        });
+        failEveryAllocation(allocator, expected, tested, [](world_cup_t *world)
+        {
+            return world->buy_team(3, 1);
+        });
+        failEveryAllocation(allocator, expected, tested, [](world_cup_t *world)
+        {
+            return world->remove_team(4);
+        });
+        failEveryAllocation(allocator, expected, tested, [](world_cup_t *world)
+        {
+            return world->add_team(4);
+        });
+
+        const char *path = "allocator_test.img";
+        REQUIRE(failEveryAllocation(allocator, expected, tested, [path](world_cup_t *world)
+        {
+            return world->saveSnapshot(path);
+        }) > 0);
+        remove(path);
+
+        delete tested;
+        delete expected;
+        REQUIRE(allocator.getLive() == 0);
+        REQUIRE(allocator.getLiveBytes() == 0);
+    }
+}
+
+TEST_CASE("slab allocator")
+{
+    CountingAllocator backing;
+
+    SECTION("packs small objects and reuses freed ones")
+    {
+        SlabAllocator slabs(backing);
+        char *first = static_cast<char *>(slabs.allocate(40));
+        char *second = static_cast<char *>(slabs.allocate(40));
+        REQUIRE(second - first == 48);
+        REQUIRE(reinterpret_cast<uintptr_t>(first) % SlabAllocator::GRANULE == 0);
+        REQUIRE(backing.getAllocations() == 1);
+
+        slabs.deallocate(first, 40);
+        REQUIRE(slabs.allocate(33) == first);
+
+        // other sizes get slabs of their own
+        char *other = static_cast<char *>(slabs.allocate(8));
+        REQUIRE(backing.getAllocations() == 2);
+        slabs.deallocate(other, 8);
+    }
+
+    SECTION("tracks large blocks")
+    {
+        SlabAllocator slabs(backing);
+        void *table = slabs.allocate(4096);
+        void *other = slabs.allocate(1000);
+        REQUIRE(backing.getLive() == 2);
+        slabs.deallocate(table, 4096);
+        REQUIRE(backing.getLive() == 1);
+        slabs.release();
+        REQUIRE(backing.getLive() == 0);
+        REQUIRE(slabs.getReservedBytes() == 0);
+        (void) other;
+    }
+
+    SECTION("recycles slabs")
+    {
+        SlabAllocator slabs(backing);
+        for (int i = 0; i < 1000; ++i)
+            slabs.allocate(48);
+        slabs.allocate(1000);
+        uint64_t reserved = slabs.getReservedBytes();
+        uint64_t allocations = backing.getAllocations();
+
+        slabs.recycle();
+        REQUIRE(slabs.getReservedBytes() < reserved);
+        for (int i = 0; i < 500; ++i)
+            slabs.allocate(96);
+        // the large block is the only thing given back, the slabs serve any size
+        REQUIRE(backing.getAllocations() == allocations);
+        slabs.release();
+        REQUIRE(backing.getLive() == 0);
+    }
+
+    SECTION("releases everything at once")
+    {
+        {
+            SlabAllocator slabs(backing);
+            world_cup_t *obj = new world_cup_t(slabs);
+            int spirit[5] = {0, 1, 2, 3, 4};
+            for (int team = 1; team <= 50; ++team)
+            {
+                REQUIRE(obj->add_team(team) == StatusType::SUCCESS);
+                for (int i = 0; i < 20; ++i)
+                    REQUIRE(obj->add_player(playerId(team, i), team, permutation_t(spirit), i, i, 0, i == 0)
+                            == StatusType::SUCCESS);
+            }
+            REQUIRE(obj->buy_team(1, 2) == StatusType::SUCCESS);
+            REQUIRE(obj->remove_team(3) == StatusType::SUCCESS);
+            // slabs double, so there are few of them
+            REQUIRE(backing.getLive() < 40);
+            delete obj;
+            REQUIRE(slabs.getReservedBytes() > 0);
+        }
+        REQUIRE(backing.getLive() == 0);
+    }
+}
+
+namespace
+{
+    void buildWorld(world_cup_t *obj, int teams)
+    {
+        int spirit[5] = {2, 0, 1, 4, 3};
+        for (int team = 1; team <= teams; ++team)
+        {
+            REQUIRE(obj->add_team(team) == StatusType::SUCCESS);
+            for (int i = 0; i < PLAYERS_PER_TEAM; ++i)
+                REQUIRE(obj->add_player(playerId(team, i), team, permutation_t(spirit), i, team + i, i, i == 1)
+                        == StatusType::SUCCESS);
+        }
+        REQUIRE(obj->play_match(1, 2).status() == StatusType::SUCCESS);
+        REQUIRE(obj->buy_team(3, 4) == StatusType::SUCCESS);
+    }
+}
+
+TEST_CASE("reset")
+{
+    SECTION("a world with its own slabs")
+    {
+        world_cup_t *obj = new world_cup_t();
+        world_cup_t *fresh = new world_cup_t();
+        for (int run = 0; run < 3; ++run)
+        {
+            buildWorld(obj, TEAMS);
+            obj->reset();
+            REQUIRE(obj->get_team_points(1).status() == StatusType::FAILURE);
+            REQUIRE(obj->get_ith_pointless_ability(0).status() == StatusType::FAILURE);
+            REQUIRE(obj->num_played_games_for_player(playerId(1, 0)).status() == StatusType::FAILURE);
+        }
+        buildWorld(obj, TEAMS);
+        buildWorld(fresh, TEAMS);
+        requireSameState(fresh, obj, TEAMS, PLAYERS_PER_TEAM);
+        delete fresh;
+        delete obj;
+    }
+
+    SECTION("a world with an allocator gives everything back")
+    {
+        CountingAllocator allocator;
+        world_cup_t *obj = new world_cup_t(allocator);
+        buildWorld(obj, TEAMS);
+        obj->reset();
+        REQUIRE(allocator.getLive() == 0);
+
+        world_cup_t *fresh = new world_cup_t();
+        buildWorld(obj, TEAMS - 2);
+        buildWorld(fresh, TEAMS - 2);
+        requireSameState(fresh, obj, TEAMS, PLAYERS_PER_TEAM);
+        delete fresh;
+        delete obj;
+        REQUIRE(allocator.getLive() == 0);
+    }
+
+    SECTION("a loaded world")
+    {
+        const char *path = "reset_test.img";
+        world_cup_t *obj = new world_cup_t();
+        buildWorld(obj, TEAMS);
+        REQUIRE(obj->saveSnapshot(path) == StatusType::SUCCESS);
+        delete obj;
+
+        obj = world_cup_t::loadSnapshot(path);
+        remove(path);
+        REQUIRE(obj != nullptr);
+        obj->reset();
+        REQUIRE(obj->num_played_games_for_player(playerId(1, 0)).status() == StatusType::FAILURE);
+        world_cup_t *fresh = new world_cup_t();
+        buildWorld(obj, TEAMS);
+        buildWorld(fresh, TEAMS);
+        requireSameState(fresh, obj, TEAMS, PLAYERS_PER_TEAM);
+        delete fresh;
+        delete obj;
+    }
+}
@@ -0,0 +1,173 @@
+#include "catch.hpp"
+#include "PersistentAVLTree.h"
+#include "Allocator.h"
+#include <map>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    typedef PersistentAVLTree<int, int> Tree;
+
+    void requireSame(const map<int, int> &expected, const Tree &tree)
+    {
+        REQUIRE(tree.getSize() == (int) expected.size());
+        vector<int> values(expected.size());
+        tree.arrayInOrder(values.data());
+        int k = 0;
+        for (map<int, int>::const_iterator it = expected.begin(); it != expected.end(); ++it, ++k)
+        {
+            REQUIRE(values[k] == it->second);
+            REQUIRE(tree.find(it->first) != nullptr);
+            REQUIRE(*tree.find(it->first) == it->second);
+            REQUIRE(*tree.select(k) == it->second);
+        }
+        REQUIRE(tree.select(k) == nullptr);
+        REQUIRE(tree.select(-1) == nullptr);
+    }
+
+    // a key order that makes both single and double rotations
+    int scrambled(int i)
+    {
+        return (i * 37) % 101;
+    }
+}
+
+TEST_CASE("persistent avl tree")
+{
+    CountingAllocator allocator;
+
+    SECTION("versions change independently")
+    {
+        {
+            Tree tree(allocator);
+            map<int, int> expected;
+            vector<Tree> versions;
+            vector<map<int, int> > expectedVersions;
+            for (int i = 0; i < 101; ++i)
+            {
+                tree.insert(scrambled(i), i);
+                expected[scrambled(i)] = i;
+                if (i % 10 == 0)
+                {
+                    versions.push_back(tree.fork());
+                    expectedVersions.push_back(expected);
+                }
+            }
+            REQUIRE_THROWS_AS(tree.insert(5, 0), Tree::KeyExists);
+            requireSame(expected, tree);
+
+            Tree other = tree;
+            for (int i = 0; i < 101; i += 3)
+            {
+                other.remove(scrambled(i));
+                expected.erase(scrambled(i));
+            }
+            REQUIRE_THROWS_AS(other.remove(scrambled(0)), Tree::KeyDoesNotExist);
+            for (int i = 1; i < 101; i += 3)
+            {
+                other.update(scrambled(i), -i);
+                expected[scrambled(i)] = -i;
+            }
+            REQUIRE_THROWS_AS(other.update(scrambled(0), 1), Tree::KeyDoesNotExist);
+            requireSame(expected, other);
+
+            REQUIRE(tree.getSize() == 101);
+            REQUIRE(*tree.find(scrambled(1)) == 1);
+            for (size_t i = 0; i < versions.size(); ++i)
+            {
+                requireSame(expectedVersions[i], versions[i]);
+            }
+
+            // dropping the old versions keeps the newer ones whole
+            versions.clear();
+            tree = Tree(allocator);
+            REQUIRE(tree.getSize() == 0);
+            requireSame(expected, other);
+        }
+        REQUIRE(allocator.getLive() == 0);
+    }
+
+    SECTION("a mutation copies O(log n) nodes")
+    {
+        Tree tree(allocator);
+        for (int i = 0; i < 4096; ++i)
+        {
+            tree.insert(i, i);
+        }
+        Tree old = tree.fork();
+        uint64_t before = allocator.getLive();
+
+        uint64_t allocations = allocator.getAllocations();
+        tree.update(1234, 0);
+        // the path, 13 nodes at most for 4096 keys
+        REQUIRE(allocator.getAllocations() - allocations <= 13);
+        allocations = allocator.getAllocations();
+        tree.insert(5000, 0);
+        REQUIRE(allocator.getAllocations() - allocations <= 3 * 14);
+        allocations = allocator.getAllocations();
+        tree.remove(2000);
+        REQUIRE(allocator.getAllocations() - allocations <= 3 * 14);
+
+        REQUIRE(*old.find(1234) == 1234);
+        REQUIRE(old.find(5000) == nullptr);
+        REQUIRE(*old.find(2000) == 2000);
+        // the versions share all but the copied paths
+        REQUIRE(allocator.getLive() - before <= 3 * 13 + 2 * 3 * 14);
+
+        old = tree;
+        tree.remove(0);
+        REQUIRE(old.getSize() == 4096);
+        REQUIRE(tree.getSize() == 4095);
+    }
+
+    SECTION("a failed mutation leaves the tree unchanged")
+    {
+        {
+            Tree tree(allocator);
+            map<int, int> expected;
+            for (int i = 0; i < 50; ++i)
+            {
+                tree.insert(scrambled(i), i);
+                expected[scrambled(i)] = i;
+            }
+            Tree old = tree.fork();
+
+            int failures = 0;
+            for (int i = 50; i < 101; ++i)
+            {
+                for (long allowed = 0; ; ++allowed)
+                {
+                    allocator.failAfter(allowed);
+                    try
+                    {
+                        if (i % 3 == 0)
+                            tree.remove(scrambled(i - 50));
+                        else if (i % 3 == 1)
+                            tree.update(scrambled(i - 50), -i);
+                        else
+                            tree.insert(scrambled(i), i);
+                        break;
+                    }
+                    catch (const std::bad_alloc &e)
+                    {
+                        failures++;
+                        requireSame(expected, tree);
+                    }
+                }
+                allocator.failAfter(-1);
+                if (i % 3 == 0)
+                    expected.erase(scrambled(i - 50));
+                else if (i % 3 == 1)
+                    expected[scrambled(i - 50)] = -i;
+                else
+                    expected[scrambled(i)] = i;
+                requireSame(expected, tree);
+            }
+            REQUIRE(failures > 50);
+            REQUIRE(old.getSize() == 50);
+        }
+        REQUIRE(allocator.getLive() == 0);
+    }
+}
@@ -0,0 +1,182 @@
+#include "catch.hpp"
+#include "wet2util_override.h"
+#include "worldcup23a2.h"
+#include "Simulator.h"
+#include "WorkStealingPool.h"
+#include <atomic>
+#include <stdexcept>
+
+using namespace std;
+
+namespace
+{
+    world_cup_t *buildLeague(int teams)
+    {
+        world_cup_t *obj = new world_cup_t();
+        int spirit[5] = {4, 2, 0, 1, 3};
+        for (int team = 1; team <= teams; ++team)
+        {
+            REQUIRE(obj->add_team(team) == StatusType::SUCCESS);
+            for (int i = 0; i < 3; ++i)
+                REQUIRE(obj->add_player(team * 10 + i, team, permutation_t(spirit), i, (team * 7 + i) % 11, 0, i == 0)
+                        == StatusType::SUCCESS);
+        }
+        // a team without a goal keeper never plays
+        REQUIRE(obj->add_team(1000) == StatusType::SUCCESS);
+        REQUIRE(obj->play_match(1, 2).status() == StatusType::SUCCESS);
+        return obj;
+    }
+
+    void requireSameResult(const SimulationResult &a, const SimulationResult &b)
+    {
+        REQUIRE(a.runs == b.runs);
+        REQUIRE(a.matchesPlayed == b.matchesPlayed);
+        REQUIRE(a.matchesFailed == b.matchesFailed);
+        REQUIRE(a.buys == b.buys);
+        REQUIRE(a.teams.size() == b.teams.size());
+        for (size_t i = 0; i < a.teams.size(); ++i)
+        {
+            REQUIRE(a.teams[i].teamId == b.teams[i].teamId);
+            REQUIRE(a.teams[i].bought == b.teams[i].bought);
+            REQUIRE(a.teams[i].points.getRuns() == b.teams[i].points.getRuns());
+            for (int points = a.teams[i].points.getMin(); points <= a.teams[i].points.getMax(); ++points)
+                REQUIRE(a.teams[i].points.getCount(points) == b.teams[i].points.getCount(points));
+        }
+    }
+}
+
+TEST_CASE("work stealing pool")
+{
+    SECTION("runs every task, also ones submitted by tasks")
+    {
+        WorkStealingPool pool(4);
+        REQUIRE(pool.getThreadCount() == 4);
+        // Catch is not thread safe, the tasks only count
+        atomic<int> done(0);
+        atomic<int> outside(0);
+        for (int i = 0; i < 200; ++i)
+        {
+            pool.submit([&pool, &done, &outside]()
+                        {
+                            if (WorkStealingPool::currentWorker() < 0)
+                                outside++;
+                            pool.submit([&done]() { done++; });
+                            done++;
+                        });
+        }
+        pool.wait();
+        REQUIRE(done == 400);
+        REQUIRE(outside == 0);
+        REQUIRE(WorkStealingPool::currentWorker() == -1);
+    }
+
+    SECTION("rethrows from wait")
+    {
+        WorkStealingPool pool(2);
+        atomic<int> done(0);
+        for (int i = 0; i < 10; ++i)
+        {
+            pool.submit([i, &done]()
+                        {
+                            done++;
+                            if (i == 3)
+                                throw runtime_error("task");
+                        });
+        }
+        REQUIRE_THROWS_AS(pool.wait(), runtime_error);
+        REQUIRE(done == 10);
+        pool.wait();
+    }
+}
+
+TEST_CASE("point histogram")
+{
+    PointHistogram a, b;
+    for (int points = 10; points < 20; ++points)
+        a.add(points);
+    b.add(5);
+    b.add(25);
+    b.add(12);
+    a.merge(b);
+    REQUIRE(a.getRuns() == 13);
+    REQUIRE(a.getMin() == 5);
+    REQUIRE(a.getMax() == 25);
+    REQUIRE(a.getCount(12) == 2);
+    REQUIRE(a.getCount(21) == 0);
+    REQUIRE(a.percentile(0) == 5);
+    REQUIRE(a.percentile(0.5) == 14);
+    REQUIRE(a.percentile(1) == 25);
+}
+
+TEST_CASE("simulator")
+{
+    world_cup_t *league = buildLeague(12);
+    Simulator simulator(*league);
+    REQUIRE(simulator.getTeamIds().size() == 13);
+    REQUIRE(simulator.getTeamIds().front() == 1);
+    REQUIRE(simulator.getTeamIds().back() == 1000);
+
+    SECTION("forks are independent of each other and of the league")
+    {
+        world_cup_t *fork = simulator.fork();
+        REQUIRE(fork->get_team_points(1).ans() == 3);
+        REQUIRE(fork->play_match(1, 3).status() == StatusType::SUCCESS);
+        REQUIRE(fork->buy_team(4, 5) == StatusType::SUCCESS);
+        REQUIRE(fork->num_played_games_for_player(50).ans() == 0);
+
+        world_cup_t *other = simulator.fork();
+        REQUIRE(other->get_team_points(5).status() == StatusType::SUCCESS);
+        REQUIRE(other->num_played_games_for_player(10).ans() == league->num_played_games_for_player(10).ans());
+        REQUIRE(league->get_team_points(5).status() == StatusType::SUCCESS);
+        delete other;
+        delete fork;
+    }
+
+    SECTION("the result does not depend on the threads")
+    {
+        SimulationConfig config = defaultSimulationConfig();
+        config.runs = 300;
+        config.events = 40;
+        config.buyChance = 0.1;
+        config.seed = 7;
+        config.runsPerTask = 7;
+
+        config.threads = 1;
+        SimulationResult single = simulator.run(config);
+        config.threads = 4;
+        SimulationResult parallel = simulator.run(config);
+        requireSameResult(single, parallel);
+
+        REQUIRE(single.runs == 300);
+        REQUIRE(single.buys > 0);
+        REQUIRE(single.matchesFailed > 0);
+        for (size_t i = 0; i < single.teams.size(); ++i)
+        {
+            const TeamOutcome &team = single.teams[i];
+            REQUIRE(team.points.getRuns() + team.bought == single.runs);
+            if (team.points.getRuns() > 0)
+                REQUIRE(team.points.getMin() >= team.startPoints);
+        }
+        REQUIRE(single.find(1)->startPoints == 3);
+        REQUIRE(single.find(999) == nullptr);
+
+        config.seed = 8;
+        SimulationResult other = simulator.run(config);
+        REQUIRE(other.matchesPlayed + other.matchesFailed + other.buys != 0);
+    }
+
+    SECTION("without buys every team is in every run")
+    {
+        SimulationConfig config = defaultSimulationConfig();
+        config.runs = 50;
+        config.events = 20;
+        config.threads = 2;
+        SimulationResult result = simulator.run(config);
+        REQUIRE(result.buys == 0);
+        for (size_t i = 0; i < result.teams.size(); ++i)
+            REQUIRE(result.teams[i].points.getRuns() == 50);
+        REQUIRE(result.find(1000)->points.getMax() == 0);
+    }
+
+    delete league;
+}
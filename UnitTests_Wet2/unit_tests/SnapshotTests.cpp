@@ -0,0 +1,346 @@
+#include "catch.hpp"
+#include "wet2util_override.h"
+#include "worldcup23a2.h"
+#include "WorldTestUtil.h"
+#include "SnapshotImage.h"
+#include "SpiritPacking.h"
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    const char *SNAPSHOT_PATH = "snapshot_test.img";
+    const int TEAMS = 6;
+    const int PLAYERS_PER_TEAM = 5;
+
+    world_cup_t *buildLeague()
+    {
+        world_cup_t *obj = new world_cup_t();
+        int spirit[5] = {1, 0, 2, 4, 3};
+        for (int team = 1; team <= TEAMS; ++team)
+        {
+            REQUIRE(obj->add_team(team) == StatusType::SUCCESS);
+            for (int i = 0; i < PLAYERS_PER_TEAM; ++i)
+            {
+                int id = playerId(team, i);
+                REQUIRE(obj->add_player(id, team, permutation_t(spirit), i, team * 3 - i, i % 2, i == 0)
+                        == StatusType::SUCCESS);
+                int first = spirit[0];
+                for (int j = 0; j < 4; ++j)
+                    spirit[j] = spirit[j + 1];
+                spirit[4] = first;
+            }
+        }
+        REQUIRE(obj->play_match(1, 2).status() == StatusType::SUCCESS);
+        REQUIRE(obj->buy_team(3, 4) == StatusType::SUCCESS);
+        REQUIRE(obj->play_match(3, 5).status() == StatusType::SUCCESS);
+        REQUIRE(obj->buy_team(6, 3) == StatusType::SUCCESS);
+        REQUIRE(obj->remove_team(2) == StatusType::SUCCESS);
+        return obj;
+    }
+
+    vector<char> readImage(const char *path)
+    {
+        ifstream in(path, ios::binary);
+        return vector<char>(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    }
+
+    void writeImage(const char *path, const vector<char> &image)
+    {
+        ofstream out(path, ios::binary | ios::trunc);
+        out.write(image.data(), image.size());
+    }
+
+    /*
+     * Writes image with one field changed by corrupt and requires that it is not loaded
+     */
+    void requireRejected(const vector<char> &image,
+                         const function<void(SnapshotHeader *, TeamImage *, uint32_t *, PlayerImage *)> &corrupt)
+    {
+        vector<char> copy(image);
+        SnapshotHeader *header = reinterpret_cast<SnapshotHeader *>(copy.data());
+        corrupt(header, reinterpret_cast<TeamImage *>(copy.data() + header->teamsOffset),
+                reinterpret_cast<uint32_t *>(copy.data() + header->abilityOffset),
+                reinterpret_cast<PlayerImage *>(copy.data() + header->playersOffset));
+        writeImage(SNAPSHOT_PATH, copy);
+        REQUIRE(world_cup_t::loadSnapshot(SNAPSHOT_PATH) == nullptr);
+    }
+
+    /*
+     * Writes image with one player record changed by corrupt, which returns the record's slot. The
+     * image still loads, but the player is not found, and every other player is.
+     */
+    void requireUnreadable(const vector<char> &image,
+                           const function<int32_t(SnapshotHeader *, PlayerImage *)> &corrupt)
+    {
+        vector<char> copy(image);
+        SnapshotHeader *header = reinterpret_cast<SnapshotHeader *>(copy.data());
+        PlayerImage *players = reinterpret_cast<PlayerImage *>(copy.data() + header->playersOffset);
+        int32_t slot = corrupt(header, players);
+        int id = players[slot].id;
+        writeImage(SNAPSHOT_PATH, copy);
+
+        world_cup_t *loaded = world_cup_t::loadSnapshot(SNAPSHOT_PATH);
+        REQUIRE(loaded != nullptr);
+        if (id > 0)
+            REQUIRE(loaded->num_played_games_for_player(id).status() == StatusType::FAILURE);
+        const PlayerImage *original = reinterpret_cast<const PlayerImage *>(image.data() + header->playersOffset);
+        for (uint32_t other = 0; other < header->playerSlots; ++other)
+        {
+            if (original[other].id == 0)
+                continue;
+            // the players below the corrupt one are not found either
+            int32_t ancestor = (int32_t) other;
+            while (ancestor >= 0 && ancestor != slot)
+                ancestor = original[ancestor].parent;
+            if (ancestor < 0)
+                REQUIRE(loaded->num_played_games_for_player(original[other].id).status() == StatusType::SUCCESS);
+        }
+        // saving leaves the corrupt player out
+        REQUIRE(loaded->saveSnapshot(SNAPSHOT_PATH) == StatusType::SUCCESS);
+        delete loaded;
+        loaded = world_cup_t::loadSnapshot(SNAPSHOT_PATH);
+        REQUIRE(loaded != nullptr);
+        delete loaded;
+    }
+
+    // slot of a player, or of the first player that has a parent
+    int32_t findSlot(const SnapshotHeader *header, const PlayerImage *players, bool withParent)
+    {
+        for (uint32_t slot = 0; slot < header->playerSlots; ++slot)
+        {
+            if (players[slot].id != 0 && (!withParent || players[slot].parent >= 0))
+                return (int32_t) slot;
+        }
+        return -1;
+    }
+}
+
+TEST_CASE("snapshot")
+{
+    SECTION("save and load an empty world")
+    {
+        world_cup_t *obj = new world_cup_t();
+        REQUIRE(obj->saveSnapshot(SNAPSHOT_PATH, 5) == StatusType::SUCCESS);
+        uint64_t sequence = 0;
+        world_cup_t *loaded = world_cup_t::loadSnapshot(SNAPSHOT_PATH, &sequence);
+        REQUIRE(loaded != nullptr);
+        REQUIRE(sequence == 5);
+        REQUIRE(loaded->get_ith_pointless_ability(0).status() == StatusType::FAILURE);
+        REQUIRE(loaded->add_team(1) == StatusType::SUCCESS);
+
+        delete obj;
+        delete loaded;
+        std::remove(SNAPSHOT_PATH);
+    }
+
+    SECTION("loaded world answers like the original")
+    {
+        world_cup_t *obj = buildLeague();
+        REQUIRE(obj->saveSnapshot(SNAPSHOT_PATH) == StatusType::SUCCESS);
+        world_cup_t *loaded = world_cup_t::loadSnapshot(SNAPSHOT_PATH);
+        REQUIRE(loaded != nullptr);
+        requireSameState(obj, loaded, TEAMS, PLAYERS_PER_TEAM);
+
+        delete obj;
+        delete loaded;
+        std::remove(SNAPSHOT_PATH);
+    }
+
+    SECTION("loaded world keeps working after updates")
+    {
+        world_cup_t *obj = buildLeague();
+        REQUIRE(obj->saveSnapshot(SNAPSHOT_PATH) == StatusType::SUCCESS);
+        world_cup_t *loaded = world_cup_t::loadSnapshot(SNAPSHOT_PATH);
+        REQUIRE(loaded != nullptr);
+
+        world_cup_t *worlds[2] = {obj, loaded};
+        for (world_cup_t *world : worlds)
+        {
+            REQUIRE(world->add_player(104, 1, permutation_t::neutral(), 1, 1, 1, false) == StatusType::FAILURE);
+            REQUIRE(world->add_player(900, 1, permutation_t::neutral(), 1, 1, 1, false) == StatusType::SUCCESS);
+            REQUIRE(world->add_player_cards(501, 3) == StatusType::SUCCESS);
+            REQUIRE(world->buy_team(1, 6) == StatusType::SUCCESS);
+            REQUIRE(world->play_match(1, 5).status() == StatusType::SUCCESS);
+        }
+        requireSameState(obj, loaded, TEAMS, PLAYERS_PER_TEAM);
+
+        // a partially touched world saves every player, touched or not
+        REQUIRE(loaded->saveSnapshot(SNAPSHOT_PATH) == StatusType::SUCCESS);
+        world_cup_t *reloaded = world_cup_t::loadSnapshot(SNAPSHOT_PATH);
+        REQUIRE(reloaded != nullptr);
+        requireSameState(obj, reloaded, TEAMS, PLAYERS_PER_TEAM);
+
+        delete obj;
+        delete loaded;
+        delete reloaded;
+        std::remove(SNAPSHOT_PATH);
+    }
+
+    SECTION("missing or invalid file")
+    {
+        REQUIRE(world_cup_t::loadSnapshot("no_such_snapshot.img") == nullptr);
+
+        FILE *file = std::fopen(SNAPSHOT_PATH, "wb");
+        REQUIRE(file != nullptr);
+        std::fputs("not a snapshot image", file);
+        std::fclose(file);
+        REQUIRE(world_cup_t::loadSnapshot(SNAPSHOT_PATH) == nullptr);
+        std::remove(SNAPSHOT_PATH);
+    }
+
+    SECTION("lookups of a loaded world never allocate")
+    {
+        world_cup_t *obj = buildLeague();
+        REQUIRE(obj->saveSnapshot(SNAPSHOT_PATH) == StatusType::SUCCESS);
+
+        CountingAllocator allocator;
+        allocator.failAfter(0);
+        REQUIRE(world_cup_t::loadSnapshot(SNAPSHOT_PATH, nullptr, allocator) == nullptr);
+        REQUIRE(allocator.getLive() == 0);
+        allocator.failAfter(-1);
+
+        world_cup_t *loaded = world_cup_t::loadSnapshot(SNAPSHOT_PATH, nullptr, allocator);
+        REQUIRE(loaded != nullptr);
+        uint64_t allocations = allocator.getAllocations();
+        allocator.failAfter(0);
+        // every player is still in the image, each lookup creates it (and its parents) in place
+        for (int team = TEAMS; team >= 1; --team)
+        {
+            for (int i = 0; i < PLAYERS_PER_TEAM; ++i)
+            {
+                int id = playerId(team, i);
+                output_t<int> games = loaded->num_played_games_for_player(id);
+                REQUIRE(games.status() == obj->num_played_games_for_player(id).status());
+                REQUIRE(games.ans() == obj->num_played_games_for_player(id).ans());
+                output_t<permutation_t> spirit = loaded->get_partial_spirit(id);
+                REQUIRE(spirit.status() == obj->get_partial_spirit(id).status());
+                REQUIRE(spirit.ans() == obj->get_partial_spirit(id).ans());
+                REQUIRE(loaded->get_player_cards(id).ans() == obj->get_player_cards(id).ans());
+                REQUIRE(loaded->add_player(id, 1, permutation_t::neutral(), 0, 0, 0, false)
+                        == obj->add_player(id, 1, permutation_t::neutral(), 0, 0, 0, false));
+            }
+        }
+        REQUIRE(loaded->buy_team(1, 5) == StatusType::SUCCESS);
+        REQUIRE(obj->buy_team(1, 5) == StatusType::SUCCESS);
+        REQUIRE(allocator.getAllocations() == allocations);
+        allocator.failAfter(-1);
+        requireSameState(obj, loaded, TEAMS, PLAYERS_PER_TEAM);
+
+        delete loaded;
+        delete obj;
+        REQUIRE(allocator.getLive() == 0);
+        std::remove(SNAPSHOT_PATH);
+    }
+
+    SECTION("image with an index out of its bounds")
+    {
+        world_cup_t *obj = buildLeague();
+        REQUIRE(obj->saveSnapshot(SNAPSHOT_PATH) == StatusType::SUCCESS);
+        delete obj;
+        vector<char> image = readImage(SNAPSHOT_PATH);
+        REQUIRE(!image.empty());
+
+        // the untouched copy still loads
+        writeImage(SNAPSHOT_PATH, image);
+        world_cup_t *loaded = world_cup_t::loadSnapshot(SNAPSHOT_PATH);
+        REQUIRE(loaded != nullptr);
+        delete loaded;
+
+        vector<char> truncated(image.begin(), image.end() - sizeof(PlayerImage));
+        writeImage(SNAPSHOT_PATH, truncated);
+        REQUIRE(world_cup_t::loadSnapshot(SNAPSHOT_PATH) == nullptr);
+
+        requireRejected(image, [](SnapshotHeader *header, TeamImage *, uint32_t *, PlayerImage *)
+        {
+            header->teamsOffset += 8;
+        });
+        requireRejected(image, [](SnapshotHeader *header, TeamImage *, uint32_t *, PlayerImage *)
+        {
+            header->playerCount = header->playerSlots;
+        });
+        requireRejected(image, [](SnapshotHeader *header, TeamImage *teams, uint32_t *, PlayerImage *)
+        {
+            teams[0].teamSet = (int32_t) header->playerSlots;
+        });
+        requireRejected(image, [](SnapshotHeader *header, TeamImage *teams, uint32_t *, PlayerImage *players)
+        {
+            // a team set that is not a root
+            teams[0].teamSet = findSlot(header, players, true);
+        });
+        requireRejected(image, [](SnapshotHeader *header, TeamImage *, uint32_t *abilityOrder, PlayerImage *)
+        {
+            abilityOrder[0] = header->teamCount;
+        });
+        requireRejected(image, [](SnapshotHeader *, TeamImage *, uint32_t *abilityOrder, PlayerImage *)
+        {
+            abilityOrder[1] = abilityOrder[0];
+        });
+        requireRejected(image, [](SnapshotHeader *, TeamImage *teams, uint32_t *, PlayerImage *)
+        {
+            teams[1].id = teams[0].id;
+        });
+        std::remove(SNAPSHOT_PATH);
+    }
+
+    SECTION("player records are checked when they are looked up")
+    {
+        world_cup_t *obj = buildLeague();
+        REQUIRE(obj->saveSnapshot(SNAPSHOT_PATH) == StatusType::SUCCESS);
+        delete obj;
+        vector<char> image = readImage(SNAPSHOT_PATH);
+
+        requireUnreadable(image, [](SnapshotHeader *header, PlayerImage *players)
+        {
+            int32_t slot = findSlot(header, players, true);
+            players[slot].parent = (int32_t) header->playerSlots;
+            return slot;
+        });
+        requireUnreadable(image, [](SnapshotHeader *header, PlayerImage *players)
+        {
+            int32_t slot = findSlot(header, players, true);
+            players[slot].parent = -2;
+            return slot;
+        });
+        requireUnreadable(image, [](SnapshotHeader *header, PlayerImage *players)
+        {
+            // a parent slot that holds no player
+            int32_t slot = findSlot(header, players, true);
+            for (uint32_t empty = 0; empty < header->playerSlots; ++empty)
+            {
+                if (players[empty].id == 0)
+                {
+                    players[slot].parent = (int32_t) empty;
+                    break;
+                }
+            }
+            return slot;
+        });
+        requireUnreadable(image, [](SnapshotHeader *header, PlayerImage *players)
+        {
+            // a chain that never reaches a root
+            int32_t slot = findSlot(header, players, true);
+            players[slot].parent = slot;
+            return slot;
+        });
+        requireUnreadable(image, [](SnapshotHeader *header, PlayerImage *players)
+        {
+            int32_t slot = findSlot(header, players, true);
+            players[slot].spirit = SPIRIT_RANKS;
+            return slot;
+        });
+        requireUnreadable(image, [](SnapshotHeader *header, PlayerImage *players)
+        {
+            // a fixup that is not one of the image's players
+            int32_t slot = findSlot(header, players, true);
+            players[slot].fixup = reinterpret_cast<uint64_t>(players);
+            return slot;
+        });
+        std::remove(SNAPSHOT_PATH);
+    }
+}
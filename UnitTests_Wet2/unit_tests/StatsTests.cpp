@@ -0,0 +1,95 @@
+#include "catch.hpp"
+#include "wet2util_override.h"
+#include "worldcup23a2.h"
+
+using namespace std;
+
+TEST_CASE("stats")
+{
+    world_cup_t::resetStats();
+    world_cup_t *obj = new world_cup_t();
+    int spirit[5] = {4, 3, 2, 1, 0};
+    for (int team = 1; team <= 20; ++team)
+    {
+        REQUIRE(obj->add_team(team) == StatusType::SUCCESS);
+        REQUIRE(obj->add_player(team, team, permutation_t(spirit), 0, team, 0, true) == StatusType::SUCCESS);
+    }
+    REQUIRE(obj->buy_team(1, 2) == StatusType::SUCCESS);
+    REQUIRE(obj->buy_team(3, 1) == StatusType::SUCCESS);
+    REQUIRE(obj->get_partial_spirit(2).status() == StatusType::SUCCESS);
+    REQUIRE(obj->remove_team(3) == StatusType::SUCCESS);
+    Stats stats = world_cup_t::getStats();
+    delete obj;
+
+#ifdef WC_ENABLE_STATS
+    SECTION("counts while enabled")
+    {
+        // two trees of teams, one hash chain node per player
+        REQUIRE(stats.insertRotations.getCount() >= 20 * 2);
+        REQUIRE(stats.rotations > 0);
+        REQUIRE(stats.removeRotations.getCount() >= 2);
+        REQUIRE(stats.nodesAllocated >= 20 * 3);
+        REQUIRE(stats.hashChain.getCount() > 0);
+        REQUIRE(stats.unionFindHops.getMax() >= 1);
+
+        world_cup_t::resetStats();
+        REQUIRE(world_cup_t::getStats().nodesAllocated == 0);
+        REQUIRE(world_cup_t::getStats().insertRotations.getCount() == 0);
+    }
+#else
+    SECTION("all zero while disabled")
+    {
+        REQUIRE(stats.rotations == 0);
+        REQUIRE(stats.nodesAllocated == 0);
+        REQUIRE(stats.insertRotations.getCount() == 0);
+        REQUIRE(stats.hashChain.getCount() == 0);
+        REQUIRE(stats.unionFindHops.getCount() == 0);
+    }
+#endif
+}
+
+TEST_CASE("latency")
+{
+    SECTION("histogram buckets stay within 3%")
+    {
+        for (uint64_t value = 1; value < (uint64_t(1) << 40); value = value * 3 / 2 + 1)
+        {
+            uint64_t highest = LatencyHistogram::highestValueOf(LatencyHistogram::bucketOf(value));
+            REQUIRE(highest >= value);
+            REQUIRE(highest - value <= value / 32);
+        }
+        REQUIRE(LatencyHistogram::bucketOf(~uint64_t(0)) == LatencyHistogram::BUCKETS - 1);
+    }
+
+    SECTION("percentiles")
+    {
+        LatencyHistogram histogram;
+        for (uint64_t value = 1; value <= 1000; ++value)
+            histogram.add(value);
+        REQUIRE(histogram.getCount() == 1000);
+        REQUIRE(histogram.getMax() == 1000);
+        REQUIRE(histogram.percentile(0.5) >= 500);
+        REQUIRE(histogram.percentile(0.5) <= 500 + 500 / 32);
+        REQUIRE(histogram.percentile(0.999) >= 999);
+        REQUIRE(histogram.percentile(1) == 1000);
+    }
+
+    SECTION("sampling")
+    {
+        world_cup_t::resetLatency();
+        world_cup_t *obj = new world_cup_t();
+        REQUIRE(obj->add_team(1) == StatusType::SUCCESS);
+        REQUIRE(latency().get(Operation::ADD_TEAM).getCount() == 0);
+
+        world_cup_t::setLatencySampling(4);
+        for (int i = 0; i < 100; ++i)
+            obj->get_team_points(1);
+        REQUIRE(latency().get(Operation::GET_TEAM_POINTS).getCount() == 25);
+
+        world_cup_t::setLatencySampling(0);
+        obj->get_team_points(1);
+        REQUIRE(latency().get(Operation::GET_TEAM_POINTS).getCount() == 25);
+        delete obj;
+        world_cup_t::resetLatency();
+    }
+}
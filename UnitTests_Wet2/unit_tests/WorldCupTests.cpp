@@ -2,12 +2,13 @@
 
 #include "catch.hpp"
 #include "wet2util_override.h"
-#include "../worldcup23a2.h"
+#include "worldcup23a2.h"
 #include <string>
 #include <iostream>
 #include <sstream>
 #include <vector>
 #include <stdlib.h>
+#include <functional>
 
 using namespace std;
 
@@ -3086,3 +3087,67 @@ TEST_CASE("buy_team")
 
 
 }
+
+TEST_CASE("for each team by ability")
+{
+    world_cup_t *obj = new world_cup_t();
+    int spirit[5] = {0, 1, 2, 3, 4};
+    for (int team = 1; team <= 60; ++team)
+    {
+        REQUIRE(obj->add_team(team) == StatusType::SUCCESS);
+        for (int i = 0; i < team % 4; ++i)
+            REQUIRE(obj->add_player(team * 10 + i, team, permutation_t(spirit), 0, (team * 13 + i * 7) % 23 - 5, 0,
+                                    i == 0) == StatusType::SUCCESS);
+    }
+    for (int team = 5; team <= 60; team += 9)
+        REQUIRE(obj->remove_team(team) == StatusType::SUCCESS);
+    REQUIRE(obj->buy_team(1, 2) == StatusType::SUCCESS);
+    REQUIRE(obj->buy_team(7, 3) == StatusType::SUCCESS);
+    int teams = 60 - 7 - 2;
+
+    SECTION("walks the teams like get_ith_pointless_ability")
+    {
+        for (int first = 0; first < teams; first += 10)
+        {
+            int i = first;
+            StatusType res = obj->forEachTeamByAbility(first, [obj, &i](const Team &team)
+            {
+                REQUIRE(obj->get_ith_pointless_ability(i).ans() == team.getId());
+                REQUIRE(obj->get_team_points(team.getId()).ans() == team.getPoints());
+                i++;
+                return true;
+            });
+            REQUIRE(res == StatusType::SUCCESS);
+            REQUIRE(i == teams);
+        }
+    }
+
+    SECTION("stops when visit returns false")
+    {
+        int visited = 0;
+        REQUIRE(obj->forEachTeamByAbility(3, [&visited](const Team &)
+        {
+            return ++visited < 5;
+        }) == StatusType::SUCCESS);
+        REQUIRE(visited == 5);
+    }
+
+    SECTION("out of range")
+    {
+        int visited = 0;
+        function<bool(const Team &)> visit = [&visited](const Team &)
+        {
+            visited++;
+            return true;
+        };
+        REQUIRE(obj->forEachTeamByAbility(-1, visit) == StatusType::INVALID_INPUT);
+        REQUIRE(obj->forEachTeamByAbility(teams, visit) == StatusType::FAILURE);
+        REQUIRE(obj->forEachTeamByAbility(teams - 1, visit) == StatusType::SUCCESS);
+        REQUIRE(visited == 1);
+
+        world_cup_t empty;
+        REQUIRE(empty.forEachTeamByAbility(0, visit) == StatusType::FAILURE);
+    }
+
+    delete obj;
+}
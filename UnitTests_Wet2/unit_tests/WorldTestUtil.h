@@ -0,0 +1,59 @@
+#ifndef WORLD_TEST_UTIL_H_
+#define WORLD_TEST_UTIL_H_
+
+#include "catch.hpp"
+#include "wet2util_override.h"
+#include "worldcup23a2.h"
+
+/*
+ * Helpers shared by the world tests
+ */
+
+inline int playerId(int team, int i)
+{
+    return team * 100 + i;
+}
+
+/**
+ * Requires both worlds to answer every query alike: points of teams 1..teams, the ability ranks,
+ * and games, partial spirit and cards of playerId(team, 0..playersPerTeam - 1)
+ */
+inline void requireSameState(world_cup_t *expected, world_cup_t *actual, int teams, int playersPerTeam)
+{
+    for (int team = 1; team <= teams; ++team)
+    {
+        output_t<int> points1 = expected->get_team_points(team);
+        output_t<int> points2 = actual->get_team_points(team);
+        REQUIRE(points1.status() == points2.status());
+        REQUIRE(points1.ans() == points2.ans());
+    }
+    for (int i = 0; i <= teams; ++i)
+    {
+        output_t<int> rank1 = expected->get_ith_pointless_ability(i);
+        output_t<int> rank2 = actual->get_ith_pointless_ability(i);
+        REQUIRE(rank1.status() == rank2.status());
+        REQUIRE(rank1.ans() == rank2.ans());
+    }
+    for (int team = 1; team <= teams; ++team)
+    {
+        for (int i = 0; i < playersPerTeam; ++i)
+        {
+            output_t<int> games1 = expected->num_played_games_for_player(playerId(team, i));
+            output_t<int> games2 = actual->num_played_games_for_player(playerId(team, i));
+            REQUIRE(games1.status() == games2.status());
+            REQUIRE(games1.ans() == games2.ans());
+
+            output_t<permutation_t> spirit1 = expected->get_partial_spirit(playerId(team, i));
+            output_t<permutation_t> spirit2 = actual->get_partial_spirit(playerId(team, i));
+            REQUIRE(spirit1.status() == spirit2.status());
+            REQUIRE(spirit1.ans() == spirit2.ans());
+
+            output_t<int> cards1 = expected->get_player_cards(playerId(team, i));
+            output_t<int> cards2 = actual->get_player_cards(playerId(team, i));
+            REQUIRE(cards1.status() == cards2.status());
+            REQUIRE(cards1.ans() == cards2.ans());
+        }
+    }
+}
+
+#endif //WORLD_TEST_UTIL_H_
@@ -4,7 +4,9 @@
 
 #include <iostream> //-----------------------------------------------------------------------------------------
 #include <exception>
+#include <utility>
 #include "AVLTreeNode.h"
+#include "Allocator.h"
 
 
 template<class T, class S>
@@ -12,18 +14,21 @@ class AVLTree
 {
 private:
     AVLTreeNode<T, S> *root;
+    Allocator *allocator;
+    void *spare; // memory for one node, set aside by reserve()
+    AVLTreeNode<T, S> *minNode; // the nodes of the smallest and largest keys, kept by every change
+    AVLTreeNode<T, S> *maxNode;
 
 
 public:
-    AVLTree();
-    AVLTree(S **playersArr, int size, T* (S::*ChooseKey)() const);
+    explicit AVLTree(Allocator &allocator = heapAllocator());
+    AVLTree(S **playersArr, int size, T* (S::*ChooseKey)() const, Allocator &allocator = heapAllocator());
     ~AVLTree();
 
     // Explicitly telling the compiler to delete this methods
     AVLTree(const AVLTree &) = delete;
 
-    // assignment operator
-    AVLTree &operator=(const AVLTree &other);
+    AVLTree &operator=(const AVLTree &) = delete;
 
     /**
      * Finds a node using a given key and returns the value stored in it.
@@ -47,6 +52,25 @@ public:
      */
     void remove(T *key);
 
+    /**
+     * Sets aside the memory of one node, so the next insert cannot run out of memory.
+     * Lets an operation allocate everything before it changes anything.
+     */
+    void reserve();
+
+    /**
+     * Moves the node of a key whose ordering is about to change, without allocating:
+     * changeKey() is called, and if the key no longer fits between its neighbours the node is
+     * unlinked and linked back at its new place. A key that keeps its place costs no search.
+     * Throws an exception if the key does not exist. The changed key must not equal another key.
+     * @param key
+     * @param changeKey
+     * @param previous - if given, receives the value of the next smaller key after the change
+     * @param next - if given, receives the value of the next larger key after the change
+     */
+    template<class F>
+    void rekey(T *key, F changeKey, S **previous = nullptr, S **next = nullptr);
+
     /**
      * Returns the value of the first next key with a value greater than the given key
      * @param key
@@ -69,11 +93,40 @@ public:
     S* findEqOrGreater(const T *key);
 
     /**
-     * Returns the value of the largest key in the tree
+     * Returns the value of the largest key in the tree, O(1)
      * @return
      */
     S* findMax();
 
+    /**
+     * Returns the value of the smallest key in the tree, O(1)
+     * @return
+     */
+    S* findMin();
+
+    /**
+     * Finds the node with index k in the sorted list of keys and returns the value stored in it.
+     * @param k
+     * @return nullptr if k is out of range
+     */
+    S *select(int k);
+
+    /**
+     * Counts the keys smaller than the given key, which does not have to be in the tree. O(log n).
+     * @param key
+     * @return
+     */
+    int countLess(const T *key);
+
+    int getSize() const;
+
+    /**
+     * Checks the invariants of the tree: keys in order, parent links, heights, balance, subtree
+     * sizes and the nodes of the smallest and largest keys. O(n), for tests.
+     * @return
+     */
+    bool isValid() const;
+
     /**
      * Puts the tree inorder to the array
      * (Required that the given array is large enough)
@@ -82,10 +135,39 @@ public:
     void arrayInOrder(S **const output);
 
     /**
-     * Releases the values from the tree
+     * Calls visit(value) for the values in key order, following the parent links from the
+     * smallest key. Allocates nothing; the tree must not change during the walk.
+     * @param visit
+     */
+    template<class F>
+    void forEach(F visit);
+
+    /**
+     * Moves every node of other into this tree without allocating, other is left empty.
+     * With m nodes in the smaller tree and n in the larger, the smaller one's nodes are inserted into
+     * the larger one in O(m log n) when that is less than n + m. Otherwise both trees are flattened
+     * into lists of their own nodes, the lists are merged by key and the nodes are linked back into
+     * one balanced tree in O(n + m).
+     * (Required that the trees share an allocator and no key is in both)
+     * @param other
+     */
+    void merge(AVLTree &other);
+
+    /**
+     * Releases the values from the tree (they must come from the tree's allocator)
      */
     void releaseValues();
 
+    /**
+     * Removes every node, the values are left alone
+     */
+    void clear();
+
+    /**
+     * Forgets every node without giving it back, for when the allocator is released as a whole
+     */
+    void abandon();
+
 
 
     //possible exceptions to be thrown
@@ -95,9 +177,17 @@ public:
 
 private:
 
+    //Nodes come from and go back to the tree's allocator
+    AVLTreeNode<T, S> *createNode(T *key, S *value);
+    void destroyNode(AVLTreeNode<T, S> *node);
+
     //Releases the nodes in the tree recursively using a postorder route
     void release(AVLTreeNode<T, S> *node);
 
+    //The in-order neighbours of a node, following the parent links
+    static AVLTreeNode<T, S> *nextNode(AVLTreeNode<T, S> *node);
+    static AVLTreeNode<T, S> *previousNode(AVLTreeNode<T, S> *node);
+
     //Finds a node recursively using a given key
     AVLTreeNode<T, S> *findNode(const T *key, AVLTreeNode<T, S> *node);
     AVLTreeNode<T, S> *findParentNode(const T *key, AVLTreeNode<T, S> *node);
@@ -132,24 +222,74 @@ private:
     void updateParent(AVLTreeNode<T, S> *node, AVLTreeNode<T, S> *toUpdate, enum SonType sonType);
 
     AVLTreeNode<T, S>* generateTree(S **playersArr, int size, T* (S::*chooseKey)() const);
+
+    //Auxiliary functions for merge: a vine is a list of nodes in key order, linked by right
+    static AVLTreeNode<T, S> *toVine(AVLTreeNode<T, S> *node);
+    static AVLTreeNode<T, S> *mergeVines(AVLTreeNode<T, S> *vine1, AVLTreeNode<T, S> *vine2);
+    //Links the first size nodes of the vine into a balanced tree and moves vine past them
+    static AVLTreeNode<T, S> *vineToTree(AVLTreeNode<T, S> *&vine, int size);
+    //Inserts a node that is in no tree as a leaf and balances, for nodes moved between trees
+    void linkNode(AVLTreeNode<T, S> *node);
+
+    //Takes a newly linked node as the smallest or largest key if it is one
+    void updateEnds(AVLTreeNode<T, S> *newNode);
+    //Walks down to the smallest and largest keys, for a tree built at once
+    void findEnds();
+
+    //Recursively find the node with index k
+    AVLTreeNode<T, S> *selectRecursive(int k, AVLTreeNode<T, S> *curNode);
+
+    //Recursively checks the subtree for isValid, previous is the node before it in key order
+    //Returns the height of the subtree (-1 for an empty one), or -2 if an invariant is broken
+    static int validHeight(const AVLTreeNode<T, S> *node, const AVLTreeNode<T, S> *parent,
+                           const AVLTreeNode<T, S> *&previous);
 };
 
 
 template<class T, class S>
-AVLTree<T, S>::AVLTree() : root(nullptr)
+AVLTree<T, S>::AVLTree(Allocator &allocator) :
+        root(nullptr), allocator(&allocator), spare(nullptr), minNode(nullptr), maxNode(nullptr)
 {}
 
 template<class T, class S>
 AVLTree<T, S>::~AVLTree()
 {
     release(root);
+    if (spare != nullptr)
+        allocator->deallocate(spare, sizeof(AVLTreeNode<T, S>));
 }
 
 
 template<class T, class S>
-AVLTree<T, S>::AVLTree(S **playersArr, int size, T *(S::*chooseKey)() const)
+AVLTree<T, S>::AVLTree(S **playersArr, int size, T *(S::*chooseKey)() const, Allocator &allocator) :
+        root(nullptr), allocator(&allocator), spare(nullptr), minNode(nullptr), maxNode(nullptr)
 {
     root = generateTree(playersArr, size, chooseKey);
+    findEnds();
+}
+
+template<class T, class S>
+AVLTreeNode<T, S> *AVLTree<T, S>::createNode(T *key, S *value)
+{
+    void *memory = spare;
+    if (memory == nullptr)
+        memory = allocator->allocate(sizeof(AVLTreeNode<T, S>));
+    spare = nullptr;
+    return new(memory) AVLTreeNode<T, S>(key, value);
+}
+
+template<class T, class S>
+void AVLTree<T, S>::destroyNode(AVLTreeNode<T, S> *node)
+{
+    node->~AVLTreeNode();
+    allocator->deallocate(node, sizeof(AVLTreeNode<T, S>));
+}
+
+template<class T, class S>
+void AVLTree<T, S>::reserve()
+{
+    if (spare == nullptr)
+        spare = allocator->allocate(sizeof(AVLTreeNode<T, S>));
 }
 
 template<class T, class S>
@@ -162,9 +302,17 @@ AVLTreeNode<T, S> *AVLTree<T, S>::generateTree(S **playersArr, int size, T *(S::
 
     int mid = size/2;
     S* player = playersArr[mid];
-    AVLTreeNode<T,S> *curNode = new AVLTreeNode<T, S>((player->*chooseKey)(), player);
-    curNode->left = generateTree(playersArr, mid, chooseKey);
-    curNode->right = generateTree(playersArr + mid+1, size-mid-1, chooseKey);
+    AVLTreeNode<T,S> *curNode = createNode((player->*chooseKey)(), player);
+    try
+    {
+        curNode->left = generateTree(playersArr, mid, chooseKey);
+        curNode->right = generateTree(playersArr + mid+1, size-mid-1, chooseKey);
+    }
+    catch (const std::bad_alloc &e)
+    {
+        release(curNode);
+        throw;
+    }
 
     if (curNode->left != nullptr)
         curNode->left->parent = curNode;
@@ -172,19 +320,11 @@ AVLTreeNode<T, S> *AVLTree<T, S>::generateTree(S **playersArr, int size, T *(S::
         curNode->right->parent = curNode;
 
     curNode->updateHeight();
+    curNode->updateRank();
 
     return curNode;
 }
 
-template<class T, class S>
-AVLTree<T, S> &AVLTree<T, S>::operator=(const AVLTree &other)
-{
-    if (this == &other)
-        return *this;
-    root = other.root;
-    return *this;
-}
-
 template<class T, class S>
 void AVLTree<T, S>::release(AVLTreeNode<T, S> *node)
 {
@@ -192,7 +332,7 @@ void AVLTree<T, S>::release(AVLTreeNode<T, S> *node)
 
     release(node->right);
     release(node->left);
-    delete node;
+    destroyNode(node);
 }
 
 template<class T, class S>
@@ -209,26 +349,8 @@ S *AVLTree<T, S>::findNext(const T *key)
     AVLTreeNode<T, S>* curNode = findNode(key, root);
     if(curNode == nullptr)
         throw KeyDoesNotExist();
-    AVLTreeNode<T, S>* tempNode = curNode;
-    if(curNode->right != nullptr)
-    {
-        curNode = curNode->right;
-        while(curNode->left != nullptr)
-        {
-            curNode = curNode->left;
-        }
-        return curNode->value;
-    }
-    curNode = tempNode;
-    while(curNode->getSonType() == SonType::RIGHT)
-    {
-        curNode = curNode->parent;
-    }
-    if(curNode->getSonType() == SonType::LEFT)
-    {
-        return curNode->parent->value;
-    }
-    return nullptr;
+    curNode = nextNode(curNode);
+    return (curNode != nullptr) ? curNode->value : nullptr;
 }
 
 template<class T, class S>
@@ -237,26 +359,46 @@ S *AVLTree<T, S>::findPrevious(const T *key)
     AVLTreeNode<T, S>* curNode = findNode(key, root);
     if(curNode == nullptr)
         throw KeyDoesNotExist();
-    AVLTreeNode<T, S>* tempNode = curNode;
-    if(curNode->left != nullptr)
+    curNode = previousNode(curNode);
+    return (curNode != nullptr) ? curNode->value : nullptr;
+}
+
+template<class T, class S>
+AVLTreeNode<T, S> *AVLTree<T, S>::nextNode(AVLTreeNode<T, S> *node)
+{
+    if(node->right != nullptr)
     {
-        curNode = curNode->left;
-        while(curNode->right != nullptr)
+        node = node->right;
+        while(node->left != nullptr)
         {
-            curNode = curNode->right;
+            node = node->left;
         }
-        return curNode->value;
+        return node;
     }
-    curNode = tempNode;
-    while(curNode->getSonType() == SonType::LEFT)
+    while(node->getSonType() == SonType::RIGHT)
     {
-        curNode = curNode->parent;
+        node = node->parent;
     }
-    if(curNode->getSonType() == SonType::RIGHT)
+    return node->parent;
+}
+
+template<class T, class S>
+AVLTreeNode<T, S> *AVLTree<T, S>::previousNode(AVLTreeNode<T, S> *node)
+{
+    if(node->left != nullptr)
     {
-        return curNode->parent->value;
+        node = node->left;
+        while(node->right != nullptr)
+        {
+            node = node->right;
+        }
+        return node;
+    }
+    while(node->getSonType() == SonType::LEFT)
+    {
+        node = node->parent;
     }
-    return nullptr;
+    return node->parent;
 }
 
 template<class T, class S>
@@ -323,8 +465,9 @@ void AVLTree<T, S>::insert(T *key, S *value)
     {
         throw KeyExists();
     }
+    WC_STAT(uint64_t rotationsBefore = stats().rotations);
     AVLTreeNode<T, S> *newNode;
-    newNode = new AVLTreeNode<T, S>(key, value);
+    newNode = createNode(key, value);
     if (this->root == nullptr)
     {
         root = newNode;
@@ -333,8 +476,10 @@ void AVLTree<T, S>::insert(T *key, S *value)
     {
         insertBin(newNode, root);
     }
+    updateEnds(newNode);
 
     balanceInsert(newNode);
+    WC_STAT(stats().insertRotations.add(stats().rotations - rotationsBefore));
 }
 
 
@@ -366,7 +511,7 @@ void AVLTree<T, S>::insertBin(AVLTreeNode<T, S> *newNode, AVLTreeNode<T, S> *nod
             insertBin(newNode, nodeRec->right);
         }
     }
-
+    nodeRec->updateRank();
 }
 
 template<class T, class S>
@@ -384,6 +529,11 @@ void AVLTree<T, S>::balanceInsert(AVLTreeNode<T, S> *curNode)
         if (isBalanced) break;
         curNode = parent;
     }
+    while (curNode != nullptr)
+    {
+        curNode->updateRank();
+        curNode = curNode->parent;
+    }
 }
 
 template<class T, class S>
@@ -400,6 +550,7 @@ bool AVLTree<T, S>::balance(AVLTreeNode<T, S> *parent)
         {
             rotateLL(parent);
         }
+        WC_STAT(stats().rotations++);
 
         return true;
     }
@@ -413,6 +564,7 @@ bool AVLTree<T, S>::balance(AVLTreeNode<T, S> *parent)
         {
             rotateRR(parent);
         }
+        WC_STAT(stats().rotations++);
 
         return true;
     }
@@ -427,14 +579,77 @@ void AVLTree<T, S>::remove(T *key)
     {
         throw KeyDoesNotExist();
     }
+    WC_STAT(uint64_t rotationsBefore = stats().rotations);
     toDelete = removeBin(toDelete);
     balanceRemove(toDelete->parent);
-    delete toDelete;
+    destroyNode(toDelete);
+    WC_STAT(stats().removeRotations.add(stats().rotations - rotationsBefore));
+}
+
+template<class T, class S>
+template<class F>
+void AVLTree<T, S>::rekey(T *key, F changeKey, S **previous, S **next)
+{
+    AVLTreeNode<T, S> *node = findNode(key, root);
+    if (node == nullptr)
+    {
+        throw KeyDoesNotExist();
+    }
+    AVLTreeNode<T, S> *before = previousNode(node);
+    AVLTreeNode<T, S> *after = nextNode(node);
+
+    // the key is changed in place, the tree is only touched if it has to move
+    changeKey();
+    if ((before == nullptr || *(before->key) < *(node->key)) && (after == nullptr || *(node->key) < *(after->key)))
+    {
+        if (previous != nullptr)
+            *previous = (before != nullptr) ? before->value : nullptr;
+        if (next != nullptr)
+            *next = (after != nullptr) ? after->value : nullptr;
+        return;
+    }
+
+    node = removeBin(node);
+    balanceRemove(node->parent);
+    linkNode(node);
+
+    if (previous != nullptr)
+    {
+        before = previousNode(node);
+        *previous = (before != nullptr) ? before->value : nullptr;
+    }
+    if (next != nullptr)
+    {
+        after = nextNode(node);
+        *next = (after != nullptr) ? after->value : nullptr;
+    }
 }
 
 template<class T, class S>
 AVLTreeNode<T, S> *AVLTree<T, S>::removeBin(AVLTreeNode<T, S> *toRemove)
 {
+    // a node with both children is neither end, it is swapped below with one that has at most one
+    if (toRemove == maxNode)
+    {
+        maxNode = toRemove->parent;
+        if (toRemove->left != nullptr)
+        {
+            maxNode = toRemove->left;
+            while (maxNode->right != nullptr)
+                maxNode = maxNode->right;
+        }
+    }
+    if (toRemove == minNode)
+    {
+        minNode = toRemove->parent;
+        if (toRemove->right != nullptr)
+        {
+            minNode = toRemove->right;
+            while (minNode->left != nullptr)
+                minNode = minNode->left;
+        }
+    }
+
     if (!(toRemove->left || toRemove->right))
     {
         updateParent(toRemove, nullptr, toRemove->getSonType());
@@ -457,6 +672,9 @@ AVLTreeNode<T, S> *AVLTree<T, S>::removeBin(AVLTreeNode<T, S> *toRemove)
             toSwap = toSwap->left;
         }
         swapNodes(toRemove, toSwap);
+        // the largest key may have been the successor, it now lives in toRemove
+        if (toSwap == maxNode)
+            maxNode = toRemove;
         return removeBin(toSwap);
     }
     return toRemove;
@@ -481,10 +699,18 @@ void AVLTree<T, S>::balanceRemove(AVLTreeNode<T, S> *curNode)
     {
         previousHeight = curNode->height;
         curNode->updateHeight();
-        balance(curNode);
+        curNode->updateRank();
+        // a rotation moves curNode down, the subtree's height is the one of its new root
+        if (balance(curNode))
+            curNode = curNode->parent;
         if (previousHeight == curNode->height) break;
         curNode = curNode->parent;
     }
+    while (curNode != nullptr)
+    {
+        curNode->updateRank();
+        curNode = curNode->parent;
+    }
 }
 
 
@@ -505,7 +731,9 @@ void AVLTree<T, S>::rotateLL(AVLTreeNode<T, S> *parent)
     B->parent = A;
     updateParent(A, A, sonType);
     B->updateHeight();
+    B->updateRank();
     A->updateHeight();
+    A->updateRank();
 }
 
 template<class T, class S>
@@ -534,8 +762,11 @@ void AVLTree<T, S>::rotateLR(AVLTreeNode<T, S> *parent)
     C->parent = B;
     updateParent(B, B, sonType);
     A->updateHeight();
+    A->updateRank();
     C->updateHeight();
+    C->updateRank();
     B->updateHeight();
+    B->updateRank();
 }
 
 template<class T, class S>
@@ -555,7 +786,9 @@ void AVLTree<T, S>::rotateRR(AVLTreeNode<T, S> *parent)
     B->parent = A;
     updateParent(A, A, sonType);
     B->updateHeight();
+    B->updateRank();
     A->updateHeight();
+    A->updateRank();
 }
 
 template<class T, class S>
@@ -584,8 +817,11 @@ void AVLTree<T, S>::rotateRL(AVLTreeNode<T, S> *parent)
     C->parent = B;
     updateParent(B, B, sonType);
     A->updateHeight();
+    A->updateRank();
     C->updateHeight();
+    C->updateRank();
     B->updateHeight();
+    B->updateRank();
 }
 
 template<class T, class S>
@@ -598,10 +834,12 @@ void AVLTree<T, S>::updateParent(AVLTreeNode<T, S> *node, AVLTreeNode<T, S> *toU
     else if (sonType == SonType::RIGHT)
     {
         node->parent->right = toUpdate;
+        node->parent->updateRank();
     }
     else
     {
         node->parent->left = toUpdate;
+        node->parent->updateRank();
     }
 }
 
@@ -621,30 +859,307 @@ int AVLTree<T, S>::arrayInOrderRecursive(S **const output, AVLTreeNode<T, S>* cu
     return offset;
 }
 
+template<class T, class S>
+template<class F>
+void AVLTree<T, S>::forEach(F visit)
+{
+    for (AVLTreeNode<T, S> *curNode = minNode; curNode != nullptr; curNode = nextNode(curNode))
+    {
+        visit(curNode->value);
+    }
+}
+
+template<class T, class S>
+void AVLTree<T, S>::merge(AVLTree &other)
+{
+    if (other.root == nullptr)
+        return;
+    // the larger tree is kept whichever side it is, the nodes of both come from the same allocator
+    if (root == nullptr || root->nodesInSub < other.root->nodesInSub)
+    {
+        std::swap(root, other.root);
+        std::swap(minNode, other.minNode);
+        std::swap(maxNode, other.maxNode);
+        if (other.root == nullptr)
+            return;
+    }
+
+    int large = root->nodesInSub;
+    int small = other.root->nodesInSub;
+    // the height of the larger tree stands for log n
+    if ((long long) small * (root->height + 1) < (long long) large + small)
+    {
+        AVLTreeNode<T, S> *vine = toVine(other.root);
+        while (vine != nullptr)
+        {
+            AVLTreeNode<T, S> *next = vine->right;
+            linkNode(vine);
+            vine = next;
+        }
+    }
+    else
+    {
+        AVLTreeNode<T, S> *vine = mergeVines(toVine(root), toVine(other.root));
+        root = vineToTree(vine, large + small);
+        root->parent = nullptr;
+        findEnds();
+    }
+    other.root = nullptr;
+    other.minNode = nullptr;
+    other.maxNode = nullptr;
+}
+
+template<class T, class S>
+AVLTreeNode<T, S> *AVLTree<T, S>::toVine(AVLTreeNode<T, S> *node)
+{
+    while (node->left != nullptr)
+        node = node->left;
+    AVLTreeNode<T, S> *head = node;
+    // the successor is found before the node's right link is reused, and the walk up only
+    // compares left links, so the part not flattened yet is still a tree
+    while (node != nullptr)
+    {
+        AVLTreeNode<T, S> *next = nextNode(node);
+        node->right = next;
+        node = next;
+    }
+    return head;
+}
+
+template<class T, class S>
+AVLTreeNode<T, S> *AVLTree<T, S>::mergeVines(AVLTreeNode<T, S> *vine1, AVLTreeNode<T, S> *vine2)
+{
+    AVLTreeNode<T, S> *head = nullptr;
+    AVLTreeNode<T, S> **tail = &head;
+    while (vine1 != nullptr && vine2 != nullptr)
+    {
+        if (*(vine1->key) < *(vine2->key))
+        {
+            *tail = vine1;
+            vine1 = vine1->right;
+        }
+        else
+        {
+            *tail = vine2;
+            vine2 = vine2->right;
+        }
+        tail = &(*tail)->right;
+    }
+    *tail = (vine1 != nullptr) ? vine1 : vine2;
+    return head;
+}
+
+template<class T, class S>
+AVLTreeNode<T, S> *AVLTree<T, S>::vineToTree(AVLTreeNode<T, S> *&vine, int size)
+{
+    if (size <= 0)
+    {
+        return nullptr;
+    }
+
+    // the same shape generateTree builds from an array
+    int mid = size/2;
+    AVLTreeNode<T, S> *left = vineToTree(vine, mid);
+    AVLTreeNode<T, S> *curNode = vine;
+    vine = vine->right;
+    curNode->left = left;
+    curNode->right = vineToTree(vine, size-mid-1);
+
+    if (curNode->left != nullptr)
+        curNode->left->parent = curNode;
+    if (curNode->right != nullptr)
+        curNode->right->parent = curNode;
+
+    curNode->updateHeight();
+    curNode->updateRank();
+
+    return curNode;
+}
+
+template<class T, class S>
+void AVLTree<T, S>::linkNode(AVLTreeNode<T, S> *node)
+{
+    node->left = nullptr;
+    node->right = nullptr;
+    node->parent = nullptr;
+    node->height = 0;
+    node->nodesInSub = 1;
+    if (root == nullptr)
+    {
+        root = node;
+    }
+    else
+    {
+        insertBin(node, root);
+    }
+    updateEnds(node);
+    balanceInsert(node);
+}
+
 template<class T, class S>
 void AVLTree<T, S>::releaseValues()
 {
     releaseValuesRecursive(root);
 }
 
+template<class T, class S>
+void AVLTree<T, S>::clear()
+{
+    release(root);
+    root = nullptr;
+    minNode = nullptr;
+    maxNode = nullptr;
+}
+
+template<class T, class S>
+void AVLTree<T, S>::abandon()
+{
+    root = nullptr;
+    spare = nullptr;
+    minNode = nullptr;
+    maxNode = nullptr;
+}
+
 template<class T, class S>
 void AVLTree<T, S>::releaseValuesRecursive(AVLTreeNode<T,S>* curNode)
 {
     if(curNode == nullptr) return;
     releaseValuesRecursive(curNode->left);
-    delete curNode->value;
+    allocator->destroy(curNode->value);
     releaseValuesRecursive(curNode->right);
 }
 
 template<class T, class S>
 S *AVLTree<T, S>::findMax()
 {
+    if (maxNode == nullptr)
+        return nullptr;
+    return maxNode->value;
+}
+
+template<class T, class S>
+S *AVLTree<T, S>::findMin()
+{
+    if (minNode == nullptr)
+        return nullptr;
+    return minNode->value;
+}
+
+template<class T, class S>
+void AVLTree<T, S>::updateEnds(AVLTreeNode<T, S> *newNode)
+{
+    if (maxNode == nullptr || *(maxNode->key) < *(newNode->key))
+        maxNode = newNode;
+    if (minNode == nullptr || *(newNode->key) < *(minNode->key))
+        minNode = newNode;
+}
+
+template<class T, class S>
+void AVLTree<T, S>::findEnds()
+{
+    minNode = root;
+    maxNode = root;
     if (root == nullptr)
+        return;
+    while (minNode->left != nullptr)
+        minNode = minNode->left;
+    while (maxNode->right != nullptr)
+        maxNode = maxNode->right;
+}
+
+template<class T, class S>
+S *AVLTree<T, S>::select(int k)
+{
+    AVLTreeNode<T, S> *node = selectRecursive(k, root);
+    return (node != nullptr) ? node->value : nullptr;
+}
+
+template<class T, class S>
+AVLTreeNode<T, S> *AVLTree<T, S>::selectRecursive(int k, AVLTreeNode<T, S> *curNode)
+{
+    if (curNode == nullptr)
         return nullptr;
+    int weight;
+    if (curNode->left == nullptr)
+        weight = 0;
+    else weight = curNode->left->nodesInSub;
+
+    if (weight > k)
+    {
+        return selectRecursive(k, curNode->left);
+    }
+    if (weight < k)
+    {
+        return selectRecursive(k - weight - 1, curNode->right);
+    }
+    return curNode;
+}
+
+template<class T, class S>
+int AVLTree<T, S>::countLess(const T *key)
+{
+    int count = 0;
     AVLTreeNode<T, S> *curNode = root;
-    while (curNode->right != nullptr)
-        curNode = curNode->right;
-    return curNode->value;
+    while (curNode != nullptr)
+    {
+        if (*(curNode->key) < *key)
+        {
+            count += 1 + ((curNode->left != nullptr) ? curNode->left->nodesInSub : 0);
+            curNode = curNode->right;
+        }
+        else
+        {
+            curNode = curNode->left;
+        }
+    }
+    return count;
+}
+
+template<class T, class S>
+int AVLTree<T, S>::getSize() const
+{
+    return (root != nullptr) ? root->nodesInSub : 0;
+}
+
+template<class T, class S>
+bool AVLTree<T, S>::isValid() const
+{
+    const AVLTreeNode<T, S> *previous = nullptr;
+    if (validHeight(root, nullptr, previous) == -2)
+        return false;
+    if (root == nullptr)
+        return minNode == nullptr && maxNode == nullptr;
+
+    const AVLTreeNode<T, S> *smallest = root;
+    while (smallest->left != nullptr)
+        smallest = smallest->left;
+    return minNode == smallest && maxNode == previous;
+}
+
+template<class T, class S>
+int AVLTree<T, S>::validHeight(const AVLTreeNode<T, S> *node, const AVLTreeNode<T, S> *parent,
+                               const AVLTreeNode<T, S> *&previous)
+{
+    if (node == nullptr)
+        return -1;
+    if (node->parent != parent)
+        return -2;
+
+    int leftHeight = validHeight(node->left, node, previous);
+    if (leftHeight == -2 || (previous != nullptr && !(*(previous->key) < *(node->key))))
+        return -2;
+    previous = node;
+    int rightHeight = validHeight(node->right, node, previous);
+    if (rightHeight == -2)
+        return -2;
+
+    int leftSize = (node->left != nullptr) ? node->left->nodesInSub : 0;
+    int rightSize = (node->right != nullptr) ? node->right->nodesInSub : 0;
+    int height = ((leftHeight > rightHeight) ? leftHeight : rightHeight) + 1;
+    if (leftHeight - rightHeight > 1 || rightHeight - leftHeight > 1 || node->height != height ||
+        node->nodesInSub != leftSize + rightSize + 1)
+        return -2;
+    return height;
 }
 
 
@@ -1,6 +1,8 @@
 #ifndef DATASTRUCTURES_AVL_TREE_NODE_H
 #define DATASTRUCTURES_AVL_TREE_NODE_H
 
+#include "Stats.h"
+
 template<class T, class S>
 class AVLTree;
 
@@ -24,6 +26,7 @@ private:
     AVLTreeNode *right;
     AVLTreeNode *parent;
     int height;
+    int nodesInSub;
 
 
 
@@ -40,6 +43,8 @@ private:
     int balanceFactor();
     //Updates the height of the node in the tree
     void updateHeight();
+    //Updates the rank of the node in the tree
+    void updateRank();
     //Return the son type of the node in correlation to it's parent
     SonType getSonType();
 
@@ -50,8 +55,10 @@ private:
 
 template<class T, class S>
 AVLTreeNode<T, S>::AVLTreeNode(T *key, S *value) :
-        key(key), value(value), left(nullptr), right(nullptr), parent(nullptr), height(0)
-{}
+        key(key), value(value), left(nullptr), right(nullptr), parent(nullptr), height(0), nodesInSub(1)
+{
+    WC_STAT(stats().nodesAllocated++);
+}
 
 template<class T, class S>
 int AVLTreeNode<T, S>::balanceFactor()
@@ -96,6 +103,27 @@ void AVLTreeNode<T, S>::updateHeight()
     }
 }
 
+template<class T, class S>
+void AVLTreeNode<T, S>::updateRank()
+{
+    if (!left && !right)
+    {
+        this->nodesInSub = 1;
+    }
+    else if (!left)
+    {
+        this->nodesInSub = right->nodesInSub + 1;
+    }
+    else if (!right)
+    {
+        this->nodesInSub = left->nodesInSub + 1;
+    }
+    else
+    {
+        this->nodesInSub = left->nodesInSub + right->nodesInSub + 1;
+    }
+}
+
 template<class T, class S>
 enum SonType AVLTreeNode<T, S>::getSonType()
 {
@@ -0,0 +1,200 @@
+#ifndef ALLOCATOR_H_
+#define ALLOCATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+/*
+ * Where a world and its containers (AVLTree, Team) get their memory from. Everything a world
+ * allocates - teams, players, tree and chain nodes, temporary arrays - goes through the allocator
+ * it was built with, so arenas, allocation counting and failure injection plug in without
+ * touching the data structures. allocate() reports failure by throwing std::bad_alloc, like new.
+ */
+class Allocator
+{
+public:
+    virtual ~Allocator() = default;
+
+    virtual void *allocate(size_t size) = 0;
+    virtual void deallocate(void *pointer, size_t size) = 0;
+
+    /**
+     * Allocates and constructs an object, the memory is given back if the constructor throws.
+     * @return the new object
+     */
+    template<class T, class... Args>
+    T *create(Args &&... args)
+    {
+        void *memory = allocate(sizeof(T));
+        try
+        {
+            return new(memory) T(std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            deallocate(memory, sizeof(T));
+            throw;
+        }
+    }
+
+    /**
+     * Destroys an object made by create, does nothing for nullptr.
+     * @param object
+     */
+    template<class T>
+    void destroy(T *object)
+    {
+        if (object == nullptr)
+            return;
+        object->~T();
+        deallocate(object, sizeof(T));
+    }
+
+    /**
+     * Uninitialized array of trivially destructible elements (pointers, ints, Pair).
+     * @param count
+     * @return the array, never nullptr - even for count 0
+     */
+    template<class T>
+    T *allocateArray(size_t count)
+    {
+        return static_cast<T *>(allocate(sizeof(T) * (count > 0 ? count : 1)));
+    }
+
+    /**
+     * Gives back an array of allocateArray, does nothing for nullptr.
+     * @param array
+     * @param count - the count it was allocated with
+     */
+    template<class T>
+    void deallocateArray(T *array, size_t count)
+    {
+        if (array != nullptr)
+            deallocate(array, sizeof(T) * (count > 0 ? count : 1));
+    }
+};
+
+// Global operator new and delete. Objects it makes may also be freed with plain delete.
+class HeapAllocator : public Allocator
+{
+public:
+    void *allocate(size_t size) override;
+    void deallocate(void *pointer, size_t size) override;
+};
+
+// The allocator of worlds built without one
+Allocator &heapAllocator();
+
+/*
+ * Counts what passes through to another allocator and fails on request: failAfter(n) lets the
+ * next n allocations through and throws std::bad_alloc from the one after, once.
+ */
+class CountingAllocator : public Allocator
+{
+public:
+    explicit CountingAllocator(Allocator &backing = heapAllocator());
+
+    void *allocate(size_t size) override;
+    void deallocate(void *pointer, size_t size) override;
+
+    /**
+     * @param allowed - allocations to let through before the failing one, negative - never fail
+     */
+    void failAfter(long allowed);
+
+    uint64_t getAllocations() const;
+    uint64_t getDeallocations() const;
+    uint64_t getFailures() const;
+
+    // allocations not given back yet, and their bytes
+    uint64_t getLive() const;
+    uint64_t getLiveBytes() const;
+
+private:
+    Allocator &backing;
+    uint64_t allocations;
+    uint64_t deallocations;
+    uint64_t failures;
+    uint64_t liveBytes;
+    long untilFailure;
+};
+
+/*
+ * Fixed size slab pools: one per 16 byte size class up to MAX_SLAB_OBJECT. Objects are carved one
+ * after the other from the current slab of their class and freed ones are reused first, so objects
+ * created together sit together. Larger blocks (tables, temporary arrays) come from the backing
+ * allocator and are tracked. release() - and the destructor - give back all the slabs and blocks at
+ * once without running any destructor, which is how a world that owns one is torn down or reset.
+ * Not thread safe, a world owns its own.
+ */
+class SlabAllocator : public Allocator
+{
+public:
+    static const size_t GRANULE = 16;
+    static const size_t MAX_SLAB_OBJECT = 256;
+    static const size_t FIRST_SLAB_BYTES = 4096;
+    static const size_t MAX_SLAB_BYTES = 256 * 1024;
+
+    explicit SlabAllocator(Allocator &backing = heapAllocator());
+    ~SlabAllocator() override;
+    SlabAllocator(const SlabAllocator &) = delete;
+    SlabAllocator &operator=(const SlabAllocator &) = delete;
+
+    void *allocate(size_t size) override;
+    void deallocate(void *pointer, size_t size) override;
+
+    /**
+     * Gives back every slab and large block, everything allocated from here is gone.
+     */
+    void release();
+
+    /**
+     * Like release, but the slabs are kept and handed out again, to any size class. Large blocks
+     * are given back.
+     */
+    void recycle();
+
+    // bytes taken from the backing allocator, slabs and large blocks
+    uint64_t getReservedBytes() const;
+
+private:
+    struct FreeObject
+    {
+        FreeObject *next;
+    };
+
+    // at the start of every slab and large block, keeps what follows 16 byte aligned
+    struct alignas(16) Block
+    {
+        Block *previous;
+        Block *next;
+        size_t bytes;
+    };
+
+    struct SizeClass
+    {
+        FreeObject *freeList;
+        char *cursor; // the rest of the newest slab
+        char *end;
+        size_t nextSlabBytes;
+    };
+
+    static const int CLASSES = MAX_SLAB_OBJECT / GRANULE;
+
+    Allocator &backing;
+    SizeClass classes[CLASSES];
+    Block *slabs;
+    Block *idle; // recycled slabs, not in use by any size class
+    Block *large;
+    uint64_t reservedBytes;
+
+    Block *allocateBlock(Block *&list, size_t bytes);
+    void deallocateBlock(Block *&list, Block *block);
+    void releaseList(Block *&list);
+    Block *takeSlab(size_t bytes);
+    void resetClasses();
+};
+
+#endif //ALLOCATOR_H_
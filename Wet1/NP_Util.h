@@ -1,6 +1,8 @@
 #ifndef DATASTRUCTURES_NP_UTIL_H
 #define DATASTRUCTURES_NP_UTIL_H
 
+#include "Stats.h"
+
 template <class T>
 class Node
 {
@@ -10,12 +12,21 @@ public:
     Node* next;
 
     Node() = default;
-    explicit Node(T* value) : value(value) {}
+    explicit Node(T* value) : value(value)
+    {
+        WC_STAT(stats().nodesAllocated++);
+    }
 
     T* getValue()
     {
         return value;
     }
+
+    // the key of the value, for building trees of nodes
+    int* getIdPtr()
+    {
+        return value->getIdPtr();
+    }
 };
 
 class Pair
@@ -1,8 +1,15 @@
 #include "Player.h"
 
 Player::Player(int id, int goals, int cards, int gamesPlayed, bool isGoalKeeper, Team *team) :
-    id(id), goals(goals), cards(cards),gamesPlayed(gamesPlayed), isGoalKeeper(isGoalKeeper), team(team)
-{}
+    id(id), goals(goals), cards(cards),gamesPlayed(gamesPlayed), isGoalKeeper(isGoalKeeper), teamSet(team->getTeamSet())
+{
+    teamSet->links++;
+}
+
+Player::~Player()
+{
+    UnionFind::release(teamSet);
+}
 
 
 // Getter and Setters ---------------------------------------------------------------
@@ -10,7 +17,7 @@ Player::Player(int id, int goals, int cards, int gamesPlayed, bool isGoalKeeper,
 
 int Player::getGamesPlayed()
 {
-	return this->gamesPlayed + this->team->getTeamGamesPlayed();
+	return this->gamesPlayed + UnionFind::gamesPlayed(teamSet);
 }
 
 int Player::getId() const
@@ -40,12 +47,7 @@ bool Player::getIsGoalKeeper() const
 
 Team* Player::getTeam() const
 {
-    return team;
-}
-
-void Player::setTeam(Team *newTeam)
-{
-    team = newTeam;
+    return UnionFind::find(teamSet)->team;
 }
 
 void Player::updateStats(int addGamesPlayed, int addGoals, int addCards)
@@ -1,6 +1,7 @@
 #ifndef PLAYER_H_
 #define PLAYER_H_
 #include "Team.h"
+#include "UnionFind.h"
 
 class Team;
 
@@ -13,7 +14,7 @@ public:
 	 * Explicitly telling the compiler to use the default methods
 	*/
     Player(const Player&) = delete;
-    ~Player() = default;
+    ~Player();
     Player& operator=(const Player& other) = delete;
 
 
@@ -26,8 +27,8 @@ public:
 	int getGoals() const;
 	int getCards() const;
 	bool getIsGoalKeeper() const;
+	// finds the team through the set of the team the player was added to
 	Team* getTeam() const;
-    void setTeam(Team *newTeam);
     void updateStats(int addGamesPlayed, int addGoals, int addCards);
 
     bool operator==(const Player &other) const;
@@ -42,7 +43,7 @@ private:
 	int cards;
 	int gamesPlayed;
 	bool isGoalKeeper;
-	Team *team;
+	TeamSet *teamSet;
 };
 
 #endif //PLAYER_H_
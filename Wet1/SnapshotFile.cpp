@@ -0,0 +1,244 @@
+#include "SnapshotFile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+
+namespace
+{
+    const char MAGIC[8] = {'W', 'C', '1', 'S', 'N', 'A', 'P', '\0'};
+
+    size_t imageSize(uint32_t teamCount, uint32_t playerCount)
+    {
+        return sizeof(SnapshotHeader) + teamCount * sizeof(TeamRecord) +
+               playerCount * (sizeof(PlayerRecord) + sizeof(uint32_t));
+    }
+
+    int teamIndexOf(Team **teamsArr, int teamsAmount, int teamId)
+    {
+        int low = 0, high = teamsAmount - 1;
+        while (low <= high)
+        {
+            int mid = low + (high - low) / 2;
+            if (teamsArr[mid]->getId() == teamId)
+                return mid;
+            if (teamsArr[mid]->getId() < teamId)
+                low = mid + 1;
+            else
+                high = mid - 1;
+        }
+        return -1;
+    }
+
+    int sortedIndexOf(Node<Player> **playersInOrder, int playersAmount, const Player *player)
+    {
+        int low = 0, high = playersAmount - 1;
+        while (low <= high)
+        {
+            int mid = low + (high - low) / 2;
+            if (*(playersInOrder[mid]->value) == *player)
+                return mid;
+            if (*(playersInOrder[mid]->value) < *player)
+                low = mid + 1;
+            else
+                high = mid - 1;
+        }
+        return -1;
+    }
+
+    // the playersSorted order: goals up, then cards down, then id up
+    bool sortedBefore(const PlayerRecord &first, const PlayerRecord &second)
+    {
+        if (first.goals != second.goals)
+            return first.goals < second.goals;
+        if (first.cards != second.cards)
+            return first.cards > second.cards;
+        return first.id < second.id;
+    }
+
+    /*
+     * The teams are sorted by id, the players are in playersSorted order and idOrder lists them by
+     * id. With the indices in range and the ids increasing along it, idOrder is a permutation.
+     */
+    bool validRecords(const TeamRecord *teams, int teamCount, const PlayerRecord *players,
+                      const uint32_t *idOrder, int playerCount)
+    {
+        for (int i = 0; i < teamCount; ++i)
+        {
+            if (teams[i].id <= 0 || (i > 0 && teams[i - 1].id >= teams[i].id))
+                return false;
+        }
+        for (int i = 0; i < playerCount; ++i)
+        {
+            if (players[i].id <= 0 || players[i].team < 0 || players[i].team >= teamCount ||
+                (i > 0 && !sortedBefore(players[i - 1], players[i])))
+                return false;
+            if (idOrder[i] >= (uint32_t) playerCount ||
+                (i > 0 && players[idOrder[i - 1]].id >= players[idOrder[i]].id))
+                return false;
+        }
+        return true;
+    }
+}
+
+SnapshotFile::SnapshotFile(char *data) : data(data), header(reinterpret_cast<const SnapshotHeader *>(data))
+{}
+
+SnapshotFile::~SnapshotFile()
+{
+    delete[] data;
+}
+
+bool SnapshotFile::write(const char *path, uint64_t sequence, Team **teamsArr, int teamsAmount,
+                         Node<Player> **playersInOrder, Player **playersById, int playersAmount)
+{
+    size_t size = imageSize(teamsAmount, playersAmount);
+    char *image = new char[size];
+    std::memset(image, 0, size);
+
+    SnapshotHeader *header = reinterpret_cast<SnapshotHeader *>(image);
+    std::memcpy(header->magic, MAGIC, sizeof(MAGIC));
+    header->version = SnapshotHeader::VERSION;
+    header->teamCount = teamsAmount;
+    header->sequence = sequence;
+    header->playerCount = playersAmount;
+
+    TeamRecord *teamRecords = reinterpret_cast<TeamRecord *>(image + sizeof(SnapshotHeader));
+    PlayerRecord *playerRecords = reinterpret_cast<PlayerRecord *>(teamRecords + teamsAmount);
+    uint32_t *idOrder = reinterpret_cast<uint32_t *>(playerRecords + playersAmount);
+
+    for (int i = 0; i < teamsAmount; ++i)
+    {
+        teamRecords[i].id = teamsArr[i]->getId();
+        teamRecords[i].points = teamsArr[i]->getPoints();
+        teamRecords[i].teamGamesPlayed = teamsArr[i]->getTeamGamesPlayed();
+    }
+    for (int i = 0; i < playersAmount; ++i)
+    {
+        Player *player = playersInOrder[i]->value;
+        playerRecords[i].id = player->getId();
+        playerRecords[i].goals = player->getGoals();
+        playerRecords[i].cards = player->getCards();
+        playerRecords[i].gamesPlayed = player->getGamesPlayed() - player->getTeam()->getTeamGamesPlayed();
+        playerRecords[i].team = teamIndexOf(teamsArr, teamsAmount, player->getTeam()->getId());
+        playerRecords[i].isGoalKeeper = player->getIsGoalKeeper();
+    }
+    for (int i = 0; i < playersAmount; ++i)
+    {
+        idOrder[i] = sortedIndexOf(playersInOrder, playersAmount, playersById[i]);
+    }
+
+    std::string tempPath = std::string(path) + ".tmp";
+    FILE *file = std::fopen(tempPath.c_str(), "wb");
+    bool ok = (file != nullptr);
+    if (ok)
+    {
+        ok = std::fwrite(image, 1, size, file) == size;
+        ok = (std::fflush(file) == 0) && ok;
+        ok = ok && (fsync(fileno(file)) == 0);
+        ok = (std::fclose(file) == 0) && ok;
+        ok = ok && (std::rename(tempPath.c_str(), path) == 0);
+        if (!ok)
+            std::remove(tempPath.c_str());
+    }
+
+    delete[] image;
+    return ok;
+}
+
+SnapshotFile *SnapshotFile::read(const char *path)
+{
+    FILE *file = std::fopen(path, "rb");
+    if (file == nullptr)
+        return nullptr;
+
+    SnapshotHeader header;
+    if (std::fread(&header, sizeof(header), 1, file) != 1 ||
+        std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != SnapshotHeader::VERSION)
+    {
+        std::fclose(file);
+        return nullptr;
+    }
+
+    std::fseek(file, 0, SEEK_END);
+    long end = std::ftell(file);
+    size_t size = imageSize(header.teamCount, header.playerCount);
+    if (end < 0 || (size_t) end != size)
+    {
+        std::fclose(file);
+        return nullptr;
+    }
+
+    char *image;
+    try
+    {
+        image = new char[size];
+    }
+    catch (const std::bad_alloc &e)
+    {
+        std::fclose(file);
+        throw;
+    }
+    std::fseek(file, 0, SEEK_SET);
+    bool ok = std::fread(image, 1, size, file) == size;
+    std::fclose(file);
+
+    SnapshotFile *snapshot = nullptr;
+    if (ok)
+    {
+        try
+        {
+            snapshot = new SnapshotFile(image);
+        }
+        catch (const std::bad_alloc &e)
+        {
+            delete[] image;
+            throw;
+        }
+    }
+    else
+    {
+        delete[] image;
+        return nullptr;
+    }
+
+    // indices and orders are trusted from here on, so check them once
+    if (!validRecords(snapshot->getTeams(), snapshot->getTeamCount(), snapshot->getPlayers(),
+                      snapshot->getIdOrder(), snapshot->getPlayerCount()))
+    {
+        delete snapshot;
+        return nullptr;
+    }
+    return snapshot;
+}
+
+uint64_t SnapshotFile::getSequence() const
+{
+    return header->sequence;
+}
+
+int SnapshotFile::getTeamCount() const
+{
+    return (int) header->teamCount;
+}
+
+int SnapshotFile::getPlayerCount() const
+{
+    return (int) header->playerCount;
+}
+
+const TeamRecord *SnapshotFile::getTeams() const
+{
+    return reinterpret_cast<const TeamRecord *>(data + sizeof(SnapshotHeader));
+}
+
+const PlayerRecord *SnapshotFile::getPlayers() const
+{
+    return reinterpret_cast<const PlayerRecord *>(getTeams() + header->teamCount);
+}
+
+const uint32_t *SnapshotFile::getIdOrder() const
+{
+    return reinterpret_cast<const uint32_t *>(getPlayers() + header->playerCount);
+}
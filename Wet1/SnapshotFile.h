@@ -0,0 +1,92 @@
+#ifndef SNAPSHOT_FILE_H_
+#define SNAPSHOT_FILE_H_
+
+#include <cstdint>
+#include <cstddef>
+#include "Player.h"
+#include "Team.h"
+#include "NP_Util.h"
+
+class Player;
+class Team;
+
+/*
+ * Compact on-disk snapshot of a world. Every ordered set is stored once, as a sorted array:
+ *
+ *  header
+ *  TeamRecord[teamCount]       - teams sorted by id
+ *  PlayerRecord[playerCount]   - players sorted by (goals, cards, id), the playersSorted order
+ *  uint32_t[playerCount]       - indices into the player records, in id order
+ *
+ * Per team orders, playable teams and the player/team lists are all derived from these in one pass.
+ */
+
+struct SnapshotHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t teamCount;
+    uint64_t sequence;      // position in the op log this snapshot reflects
+    uint32_t playerCount;
+    uint32_t reserved;
+
+    static const uint32_t VERSION = 1;
+};
+
+struct TeamRecord
+{
+    int32_t id;
+    int32_t points;
+    int32_t teamGamesPlayed;
+};
+
+struct PlayerRecord
+{
+    int32_t id;
+    int32_t goals;
+    int32_t cards;
+    int32_t gamesPlayed;    // without the team's games
+    int32_t team;           // index in the team records
+    uint8_t isGoalKeeper;
+    uint8_t reserved[3];
+};
+
+
+class SnapshotFile
+{
+public:
+    /**
+     * Writes a snapshot to path (through a temporary file, replaced atomically).
+     * @param teamsArr - the teams sorted by id
+     * @param playersInOrder - the players in playersSorted order
+     * @param playersById - the same players sorted by id
+     * @return false on a write error
+     */
+    static bool write(const char *path, uint64_t sequence, Team **teamsArr, int teamsAmount,
+                      Node<Player> **playersInOrder, Player **playersById, int playersAmount);
+
+    /**
+     * Reads a whole snapshot file into memory.
+     * @return nullptr if the file is missing, is not a valid snapshot or holds records out of order
+     */
+    static SnapshotFile *read(const char *path);
+
+    ~SnapshotFile();
+    SnapshotFile(const SnapshotFile &) = delete;
+    SnapshotFile &operator=(const SnapshotFile &) = delete;
+
+    uint64_t getSequence() const;
+    int getTeamCount() const;
+    int getPlayerCount() const;
+    const TeamRecord *getTeams() const;
+    const PlayerRecord *getPlayers() const;
+    const uint32_t *getIdOrder() const;
+
+private:
+    char *data;
+    const SnapshotHeader *header;
+
+    explicit SnapshotFile(char *data);
+};
+
+#endif //SNAPSHOT_FILE_H_
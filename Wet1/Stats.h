@@ -0,0 +1,71 @@
+#ifndef STATS_H_
+#define STATS_H_
+
+#include <cstdint>
+#include <ostream>
+
+/*
+ * Hot path counters, compiled in only when WC_ENABLE_STATS is defined (cmake -DWC_STATS=ON).
+ * Without it every WC_STAT(...) expands to an empty statement and nothing is counted.
+ *
+ * The counters live in one thread local Stats, so they cover every world of the calling thread.
+ */
+
+#ifdef WC_ENABLE_STATS
+#define WC_STAT(statement) statement
+#else
+#define WC_STAT(statement)
+#endif
+
+// Distribution of small counts: bucket i holds the samples equal to i, the last one everything above
+class Histogram
+{
+public:
+    static const int BUCKETS = 16;
+
+    Histogram();
+
+    void add(uint64_t value);
+    void reset();
+
+    uint64_t getCount() const;
+    uint64_t getMax() const;
+    double getMean() const;
+    uint64_t getBucket(int i) const;
+
+    // one line: count, mean, max and the non empty buckets
+    void print(std::ostream &os, const char *name) const;
+
+private:
+    uint64_t buckets[BUCKETS];
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+};
+
+struct Stats
+{
+    // rebalancing rotations (a double rotation counts once) per AVLTree insert and remove
+    Histogram insertRotations;
+    Histogram removeRotations;
+    uint64_t rotations;
+
+    // tree and list nodes
+    uint64_t nodesAllocated;
+
+    Stats();
+
+    void reset();
+    void print(std::ostream &os) const;
+};
+
+#ifdef WC_ENABLE_STATS
+// The counters of the calling thread
+inline Stats &stats()
+{
+    static thread_local Stats current;
+    return current;
+}
+#endif
+
+#endif //STATS_H_
@@ -1,15 +1,27 @@
 #include "Team.h"
 
-Team::Team(int id, int points) :
+Team::Team(int id, int points, Allocator &allocator) :
     id(id), points(points), matchScore(points), playerCount(0), goalKeeperCount(0),
-    players(new AVLTree<int, Player>), playersSorted(new AVLTree<Player, Node<Player>>),
-    topScorer(nullptr), teamGamesPlayed(0)
-{}
+    playersSorted(allocator.create<AVLTree<Player, Node<Player>>>(allocator)),
+    topScorer(nullptr), teamSet(nullptr), allocator(&allocator)
+{
+    try
+    {
+        teamSet = allocator.create<TeamSet>(this, allocator);
+    }
+    catch (const std::bad_alloc &e)
+    {
+        allocator.destroy(playersSorted);
+        throw;
+    }
+}
 
 Team::~Team()
 {
-    delete players;
-    delete playersSorted;
+    allocator->destroy(playersSorted);
+    if (teamSet->team == this)
+        teamSet->team = nullptr;
+    UnionFind::release(teamSet);
 }
 
 bool Team::isLegal() const
@@ -21,6 +33,11 @@ bool Team::isLegal() const
 	return false;
 }
 
+bool Team::isLegalWith(const Team &other) const
+{
+	return goalKeeperCount + other.goalKeeperCount > 0 && playerCount + other.playerCount >= MIN_PLAYER_AMOUNT;
+}
+
 // Getter and Setters ---------------------------------------------------------------
 
 int Team::getId() const
@@ -33,6 +50,11 @@ int* Team::getIdPtr()
     return &id;
 }
 
+void Team::setId(int newId)
+{
+    id = newId;
+}
+
 int Team::getPoints() const
 {
     return points;
@@ -74,17 +96,6 @@ void Team::updateGoalKeeperCount(int amount)
     goalKeeperCount += amount;
 }
 
-AVLTree<int, Player> *Team::getPlayers()
-{
-    return players;
-}
-
-void Team::setPlayers(AVLTree<int, Player>* tree)
-{
-    delete players;
-    players = tree;
-}
-
 AVLTree<Player, Node<Player>> *Team::getPlayersSorted()
 {
     return playersSorted;
@@ -92,7 +103,7 @@ AVLTree<Player, Node<Player>> *Team::getPlayersSorted()
 
 void Team::setPlayersSorted(AVLTree<Player, Node<Player>>* tree)
 {
-    delete playersSorted;
+    allocator->destroy(playersSorted);
     playersSorted = tree;
 }
 
@@ -106,19 +117,29 @@ void Team::setTopScorer(Player *newTopScorer)
     this->topScorer = newTopScorer;
 }
 
+TeamSet *Team::getTeamSet()
+{
+    return teamSet;
+}
+
 int Team::getTeamGamesPlayed() const
 {
-    return teamGamesPlayed;
+    return teamSet->gamesPlayed;
 }
 
 void Team::updateTeamGamesPlayed()
 {
-    teamGamesPlayed += 1;
+    teamSet->gamesPlayed += 1;
+}
+
+void Team::updateTeamGamesPlayed(int amount)
+{
+    teamSet->gamesPlayed += amount;
 }
 
 void Team::resetTeamGamesPlayed()
 {
-    teamGamesPlayed = 0;
+    teamSet->gamesPlayed = 0;
 }
 
 // End of Getter and Setters ---------------------------------------------------------------
\ No newline at end of file
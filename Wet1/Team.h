@@ -4,13 +4,20 @@
 #include "Player.h"
 #include "AVLTree.h"
 #include "NP_Util.h"
+#include "Allocator.h"
+#include "UnionFind.h"
 
 class Player;
 
 class Team
 {
 public:
-    Team(int id, int points);
+    /**
+     * @param id
+     * @param points
+     * @param allocator - of the team's trees, set trees have to come from it too
+     */
+    Team(int id, int points, Allocator &allocator = heapAllocator());
 
     /*
 	 * Explicitly telling the compiler to use the default methods
@@ -21,6 +28,8 @@ public:
 
 	//returns if the team is legal for playing
 	bool isLegal() const;
+	//returns if the team would be legal for playing with the players of other added
+	bool isLegalWith(const Team &other) const;
 
 
     /*
@@ -28,6 +37,8 @@ public:
     */
     int getId() const;
     int* getIdPtr();
+    // the team has to be out of every tree keyed by its id while it changes
+    void setId(int newId);
     int getPoints() const;
     void updatePoints(int amount);
     int getMatchScore() const;
@@ -36,14 +47,15 @@ public:
     void updatePlayerCount(int amount);
     int getGoalKeeperCount() const;
     void updateGoalKeeperCount(int amount);
-    AVLTree<int, Player> *getPlayers();
-    void setPlayers(AVLTree<int, Player>* tree);
     AVLTree<Player, Node<Player>> *getPlayersSorted();
     void setPlayersSorted(AVLTree<Player, Node<Player>>* tree);
     Player *getTopScorer() const;
     void setTopScorer(Player *newTopScorer);
+    // the root of the set the team's players are in
+    TeamSet *getTeamSet();
     int getTeamGamesPlayed() const;
     void updateTeamGamesPlayed();
+    void updateTeamGamesPlayed(int amount);
     void resetTeamGamesPlayed();
 
 
@@ -53,10 +65,11 @@ private:
 	int matchScore;
 	int playerCount;
 	int goalKeeperCount;
-    AVLTree<int, Player> *players;
     AVLTree<Player, Node<Player>> *playersSorted;
 	Player *topScorer;
-	int teamGamesPlayed;
+	// holds the team's games played, which its players' games are counted from
+	TeamSet *teamSet;
+    Allocator *allocator;
 
     static const int MIN_PLAYER_AMOUNT = 11;
 };
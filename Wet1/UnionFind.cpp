@@ -0,0 +1,71 @@
+#include "UnionFind.h"
+
+TeamSet::TeamSet(Team *team, Allocator &allocator) :
+    parent(nullptr), team(team), gamesPlayed(0), links(1), allocator(&allocator)
+{}
+
+TeamSet *UnionFind::find(TeamSet *set)
+{
+    TeamSet *root = set;
+    // the offset from the current set up to the root, without the root's own
+    int sum = 0;
+    while (root->parent != nullptr)
+    {
+        sum += root->gamesPlayed;
+        root = root->parent;
+    }
+
+    TeamSet *cur = set;
+    while (cur->parent != nullptr && cur->parent != root)
+    {
+        TeamSet *parent = cur->parent;
+        int ownGames = cur->gamesPlayed;
+        if (cur->links == 0)
+        {
+            // only the set below pointed here and it moved to the root
+            cur->allocator->destroy(cur);
+        }
+        else
+        {
+            cur->gamesPlayed = sum;
+            cur->parent = root;
+            root->links++;
+        }
+        parent->links--;
+        sum -= ownGames;
+        cur = parent;
+    }
+    if (cur->parent != nullptr && cur->links == 0)
+    {
+        root->links--;
+        cur->allocator->destroy(cur);
+    }
+    return root;
+}
+
+int UnionFind::gamesPlayed(TeamSet *set)
+{
+    TeamSet *root = find(set);
+    if (set == root)
+        return set->gamesPlayed;
+    return set->gamesPlayed + root->gamesPlayed;
+}
+
+TeamSet *UnionFind::unite(TeamSet *largeRoot, TeamSet *smallRoot)
+{
+    smallRoot->parent = largeRoot;
+    smallRoot->team = nullptr;
+    smallRoot->gamesPlayed -= largeRoot->gamesPlayed;
+    largeRoot->links++;
+    return largeRoot;
+}
+
+void UnionFind::release(TeamSet *set)
+{
+    while (set != nullptr && --set->links == 0)
+    {
+        TeamSet *parent = set->parent;
+        set->allocator->destroy(set);
+        set = parent;
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef UNIONFIND_H_
+#define UNIONFIND_H_
+
+#include "Allocator.h"
+
+class Team;
+
+/*
+ * The set a team's players belong to. Every team starts with its own set, and every player keeps
+ * the set of the team it was added to. Uniting teams links the smaller team's set under the
+ * larger one's, so the players of either team are never touched.
+ */
+class TeamSet
+{
+public:
+    TeamSet(Team *team, Allocator &allocator);
+
+    TeamSet(const TeamSet&) = delete;
+    TeamSet& operator=(const TeamSet& other) = delete;
+
+    // nullptr for a root
+    TeamSet *parent;
+    // the team of a root, nullptr below it
+    Team *team;
+    // games played by the team of a root, for the others relative to the parent
+    int gamesPlayed;
+    // players, child sets and the team pointing here, the set is freed when none are left
+    int links;
+    Allocator *allocator;
+};
+
+class UnionFind
+{
+public:
+    /**
+     * Finds the root of the set and links the sets on the way directly to it.
+     * A set nothing points to anymore is freed on the way.
+     * @param set
+     * @return the root
+     */
+    static TeamSet *find(TeamSet *set);
+
+    /**
+     * Games played by the team of set's root, counted from when the set was made
+     * @param set
+     * @return
+     */
+    static int gamesPlayed(TeamSet *set);
+
+    /**
+     * Links the root small under the root large, the offsets of small's sets are kept
+     * @param largeRoot
+     * @param smallRoot
+     * @return largeRoot
+     */
+    static TeamSet *unite(TeamSet *largeRoot, TeamSet *smallRoot);
+
+    /**
+     * Drops one link to the set, freeing it (and then its parents) once nothing points to it
+     * @param set
+     */
+    static void release(TeamSet *set);
+};
+
+#endif //UNIONFIND_H_
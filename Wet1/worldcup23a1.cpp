@@ -1,21 +1,80 @@
 #include "worldcup23a1.h"
 
-world_cup_t::world_cup_t()
-{
-    topScorer = nullptr;
-    playerCount = 0;
-}
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+world_cup_t::world_cup_t() : world_cup_t(slabs)
+{}
+
+world_cup_t::world_cup_t(Allocator &allocator) :
+    players(allocator), playersSorted(allocator), teams(allocator), playableTeams(allocator),
+    topScorer(nullptr), playerCount(0), teamsCount(0), allocator(&allocator), knockoutCache(), knockoutVersion(1),
+    knockoutThreads(1)
+{}
+
+world_cup_t::world_cup_t(Player **playersById, Node<Player> **playersInOrder, int playersAmount,
+                         Team **teamsById, int teamsAmount, Node<Team> **playableById, int playableAmount,
+                         Allocator &allocator) :
+    players(playersById, playersAmount, (int *(Player::*)() const) &Player::getIdPtr, allocator),
+    playersSorted(playersInOrder, playersAmount, (Player *(Node<Player>::*)() const) &Node<Player>::getValue,
+                  allocator),
+    teams(teamsById, teamsAmount, (int *(Team::*)() const) &Team::getIdPtr, allocator),
+    playableTeams(playableById, playableAmount, (int *(Node<Team>::*)() const) &Node<Team>::getIdPtr, allocator),
+    topScorer(playersAmount > 0 ? playersInOrder[playersAmount - 1]->value : nullptr),
+    playerCount(playersAmount), teamsCount(teamsAmount), allocator(&allocator), knockoutCache(),
+    knockoutVersion(1), knockoutThreads(1)
+{}
 
 world_cup_t::~world_cup_t()
 {
+    if (allocator == &slabs)
+    {
+        // everything the world made is in its slabs, they go back whole right after this
+        players.abandon();
+        playersSorted.abandon();
+        teams.abandon();
+        playableTeams.abandon();
+        return;
+    }
     players.releaseValues();
     playersSorted.releaseValues();
     teams.releaseValues();
     playableTeams.releaseValues();
 }
 
+void world_cup_t::reset()
+{
+    OpTimer timer(Operation::RESET);
+    knockoutVersion++;
+    if (allocator == &slabs)
+    {
+        players.abandon();
+        playersSorted.abandon();
+        teams.abandon();
+        playableTeams.abandon();
+        slabs.recycle();
+    }
+    else
+    {
+        players.releaseValues();
+        playersSorted.releaseValues();
+        teams.releaseValues();
+        playableTeams.releaseValues();
+        players.clear();
+        playersSorted.clear();
+        teams.clear();
+        playableTeams.clear();
+    }
+    topScorer = nullptr;
+    playerCount = 0;
+    teamsCount = 0;
+}
+
 StatusType world_cup_t::add_team(int teamId, int points)
 {
+    OpTimer timer(Operation::ADD_TEAM);
     if ((teamId <= 0) || (points < 0))
     {
         return StatusType::INVALID_INPUT;
@@ -29,7 +88,7 @@ StatusType world_cup_t::add_team(int teamId, int points)
 
     try
     {
-        newTeam = new Team(teamId, points);
+        newTeam = allocator->create<Team>(teamId, points, *allocator);
     }
     catch (const std::bad_alloc &e)
     {
@@ -42,15 +101,18 @@ StatusType world_cup_t::add_team(int teamId, int points)
     }
     catch (const std::bad_alloc &e)
     {
-        delete newTeam;
+        allocator->destroy(newTeam);
         return StatusType::ALLOCATION_ERROR;
     }
+    teamsCount++;
+    knockoutVersion++;
 
     return StatusType::SUCCESS;
 }
 
 StatusType world_cup_t::remove_team(int teamId)
 {
+    OpTimer timer(Operation::REMOVE_TEAM);
     if (teamId <= 0)
     {
         return StatusType::INVALID_INPUT;
@@ -60,8 +122,10 @@ StatusType world_cup_t::remove_team(int teamId)
     if (team == nullptr) return StatusType::FAILURE;
     if (team->getPlayerCount() != 0) return StatusType::FAILURE;
 
+    knockoutVersion++;
     teams.remove(&teamId);
-    delete team;
+    teamsCount--;
+    allocator->destroy(team);
 
     return StatusType::SUCCESS;
 }
@@ -69,6 +133,7 @@ StatusType world_cup_t::remove_team(int teamId)
 StatusType world_cup_t::add_player(int playerId, int teamId, int gamesPlayed,
                                    int goals, int cards, bool goalKeeper)
 {
+    OpTimer timer(Operation::ADD_PLAYER);
     if ((playerId <= 0) || (teamId <= 0) || (gamesPlayed < 0) || (goals < 0) || (cards < 0))
     {
         return StatusType::INVALID_INPUT;
@@ -83,79 +148,60 @@ StatusType world_cup_t::add_player(int playerId, int teamId, int gamesPlayed,
     {
         return StatusType::FAILURE;
     }
-    Player *newPlayer;
-    Node<Player> *newPlayerNode;
+    Player *newPlayer = nullptr;
+    Node<Player> *newPlayerNode = nullptr;
+    Node<Team> *teamNode = nullptr;
 
-    try
-    {
-        newPlayer = new Player(playerId, goals, cards, (gamesPlayed - team->getTeamGamesPlayed()), goalKeeper, team);
-    }
-    catch (const std::bad_alloc &e)
-    {
-        return StatusType::ALLOCATION_ERROR;
-    }
-    int *newKey = newPlayer->getIdPtr();
-    try
-    {
-        newPlayerNode = new Node<Player>(newPlayer);
-    }
-    catch (const std::bad_alloc &e)
+    team->updatePlayerCount(1);
+    if (goalKeeper)
     {
-        delete newPlayer;
-        return StatusType::ALLOCATION_ERROR;
+        team->updateGoalKeeperCount(1);
     }
 
+    // everything is allocated before the world changes, so running out of memory leaves it as it was
     try
     {
-        players.insert(newKey, newPlayer);
-        playersSorted.insert(newPlayer, newPlayerNode);
-        team->getPlayers()->insert(newKey, newPlayer);
-        team->getPlayersSorted()->insert(newPlayer, newPlayerNode);
+        newPlayer = allocator->create<Player>(playerId, goals, cards, (gamesPlayed - team->getTeamGamesPlayed()),
+                                              goalKeeper, team);
+        newPlayerNode = allocator->create<Node<Player>>(newPlayer);
+        if (team->isLegal() && (playableTeams.find(&teamId) == nullptr))
+        {
+            teamNode = allocator->create<Node<Team>>(team);
+            playableTeams.reserve();
+        }
+        players.reserve();
+        playersSorted.reserve();
+        team->getPlayersSorted()->reserve();
     }
     catch (const std::bad_alloc &e)
     {
-        delete newPlayer;
-        delete newPlayerNode;
+        team->updatePlayerCount(-1);
+        if (goalKeeper)
+        {
+            team->updateGoalKeeperCount(-1);
+        }
+        allocator->destroy(teamNode);
+        allocator->destroy(newPlayerNode);
+        allocator->destroy(newPlayer);
         return StatusType::ALLOCATION_ERROR;
     }
+
+    knockoutVersion++;
+    int *newKey = newPlayer->getIdPtr();
+    players.insert(newKey, newPlayer);
+    playersSorted.insert(newPlayer, newPlayerNode);
+    team->getPlayersSorted()->insert(newPlayer, newPlayerNode);
+
     playerCount++;
     topScorer = playersSorted.findMax()->value;
     listInsert(newPlayerNode);
 
-    team->updatePlayerCount(1);
-    if (goalKeeper)
-    {
-        team->updateGoalKeeperCount(1);
-    }
-
     team->updateMatchScore(goals - cards);
     team->setTopScorer(team->getPlayersSorted()->findMax()->value);
 
-    if (team->isLegal() && (playableTeams.find(&teamId) == nullptr))
+    if (teamNode != nullptr)
     {
-        Node<Team> *teamNode;
-        try
-        {
-            teamNode = new Node<Team>(team);
-        }
-        catch (const std::bad_alloc &e)
-        {
-            delete newPlayer;
-            delete newPlayerNode;
-            return StatusType::ALLOCATION_ERROR;
-        }
-        try
-        {
-            playableTeams.insert(team->getIdPtr(), teamNode);
-        }
-        catch (const std::bad_alloc &e)
-        {
-            delete newPlayer;
-            delete newPlayerNode;
-            delete teamNode;
-            return StatusType::ALLOCATION_ERROR;
-        }
-
+        playableTeams.insert(team->getIdPtr(), teamNode);
         listInsert(teamNode);
     }
 
@@ -164,6 +210,7 @@ StatusType world_cup_t::add_player(int playerId, int teamId, int gamesPlayed,
 
 StatusType world_cup_t::remove_player(int playerId)
 {
+    OpTimer timer(Operation::REMOVE_PLAYER);
     if (playerId <= 0)
     {
         return StatusType::INVALID_INPUT;
@@ -175,9 +222,9 @@ StatusType world_cup_t::remove_player(int playerId)
     Node<Player> *playerNode = playersSorted.find(player);
     Team *team = player->getTeam();
 
+    knockoutVersion++;
     players.remove(&playerId);
     playersSorted.remove(player);
-    team->getPlayers()->remove(&playerId);
     team->getPlayersSorted()->remove(player);
 
     playerCount--;
@@ -204,11 +251,11 @@ StatusType world_cup_t::remove_player(int playerId)
     {
         playableTeams.remove(team->getIdPtr());
         listRemove(teamNode);
-        delete teamNode;
+        allocator->destroy(teamNode);
     }
 
-    delete playerNode;
-    delete player;
+    allocator->destroy(playerNode);
+    allocator->destroy(player);
 
     return StatusType::SUCCESS;
 }
@@ -216,6 +263,7 @@ StatusType world_cup_t::remove_player(int playerId)
 StatusType world_cup_t::update_player_stats(int playerId, int gamesPlayed,
                                             int scoredGoals, int cardsReceived)
 {
+    OpTimer timer(Operation::UPDATE_PLAYER_STATS);
     if ((playerId <= 0) || (gamesPlayed < 0) || (scoredGoals < 0) || (cardsReceived < 0))
     {
         return StatusType::INVALID_INPUT;
@@ -227,24 +275,23 @@ StatusType world_cup_t::update_player_stats(int playerId, int gamesPlayed,
     Team *team = player->getTeam();
     Node<Player> *playerNode = playersSorted.find(player);
 
-    listRemove(playerNode);
-    playersSorted.remove(player);
-    team->getPlayersSorted()->remove(player);
-
-    player->updateStats(gamesPlayed, scoredGoals, cardsReceived);
+    knockoutVersion++;
+    // the player moves in both sorted trees, which keep their nodes - nothing is allocated. The
+    // new neighbours come back from the move, so the list needs no search.
+    Node<Player> *previous;
+    Node<Player> *next;
+    playersSorted.rekey(player, [&]() {
+        team->getPlayersSorted()->rekey(player, [&]() {
+            player->updateStats(gamesPlayed, scoredGoals, cardsReceived);
+        });
+    }, &previous, &next);
     team->updateMatchScore(scoredGoals - cardsReceived);
 
-    try
+    if ((playerNode->previous != previous) || (playerNode->next != next))
     {
-        playersSorted.insert(player, playerNode);
-        team->getPlayersSorted()->insert(player, playerNode);
+        listRemove(playerNode);
+        listInsert(playerNode, previous, next);
     }
-    catch (const std::bad_alloc &e)
-    {
-        return StatusType::ALLOCATION_ERROR;
-    }
-
-    listInsert(playerNode);
     topScorer = playersSorted.findMax()->value;
     team->setTopScorer(team->getPlayersSorted()->findMax()->value);
 
@@ -253,6 +300,7 @@ StatusType world_cup_t::update_player_stats(int playerId, int gamesPlayed,
 
 StatusType world_cup_t::play_match(int teamId1, int teamId2)
 {
+    OpTimer timer(Operation::PLAY_MATCH);
     if ((teamId1 <= 0) || (teamId2 <= 0) || (teamId1 == teamId2))
     {
         return StatusType::INVALID_INPUT;
@@ -264,6 +312,7 @@ StatusType world_cup_t::play_match(int teamId1, int teamId2)
     if ((team1 == nullptr) || (team2 == nullptr)) return StatusType::FAILURE;
     if (!(team1->isLegal() && team2->isLegal())) return StatusType::FAILURE;
 
+    knockoutVersion++;
     if (team1->getMatchScore() > team2->getMatchScore())
     {
         team1->updatePoints(3);
@@ -286,6 +335,7 @@ StatusType world_cup_t::play_match(int teamId1, int teamId2)
 
 output_t<int> world_cup_t::get_num_played_games(int playerId)
 {
+    OpTimer timer(Operation::GET_NUM_PLAYED_GAMES);
     if (playerId <= 0)
     {
         return StatusType::INVALID_INPUT;
@@ -300,6 +350,7 @@ output_t<int> world_cup_t::get_num_played_games(int playerId)
 
 output_t<int> world_cup_t::get_team_points(int teamId)
 {
+    OpTimer timer(Operation::GET_TEAM_POINTS);
     if (teamId <= 0)
     {
         return StatusType::INVALID_INPUT;
@@ -313,6 +364,7 @@ output_t<int> world_cup_t::get_team_points(int teamId)
 
 StatusType world_cup_t::unite_teams(int teamId1, int teamId2, int newTeamId)
 {
+    OpTimer timer(Operation::UNITE_TEAMS);
     if (newTeamId <= 0 || teamId1 <= 0 || teamId2 <= 0 || teamId1 == teamId2)
         return StatusType::INVALID_INPUT;
 
@@ -329,61 +381,79 @@ StatusType world_cup_t::unite_teams(int teamId1, int teamId2, int newTeamId)
         return StatusType::FAILURE;
     }
 
+    // the larger team becomes the united one, only the smaller team's tree nodes and set are moved
+    Team *large = team1;
+    Team *small = team2;
+    if (team2->getPlayerCount() > team1->getPlayerCount())
+    {
+        large = team2;
+        small = team1;
+    }
+    Node<Team> *largeNode = playableTeams.find(large->getIdPtr());
+    Node<Team> *smallNode = playableTeams.find(small->getIdPtr());
+    bool legal = large->isLegalWith(*small);
+    Node<Team> *newTeamNode = nullptr;
+
+    // everything is allocated before the world changes, so running out of memory leaves it as it was
     try
     {
-        newTeam = new Team(newTeamId, team1->getPoints() + team2->getPoints());
+        if (legal && largeNode == nullptr)
+        {
+            newTeamNode = allocator->create<Node<Team>>(large);
+        }
+        if (legal)
+        {
+            playableTeams.reserve();
+        }
+        teams.reserve();
     }
     catch (const std::bad_alloc &e)
     {
+        allocator->destroy(newTeamNode);
         return StatusType::ALLOCATION_ERROR;
     }
 
-    StatusType tatakae1 = mergePlayers(team1, team2, newTeam);
-    StatusType tatakae2 = mergePlayersSorted(team1, team2, newTeam);
-    if(tatakae1 == StatusType::ALLOCATION_ERROR || tatakae2 == StatusType::ALLOCATION_ERROR )
-    {
-        delete newTeam;
-        return StatusType::ALLOCATION_ERROR;
-    }
+    knockoutVersion++;
+    // the smaller team's set goes under the larger one's with its games offset, no player is touched
+    UnionFind::unite(large->getTeamSet(), small->getTeamSet());
+    AVLTree<Player, Node<Player>> *newPlayersSorted = large->getPlayersSorted();
+    newPlayersSorted->merge(*small->getPlayersSorted());
+    Node<Player> *topNode = newPlayersSorted->findMax();
+    if (topNode == nullptr)
+        large->setTopScorer(nullptr);
+    else
+        large->setTopScorer(topNode->value);
+
+    large->updatePoints(small->getPoints());
+    large->updateMatchScore(small->getMatchScore() - small->getPoints());
+    large->updatePlayerCount(small->getPlayerCount());
+    large->updateGoalKeeperCount(small->getGoalKeeperCount());
 
     teams.remove(&teamId1);
     teams.remove(&teamId2);
-    teams.insert(newTeam->getIdPtr(), newTeam);
-
-    Node<Team> *team1Node = playableTeams.find(&teamId1);
-    Node<Team> *team2Node = playableTeams.find(&teamId2);
-    if (team1Node != nullptr)
+    if (smallNode != nullptr)
     {
-        playableTeams.remove(&teamId1);
-        listRemove(team1Node);
+        playableTeams.remove(small->getIdPtr());
+        listRemove(smallNode);
     }
-    if (team2Node != nullptr)
+    if (largeNode != nullptr)
     {
-        playableTeams.remove(&teamId2);
-        listRemove(team2Node);
+        playableTeams.remove(large->getIdPtr());
+        listRemove(largeNode);
+        newTeamNode = largeNode;
     }
 
-    if (newTeam->isLegal())
+    large->setId(newTeamId);
+    teams.insert(large->getIdPtr(), large);
+    teamsCount--;
+    if (newTeamNode != nullptr)
     {
-        Node<Team> *newTeamNode;
-        try
-        {
-            newTeamNode = new Node<Team>(newTeam);
-        }
-        catch (const std::bad_alloc &e)
-        {
-            delete newTeam;
-            return StatusType::ALLOCATION_ERROR;
-        }
-
-        playableTeams.insert(newTeam->getIdPtr(), newTeamNode);
+        playableTeams.insert(large->getIdPtr(), newTeamNode);
         listInsert(newTeamNode);
     }
 
-    delete team1;
-    delete team2;
-    delete team1Node;
-    delete team2Node;
+    allocator->destroy(small);
+    allocator->destroy(smallNode);
 
     return StatusType::SUCCESS;
 }
@@ -391,6 +461,7 @@ StatusType world_cup_t::unite_teams(int teamId1, int teamId2, int newTeamId)
 
 output_t<int> world_cup_t::get_top_scorer(int teamId)
 {
+    OpTimer timer(Operation::GET_TOP_SCORER);
     if (teamId > 0)
     {
         Team *team = teams.find(&teamId);
@@ -410,6 +481,7 @@ output_t<int> world_cup_t::get_top_scorer(int teamId)
 
 output_t<int> world_cup_t::get_all_players_count(int teamId)
 {
+    OpTimer timer(Operation::GET_ALL_PLAYERS_COUNT);
     if (teamId > 0)
     {
         Team *team = teams.find(&teamId);
@@ -427,61 +499,72 @@ output_t<int> world_cup_t::get_all_players_count(int teamId)
 
 StatusType world_cup_t::get_all_players(int teamId, int *const output)
 {
+    OpTimer timer(Operation::GET_ALL_PLAYERS);
 
     if ((teamId == 0) || (output == nullptr))
     {
         return StatusType::INVALID_INPUT;
     }
 
-    Node<Player>** playersArr;
-
-
+    // the ids are written straight to output, nothing is allocated
     if (teamId > 0)
     {
         Team *team = teams.find(&teamId);
         if (team == nullptr) return StatusType::FAILURE;
         if (team->getPlayerCount() == 0) return StatusType::FAILURE;
 
-        try
+        int *next = output;
+        team->getPlayersSorted()->forEach([&next](Node<Player> *playerNode)
         {
-            playersArr = new Node<Player>*[team->getPlayerCount()];
-        }
-        catch (const std::bad_alloc &e)
-        {
-            return StatusType::ALLOCATION_ERROR;
-        }
-        team->getPlayersSorted()->arrayInOrder(playersArr);
-        for (int i = 0; i < team->getPlayerCount(); ++i)
-        {
-            output[i] = playersArr[i]->value->getId();
-        }
+            *next++ = playerNode->value->getId();
+        });
     }
     else
     {
         if(playerCount == 0) return StatusType::FAILURE;
 
-        try
-        {
-            playersArr = new Node<Player>*[playerCount];
-        }
-        catch (const std::bad_alloc &e)
-        {
-            return StatusType::ALLOCATION_ERROR;
-        }
-        playersSorted.arrayInOrder(playersArr);
-        for (int i = 0; i < playerCount; ++i)
+        // the list of all players is linked in playersSorted order
+        int *next = output;
+        for (Node<Player> *playerNode = playersSorted.findMin(); playerNode != nullptr; playerNode = playerNode->next)
         {
-            output[i] = playersArr[i]->value->getId();
+            *next++ = playerNode->value->getId();
         }
     }
 
-    delete[] playersArr;
     return StatusType::SUCCESS;
+}
+
+output_t<int> world_cup_t::getPlayersPage(int afterPlayerId, int count, int *const output)
+{
+    OpTimer timer(Operation::GET_PLAYERS_PAGE);
+    if ((afterPlayerId < 0) || (count <= 0) || (output == nullptr))
+    {
+        return StatusType::INVALID_INPUT;
+    }
+
+    Node<Player> *playerNode;
+    if (afterPlayerId == 0)
+    {
+        playerNode = playersSorted.findMin();
+    }
+    else
+    {
+        Player *player = players.find(&afterPlayerId);
+        if (player == nullptr) return StatusType::FAILURE;
+        playerNode = playersSorted.find(player)->next;
+    }
 
+    int written = 0;
+    for (; playerNode != nullptr && written < count; playerNode = playerNode->next)
+    {
+        output[written++] = playerNode->value->getId();
+    }
+    return written;
 }
 
 output_t<int> world_cup_t::get_closest_player(int playerId, int teamId)
 {
+    OpTimer timer(Operation::GET_CLOSEST_PLAYER);
     if ((teamId <= 0) || (playerId <= 0))
     {
         return StatusType::INVALID_INPUT;
@@ -492,8 +575,8 @@ output_t<int> world_cup_t::get_closest_player(int playerId, int teamId)
     Team *team = teams.find(&teamId);
     if (team == nullptr) return StatusType::FAILURE;
 
-    Player *player = team->getPlayers()->find(&playerId);
-    if (player == nullptr) return StatusType::FAILURE;
+    Player *player = players.find(&playerId);
+    if ((player == nullptr) || (player->getTeam() != team)) return StatusType::FAILURE;
     Node<Player> *playerNode = team->getPlayersSorted()->find(player);
 
     Player *next;
@@ -548,59 +631,265 @@ output_t<int> world_cup_t::get_closest_player(int playerId, int teamId)
 
 output_t<int> world_cup_t::knockout_winner(int minTeamId, int maxTeamId)
 {
+    OpTimer timer(Operation::KNOCKOUT_WINNER);
     if ((minTeamId < 0) || (maxTeamId < 0) || (minTeamId > maxTeamId))
     {
         return StatusType::INVALID_INPUT;
     }
 
-    Node<Team> *minTeam = playableTeams.findEqOrGreater(&minTeamId);
-    Node<Team> *tempNode = minTeam;
+    // the playable teams in the range are the ranks [first, first + teamCount)
+    int first = playableTeams.countLess(&minTeamId);
+    int teamCount = playableTeams.countLess(&maxTeamId) - first;
+    if (playableTeams.find(&maxTeamId) != nullptr)
+        teamCount++;
+    if (teamCount == 0) return StatusType::FAILURE;
+
+    int level = 0;
+    while ((1 << level) < teamCount)
+        level++;
+    if (knockoutThreads > 1 && teamCount >= KNOCKOUT_PARALLEL_TEAMS)
+        return playKnockoutParallel(first, teamCount, level).first;
+    Node<Team> *next = nullptr;
+    return playKnockout(first, teamCount, level, next, true).first;
+}
+
+void world_cup_t::setKnockoutThreads(int threads)
+{
+    knockoutThreads = (threads > 1) ? threads : 1;
+}
 
-    int teamCount = 0;
-    while (tempNode != nullptr)
+
+StatusType world_cup_t::saveSnapshot(const char *path, uint64_t sequence)
+{
+    OpTimer timer(Operation::SAVE_SNAPSHOT);
+    if (path == nullptr)
     {
-        if (tempNode->value->getId() > maxTeamId) break;
-        teamCount++;
-        tempNode = tempNode->next;
+        return StatusType::INVALID_INPUT;
     }
 
-    if (teamCount == 0) return StatusType::FAILURE;
+    Team **teamsArr = nullptr;
+    Node<Player> **playersInOrder = nullptr;
+    Player **playersById = nullptr;
+    bool written;
 
-    Pair *tournament;
     try
     {
-        tournament = new Pair[teamCount];
+        teamsArr = allocator->allocateArray<Team *>(teamsCount);
+        playersInOrder = allocator->allocateArray<Node<Player> *>(playerCount);
+        playersById = allocator->allocateArray<Player *>(playerCount);
+
+        teams.arrayInOrder(teamsArr);
+        playersSorted.arrayInOrder(playersInOrder);
+        players.arrayInOrder(playersById);
+        written = SnapshotFile::write(path, sequence, teamsArr, teamsCount, playersInOrder, playersById, playerCount);
     }
     catch (const std::bad_alloc &e)
     {
+        allocator->deallocateArray(teamsArr, teamsCount);
+        allocator->deallocateArray(playersInOrder, playerCount);
+        allocator->deallocateArray(playersById, playerCount);
         return StatusType::ALLOCATION_ERROR;
     }
 
-    tempNode = minTeam;
-    Team *team;
-    for (int i = 0; i < teamCount; i++)
+    allocator->deallocateArray(teamsArr, teamsCount);
+    allocator->deallocateArray(playersInOrder, playerCount);
+    allocator->deallocateArray(playersById, playerCount);
+
+    if (!written) return StatusType::FAILURE;
+    return StatusType::SUCCESS;
+}
+
+world_cup_t *world_cup_t::loadSnapshot(const char *path, uint64_t *sequence, Allocator &allocator)
+{
+    OpTimer timer(Operation::LOAD_SNAPSHOT);
+    if (path == nullptr)
     {
-        team = tempNode->value;
-        tournament[i] = Pair(team->getId(), team->getMatchScore());
-        tempNode = tempNode->next;
+        return nullptr;
     }
 
-    for (int i = 1; i < teamCount; i *= 2)
+    SnapshotFile *snapshot;
+    try
+    {
+        snapshot = SnapshotFile::read(path);
+    }
+    catch (const std::bad_alloc &e)
+    {
+        return nullptr;
+    }
+    if (snapshot == nullptr) return nullptr;
+
+    int teamsAmount = snapshot->getTeamCount();
+    int playersAmount = snapshot->getPlayerCount();
+    const TeamRecord *teamRecords = snapshot->getTeams();
+    const PlayerRecord *playerRecords = snapshot->getPlayers();
+    const uint32_t *idOrder = snapshot->getIdOrder();
+
+    Team **teamsArr = nullptr;
+    Node<Player> **playersInOrder = nullptr;
+    Player **playersById = nullptr;
+    Node<Team> **playableArr = nullptr;
+    int *teamStart = nullptr;
+    int *teamFill = nullptr;
+    Node<Player> **teamPlayersInOrder = nullptr;
+    int teamsCreated = 0, playersCreated = 0, playableCreated = 0;
+    world_cup_t *world = nullptr;
+
+    try
     {
-        for (int j = 0; j < teamCount; j += (2 * i))
+        teamsArr = allocator.allocateArray<Team *>(teamsAmount);
+        playersInOrder = allocator.allocateArray<Node<Player> *>(playersAmount);
+        playersById = allocator.allocateArray<Player *>(playersAmount);
+        playableArr = allocator.allocateArray<Node<Team> *>(teamsAmount);
+        teamStart = allocator.allocateArray<int>(teamsAmount + 1);
+        teamFill = allocator.allocateArray<int>(teamsAmount);
+        teamPlayersInOrder = allocator.allocateArray<Node<Player> *>(playersAmount);
+
+        for (; teamsCreated < teamsAmount; teamsCreated++)
+        {
+            const TeamRecord &record = teamRecords[teamsCreated];
+            teamsArr[teamsCreated] = allocator.create<Team>(record.id, record.points, allocator);
+            teamsArr[teamsCreated]->updateTeamGamesPlayed(record.teamGamesPlayed);
+        }
+
+        // players come in playersSorted order, so the list is linked as they are created
+        for (; playersCreated < playersAmount; playersCreated++)
+        {
+            const PlayerRecord &record = playerRecords[playersCreated];
+            Team *team = teamsArr[record.team];
+            Player *player = allocator.create<Player>(record.id, record.goals, record.cards, record.gamesPlayed,
+                                                      record.isGoalKeeper != 0, team);
+            Node<Player> *playerNode;
+            try
+            {
+                playerNode = allocator.create<Node<Player>>(player);
+            }
+            catch (const std::bad_alloc &e)
+            {
+                allocator.destroy(player);
+                throw;
+            }
+            playerNode->next = nullptr;
+            playerNode->previous = nullptr;
+            if (playersCreated > 0)
+            {
+                playerNode->previous = playersInOrder[playersCreated - 1];
+                playersInOrder[playersCreated - 1]->next = playerNode;
+            }
+            playersInOrder[playersCreated] = playerNode;
+
+            team->updatePlayerCount(1);
+            if (record.isGoalKeeper)
+                team->updateGoalKeeperCount(1);
+            team->updateMatchScore(record.goals - record.cards);
+        }
+        for (int i = 0; i < playersAmount; ++i)
+        {
+            playersById[i] = playersInOrder[idOrder[i]]->value;
+        }
+
+        // bucket both orders by team (a stable counting sort keeps each bucket sorted)
+        teamStart[0] = 0;
+        for (int i = 0; i < teamsAmount; ++i)
+        {
+            teamStart[i + 1] = teamStart[i] + teamsArr[i]->getPlayerCount();
+            teamFill[i] = teamStart[i];
+        }
+        for (int i = 0; i < playersAmount; ++i)
         {
-            if ((j + i) < teamCount)
+            teamPlayersInOrder[teamFill[playerRecords[i].team]++] = playersInOrder[i];
+        }
+
+        for (int i = 0; i < teamsAmount; ++i)
+        {
+            Team *team = teamsArr[i];
+            int size = teamStart[i + 1] - teamStart[i];
+            team->setPlayersSorted(allocator.create<AVLTree<Player, Node<Player>>>(
+                    teamPlayersInOrder + teamStart[i], size,
+                    (Player *(Node<Player>::*)() const) &Node<Player>::getValue, allocator));
+            if (size > 0)
+                team->setTopScorer(teamPlayersInOrder[teamStart[i + 1] - 1]->value);
+
+            if (team->isLegal())
             {
-                simulateMatch(tournament[j], tournament[j + i]);
+                Node<Team> *teamNode = allocator.create<Node<Team>>(team);
+                teamNode->next = nullptr;
+                teamNode->previous = nullptr;
+                if (playableCreated > 0)
+                {
+                    teamNode->previous = playableArr[playableCreated - 1];
+                    playableArr[playableCreated - 1]->next = teamNode;
+                }
+                playableArr[playableCreated++] = teamNode;
             }
         }
+
+        world = new world_cup_t(playersById, playersInOrder, playersAmount,
+                                teamsArr, teamsAmount, playableArr, playableCreated, allocator);
+    }
+    catch (const std::bad_alloc &e)
+    {
+        // nothing owns the objects yet, the teams release their own trees
+        for (int i = 0; i < playableCreated; ++i)
+        {
+            allocator.destroy(playableArr[i]);
+        }
+        for (int i = 0; i < playersCreated; ++i)
+        {
+            allocator.destroy(playersInOrder[i]->value);
+            allocator.destroy(playersInOrder[i]);
+        }
+        for (int i = 0; i < teamsCreated; ++i)
+        {
+            allocator.destroy(teamsArr[i]);
+        }
+        world = nullptr;
     }
 
+    if (world != nullptr && sequence != nullptr)
+    {
+        *sequence = snapshot->getSequence();
+    }
+
+    allocator.deallocateArray(teamsArr, teamsAmount);
+    allocator.deallocateArray(playersInOrder, playersAmount);
+    allocator.deallocateArray(playersById, playersAmount);
+    allocator.deallocateArray(playableArr, teamsAmount);
+    allocator.deallocateArray(teamStart, teamsAmount + 1);
+    allocator.deallocateArray(teamFill, teamsAmount);
+    allocator.deallocateArray(teamPlayersInOrder, playersAmount);
+    delete snapshot;
+
+    return world;
+}
+
+Stats world_cup_t::getStats()
+{
+#ifdef WC_ENABLE_STATS
+    return stats();
+#else
+    return Stats();
+#endif
+}
 
-    Pair winner = tournament[0];
-    delete[] tournament;
+void world_cup_t::resetStats()
+{
+    WC_STAT(stats().reset());
+}
+
+void world_cup_t::setLatencySampling(int everyN)
+{
+    latencySampling().every = (everyN > 0) ? everyN : 0;
+    latencySampling().countdown = latencySampling().every;
+}
+
+void world_cup_t::dumpLatency(std::ostream &os)
+{
+    latency().print(os);
+}
 
-    return winner.first;
+void world_cup_t::resetLatency()
+{
+    latency().reset();
 }
 
 
@@ -616,7 +905,11 @@ void world_cup_t::listInsert(Node<Player> *playerNode)
 {
     Node<Player> *next = playersSorted.findNext(playerNode->value);
     Node<Player> *previous = playersSorted.findPrevious(playerNode->value);
+    listInsert(playerNode, previous, next);
+}
 
+void world_cup_t::listInsert(Node<Player> *playerNode, Node<Player> *previous, Node<Player> *next)
+{
     playerNode->next = next;
     playerNode->previous = previous;
     if (next != nullptr)
@@ -686,180 +979,130 @@ void world_cup_t::simulateMatch(Pair &team1, Pair &team2)
     team1.second += (team2.second + 3);
 }
 
-StatusType world_cup_t::mergePlayers(Team *team1, Team *team2, Team *newTeam)
+world_cup_t::KnockoutBlock &world_cup_t::knockoutSlot(int firstRank, int level)
 {
-    int team1Size = team1->getPlayerCount();
-    int team2Size = team2->getPlayerCount();
-    Player **team1Arr;
-    Player **team2Arr;
-    Player **newTeamArr;
-
-    try
-    {
-        team1Arr = new Player *[team1Size];
-    }
-    catch (const std::bad_alloc &e)
-    {
-        return StatusType::ALLOCATION_ERROR;
-    }
-    try
-    {
-        team2Arr = new Player *[team2Size];
-    }
-    catch (const std::bad_alloc &e)
-    {
-        delete[] team1Arr;
-        return StatusType::ALLOCATION_ERROR;
-    }
-    try
-    {
-        newTeamArr = new Player *[team1Size + team2Size];
-    }
-    catch (const std::bad_alloc &e)
-    {
-        delete[] team1Arr;
-        delete[] team2Arr;
-        return StatusType::ALLOCATION_ERROR;
-    }
-
-    team1->getPlayers()->arrayInOrder(team1Arr);
-    team2->getPlayers()->arrayInOrder(team2Arr);
-
-    newTeam->resetTeamGamesPlayed();
-    newTeam->updateGoalKeeperCount(team1->getGoalKeeperCount() + team2->getGoalKeeperCount());
-    newTeam->updatePlayerCount(team1->getPlayerCount() + team2->getPlayerCount());
+    return knockoutCache[((unsigned) firstRank * 2654435761u + (unsigned) level) % KNOCKOUT_CACHE_SIZE];
+}
 
-    Player *curPlayer;
-    for(int i = 0; i < team1Size; i++)
-    {
-        curPlayer = team1Arr[i];
-        curPlayer->updateStats(team1->getTeamGamesPlayed(),0,0);
-        curPlayer->setTeam(newTeam);
-        newTeam->updateMatchScore(curPlayer->getGoals() - curPlayer->getCards());
-    }
-    for(int i = 0; i < team2Size; i++)
+Pair world_cup_t::playKnockout(int firstRank, int count, int level, Node<Team> *&next, bool store)
+{
+    KnockoutBlock *block = nullptr;
+    if (level > KNOCKOUT_LEAF_LEVEL && count == (1 << level))
     {
-        curPlayer = team2Arr[i];
-        curPlayer->updateStats(team2->getTeamGamesPlayed(),0,0);
-        curPlayer->setTeam(newTeam);
-        newTeam->updateMatchScore(curPlayer->getGoals() - curPlayer->getCards());
+        block = &knockoutSlot(firstRank, level);
+        if (block->version == knockoutVersion && block->firstRank == firstRank && block->level == level)
+        {
+            next = nullptr;
+            return block->result;
+        }
     }
 
-    int o1 = 0, o2 = 0, oNew = 0;
-
-    while (true)
+    Pair result;
+    if (level <= KNOCKOUT_LEAF_LEVEL)
     {
-        if (o1 < team1Size && o2 < team2Size)
+        // the same rounds knockout_winner always played, on at most 32 teams. Ids and scores are
+        // kept apart and the winner is picked without a branch, the scores decide it at random.
+        int ids[1 << KNOCKOUT_LEAF_LEVEL];
+        int scores[1 << KNOCKOUT_LEAF_LEVEL];
+        if (next == nullptr)
+            next = playableTeams.select(firstRank);
+        for (int i = 0; i < count; i++)
         {
-            if (team1Arr[o1]->getId() < team2Arr[o2]->getId())
-            {
-                newTeamArr[oNew++] = team1Arr[o1++];
-            }
-            else
-            {
-                newTeamArr[oNew++] = team2Arr[o2++];
-            }
+            ids[i] = next->value->getId();
+            scores[i] = next->value->getMatchScore();
+            next = next->next;
         }
-        else if (o1 < team1Size)
+        for (int i = 1; i < count; i *= 2)
         {
-            newTeamArr[oNew++] = team1Arr[o1++];
-        }
-        else if (o2 < team2Size)
-        {
-            newTeamArr[oNew++] = team2Arr[o2++];
+            for (int j = 0; j + i < count; j += (2 * i))
+            {
+                ids[j] = (scores[j] <= scores[j + i]) ? ids[j + i] : ids[j];
+                scores[j] += scores[j + i] + 3;
+            }
         }
-        else break;
+        result = Pair(ids[0], scores[0]);
+    }
+    else
+    {
+        // the winners of the two halves meet in the last round, if there is a second half
+        int half = 1 << (level - 1);
+        if (count <= half)
+            return playKnockout(firstRank, count, level - 1, next, store);
+        result = playKnockout(firstRank, half, level - 1, next, store);
+        Pair second = playKnockout(firstRank + half, count - half, level - 1, next, store);
+        simulateMatch(result, second);
     }
 
-    newTeam->setPlayers(new AVLTree<int, Player>(newTeamArr, team1Size+team2Size,(int *(Player::*)() const) &Player::getIdPtr));
-
-    delete[] team1Arr;
-    delete[] team2Arr;
-    delete[] newTeamArr;
-
-
-    return StatusType::SUCCESS;
-
+    if (block != nullptr && store)
+    {
+        block->version = knockoutVersion;
+        block->firstRank = firstRank;
+        block->level = level;
+        block->result = result;
+    }
+    return result;
 }
 
-StatusType world_cup_t::mergePlayersSorted(Team *team1, Team *team2, Team *newTeam)
+Pair world_cup_t::playKnockoutParallel(int firstRank, int count, int level)
 {
-    int team1Size = team1->getPlayerCount();
-    int team2Size = team2->getPlayerCount();
-    Node<Player> **team1Arr;
-    Node<Player> **team2Arr;
-    Node<Player> **newTeamArr;
-
+    const int blockSize = 1 << KNOCKOUT_TASK_LEVEL;
+    int blocks = (count + blockSize - 1) / blockSize;
+    Pair *winners;
     try
     {
-        team1Arr = new Node<Player> *[team1Size];
+        winners = allocator->allocateArray<Pair>(blocks);
     }
     catch (const std::bad_alloc &e)
     {
-        return StatusType::ALLOCATION_ERROR;
+        Node<Team> *next = nullptr;
+        return playKnockout(firstRank, count, level, next, true);
     }
-    try
-    {
-        team2Arr = new Node<Player> *[team2Size];
-    }
-    catch (const std::bad_alloc &e)
+
+    // every thread takes the next block not taken yet, the cache is only read meanwhile
+    std::atomic<int> nextBlock(0);
+    auto playBlocks = [this, firstRank, count, blockSize, blocks, winners, &nextBlock]()
     {
-        delete[] team1Arr;
-        return StatusType::ALLOCATION_ERROR;
-    }
+        for (int block = nextBlock++; block < blocks; block = nextBlock++)
+        {
+            int first = block * blockSize;
+            Node<Team> *next = nullptr;
+            winners[block] = playKnockout(firstRank + first, std::min(blockSize, count - first),
+                                          KNOCKOUT_TASK_LEVEL, next, false);
+        }
+    };
+    std::vector<std::thread> threads;
     try
     {
-        newTeamArr = new Node<Player> *[team1Size + team2Size];
+        threads.reserve(knockoutThreads - 1);
+        for (int i = 1; i < knockoutThreads && i < blocks; ++i)
+            threads.emplace_back(playBlocks);
     }
-    catch (const std::bad_alloc &e)
+    catch (const std::exception &e)
     {
-        delete[] team1Arr;
-        delete[] team2Arr;
-        return StatusType::ALLOCATION_ERROR;
+        // fewer threads, this one plays whatever the others do not take
     }
+    playBlocks();
+    for (size_t i = 0; i < threads.size(); ++i)
+        threads[i].join();
 
-    team1->getPlayersSorted()->arrayInOrder(team1Arr);
-    team2->getPlayersSorted()->arrayInOrder(team2Arr);
-
-    int o1 = 0, o2 = 0, oNew = 0;
-
-    while (true)
+    for (int block = 0; block * blockSize + blockSize <= count; ++block)
     {
-        if (o1 < team1Size && o2 < team2Size)
-        {
-            if (*(team1Arr[o1]->value) < *(team2Arr[o2]->value))
-            {
-                newTeamArr[oNew++] = team1Arr[o1++];
-            }
-            else
-            {
-                newTeamArr[oNew++] = team2Arr[o2++];
-            }
-        }
-        else if (o1 < team1Size)
-        {
-            newTeamArr[oNew++] = team1Arr[o1++];
-        }
-        else if (o2 < team2Size)
+        KnockoutBlock &cached = knockoutSlot(firstRank + block * blockSize, KNOCKOUT_TASK_LEVEL);
+        cached.version = knockoutVersion;
+        cached.firstRank = firstRank + block * blockSize;
+        cached.level = KNOCKOUT_TASK_LEVEL;
+        cached.result = winners[block];
+    }
+    // the block winners meet in the rounds the serial bracket plays above the blocks
+    for (int i = 1; i < blocks; i *= 2)
+    {
+        for (int j = 0; j + i < blocks; j += (2 * i))
         {
-            newTeamArr[oNew++] = team2Arr[o2++];
+            simulateMatch(winners[j], winners[j + i]);
         }
-        else break;
     }
-
-
-    newTeam->setPlayersSorted(new AVLTree<Player, Node<Player>>(newTeamArr, team1Size+team2Size,(Player *(Node<Player>::*)() const) &Node<Player>::getValue));
-    Node<Player> *topNode = newTeam->getPlayersSorted()->findMax();
-    if (topNode == nullptr)
-        newTeam->setTopScorer(nullptr);
-    else
-        newTeam->setTopScorer(topNode->value);
-
-    delete[] team1Arr;
-    delete[] team2Arr;
-    delete[] newTeamArr;
-
-    return StatusType::SUCCESS;
-
+    Pair winner = winners[0];
+    allocator->deallocateArray(winners, blocks);
+    return winner;
 }
 
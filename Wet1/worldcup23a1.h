@@ -20,24 +20,62 @@
 #include "Team.h"
 #include "AVLTree.h"
 #include "NP_Util.h"
+#include "SnapshotFile.h"
+#include "Stats.h"
+#include "Latency.h"
+#include "Allocator.h"
+#include <cstdint>
 
 class world_cup_t {
 private:
+    SlabAllocator slabs; // of a world built without an allocator, first in so it is destroyed last
 	AVLTree<int, Player> players;
     AVLTree<Player, Node<Player>> playersSorted;
     AVLTree<int, Team> teams;
     AVLTree<int, Node<Team>> playableTeams;
     Player *topScorer;
     int playerCount;
+    int teamsCount;
+    Allocator *allocator; // of everything the world allocates, see Allocator.h
+
+    // The result of the bracket of 2^level playable teams from firstRank on, for knockout_winner.
+    // It depends only on those teams, so ranges that line up on the same block share it.
+    struct KnockoutBlock
+    {
+        uint64_t version;
+        int firstRank;
+        int level;
+        Pair result;
+    };
+    static const int KNOCKOUT_LEAF_LEVEL = 5;  // blocks up to 32 teams are played out directly
+    static const int KNOCKOUT_CACHE_SIZE = 256;
+    static const int KNOCKOUT_TASK_LEVEL = 14; // blocks a thread plays in a parallel knockout
+    static const int KNOCKOUT_PARALLEL_TEAMS = 1 << 16; // fewer teams are always played on one thread
+    KnockoutBlock knockoutCache[KNOCKOUT_CACHE_SIZE];
+    uint64_t knockoutVersion; // bumped by every change, older cache entries are stale
+    int knockoutThreads;
 
     static int abs(int a);
     void listInsert(Node<Player>* playerNode);
+    // links the node in between its new neighbours
+    static void listInsert(Node<Player>* playerNode, Node<Player>* previous, Node<Player>* next);
     static void listRemove(Node<Player>* playerNode);
     void listInsert(Node<Team>* teamNode);
     static void listRemove(Node<Team>* teamNode);
     static void simulateMatch(Pair &team1, Pair &team2);
-    static StatusType mergePlayers(Team* team1, Team* team2, Team* newTeam);
-    static StatusType mergePlayersSorted(Team* team1, Team* team2, Team* newTeam);
+    // Plays the bracket of count (at most 2^level) playable teams from firstRank on. next is the
+    // node at firstRank if known, nullptr otherwise, and is left after the last team played.
+    // Without store the cache is only read, so several threads can play blocks at once.
+    Pair playKnockout(int firstRank, int count, int level, Node<Team> *&next, bool store);
+    // the cache entry a block goes to
+    KnockoutBlock &knockoutSlot(int firstRank, int level);
+    // playKnockout with the blocks of 2^KNOCKOUT_TASK_LEVEL teams spread over knockoutThreads threads
+    Pair playKnockoutParallel(int firstRank, int count, int level);
+
+    // builds a world from sorted arrays (every tree in linear time), the objects in them come from allocator
+    world_cup_t(Player **playersById, Node<Player> **playersInOrder, int playersAmount,
+                Team **teamsById, int teamsAmount, Node<Team> **playableById, int playableAmount,
+                Allocator &allocator);
 
 
 
@@ -79,6 +117,83 @@ public:
 	output_t<int> knockout_winner(int minTeamId, int maxTeamId);
 	
 	// } </DO-NOT-MODIFY>
+
+    /**
+     * A world that takes all of its memory from the given allocator, which has to outlive it.
+     * @param allocator
+     */
+    explicit world_cup_t(Allocator &allocator);
+
+    /**
+     * Empties the world for another run. A world that owns its slabs forgets everything at once and
+     * keeps the slabs for the next run, one made with an allocator frees object by object.
+     */
+    void reset();
+
+    /**
+     * Lets knockout_winner play ranges of at least 2^16 teams on up to the given number of threads.
+     * The blocks of the bracket are played in parallel and met in the same order, so the winner is
+     * the same as on one thread. Smaller ranges always stay on the calling thread.
+     * @param threads - 1 (the default) or less plays every range on the calling thread
+     */
+    void setKnockoutThreads(int threads);
+
+    /**
+     * Writes the ids of up to count players, in the order of get_all_players(-1), that come after the
+     * given player. Paging with the last id of each page reads all players with O(log n + count) work
+     * per call and without a buffer for all of them.
+     * @param afterPlayerId - 0 starts from the first player
+     * @param count
+     * @param output - room for count ids
+     * @return the number of ids written, 0 after the last player; FAILURE if afterPlayerId is not a player
+     */
+    output_t<int> getPlayersPage(int afterPlayerId, int count, int *output);
+
+    /**
+     * Writes the whole world to a snapshot file.
+     * @param path
+     * @param sequence - the op log position the world reflects, returned again by loadSnapshot
+     * @return FAILURE if the file could not be written
+     */
+    StatusType saveSnapshot(const char *path, uint64_t sequence = 0);
+
+    /**
+     * Builds a world from a snapshot file in time linear in its size.
+     * @param path
+     * @param sequence - if given, receives the sequence the snapshot was saved with
+     * @param allocator - of everything the world allocates, has to outlive it
+     * @return nullptr if the file is missing, invalid or memory ran out
+     */
+    static world_cup_t *loadSnapshot(const char *path, uint64_t *sequence = nullptr,
+                                     Allocator &allocator = heapAllocator());
+
+    /**
+     * The hot path counters of the calling thread, shared by all its worlds.
+     * @return all zero unless built with WC_ENABLE_STATS
+     */
+    static Stats getStats();
+
+    /**
+     * Zeroes the counters of the calling thread, does nothing unless built with WC_ENABLE_STATS.
+     */
+    static void resetStats();
+
+    /**
+     * Times 1 in everyN calls of the public methods on the calling thread (see Latency.h).
+     * @param everyN - 0 turns timing off, 1 times every call
+     */
+    static void setLatencySampling(int everyN);
+
+    /**
+     * Writes the p50/p99/p999 latency of every operation timed on the calling thread.
+     * @param os
+     */
+    static void dumpLatency(std::ostream &os);
+
+    /**
+     * Clears the latency histograms of the calling thread.
+     */
+    static void resetLatency();
 };
 
 #endif // WORLDCUP23A1_H_
@@ -5,6 +5,7 @@
 #include <iostream> //-----------------------------------------------------------------------------------------
 #include <exception>
 #include "AVLTreeNode.h"
+#include "Allocator.h"
 
 
 template<class T, class S>
@@ -12,16 +13,18 @@ class AVLTree
 {
 private:
     AVLTreeNode<T, S> *root;
+    Allocator *allocator;
 
 
 public:
-    AVLTree();
+    explicit AVLTree(Allocator &allocator = heapAllocator());
+    AVLTree(S **valuesArr, int size, T* (S::*chooseKey)() const, Allocator &allocator = heapAllocator());
 
     ~AVLTree();
-    AVLTree &operator=(const AVLTree &other);
 
     //Explicitly telling the compiler to delete this methods
     AVLTree(const AVLTree &) = delete;
+    AVLTree &operator=(const AVLTree &) = delete;
 
 
     /**
@@ -46,6 +49,16 @@ public:
      */
     void remove(T *key);
 
+    /**
+     * Moves the node of a key whose ordering is about to change, without allocating:
+     * the node is unlinked, changeKey() is called and the same node is linked back.
+     * Throws an exception if the key does not exist. The changed key must not equal another key.
+     * @param key
+     * @param changeKey
+     */
+    template<class F>
+    void rekey(T *key, F changeKey);
+
     /**
      * Finds the node with index k in the sorted list of keys and returns the value stored in it.
      * @param k
@@ -53,11 +66,66 @@ public:
      */
     S *select(int k);
 
+    /*
+     * Walks the values in key order. next() follows the parent links, O(1) amortized, so walking
+     * from any rank to the end costs O(log n + values walked) and allocates nothing.
+     * Any change to the tree invalidates the cursor.
+     */
+    class Cursor
+    {
+    public:
+        /**
+         * @return true once the cursor went past the last value
+         */
+        bool done() const;
+
+        /**
+         * @return the value the cursor is at (Required that the cursor is not done)
+         */
+        S *get() const;
+
+        /**
+         * Moves to the value of the next key (Required that the cursor is not done)
+         */
+        void next();
+
+    private:
+        friend class AVLTree<T, S>;
+
+        AVLTreeNode<T, S> *node;
+
+        explicit Cursor(AVLTreeNode<T, S> *node);
+    };
+
+    /**
+     * A cursor at the node with index k in the sorted list of keys, O(log n).
+     * @param k
+     * @return a cursor that is already done if k is out of range
+     */
+    Cursor cursorAt(int k);
+
     /**
-     * Releases the values from the tree
+     * Puts the tree inorder to the array
+     * (Required that the given array is large enough)
+     * @param output
+     */
+    void arrayInOrder(S **output);
+
+    /**
+     * Releases the values from the tree (they must come from the tree's allocator)
      */
     void releaseValues();
 
+    /**
+     * Removes every node, the values are left alone
+     */
+    void clear();
+
+    /**
+     * Forgets every node without giving it back, for when the allocator is released as a whole
+     */
+    void abandon();
+
 
     //possible exceptions to be thrown
     class KeyExists : public std::exception {};
@@ -66,6 +134,10 @@ public:
 
 private:
 
+    //Nodes come from and go back to the tree's allocator
+    AVLTreeNode<T, S> *createNode(T *key, S *value);
+    void destroyNode(AVLTreeNode<T, S> *node);
+
     //Releases the nodes in the tree recursively using a postorder route
     void release(AVLTreeNode<T, S> *node);
 
@@ -103,28 +175,75 @@ private:
     void updateParent(AVLTreeNode<T, S> *node, AVLTreeNode<T, S> *toUpdate, SonType sonType);
 
     //Recursively find the node with index k
-    S *selectRecursive(int k, AVLTreeNode<T, S> *curNode);
+    AVLTreeNode<T, S> *selectRecursive(int k, AVLTreeNode<T, S> *curNode);
+
+    AVLTreeNode<T, S>* generateTree(S **valuesArr, int size, T* (S::*chooseKey)() const);
 
 };
 
 
 template<class T, class S>
-AVLTree<T, S>::AVLTree() : root(nullptr)
+AVLTree<T, S>::AVLTree(Allocator &allocator) : root(nullptr), allocator(&allocator)
 {}
 
 template<class T, class S>
-AVLTree<T, S>::~AVLTree()
+AVLTree<T, S>::AVLTree(S **valuesArr, int size, T *(S::*chooseKey)() const, Allocator &allocator) :
+        root(nullptr), allocator(&allocator)
 {
-    release(root);
+    root = generateTree(valuesArr, size, chooseKey);
+}
+
+template<class T, class S>
+AVLTreeNode<T, S> *AVLTree<T, S>::createNode(T *key, S *value)
+{
+    void *memory = allocator->allocate(sizeof(AVLTreeNode<T, S>));
+    return new(memory) AVLTreeNode<T, S>(key, value);
 }
 
 template<class T, class S>
-AVLTree<T, S> &AVLTree<T, S>::operator=(const AVLTree &other)
+void AVLTree<T, S>::destroyNode(AVLTreeNode<T, S> *node)
 {
-    if (this == &other)
-        return *this;
-    root = other.root;
-    return *this;
+    node->~AVLTreeNode();
+    allocator->deallocate(node, sizeof(AVLTreeNode<T, S>));
+}
+
+template<class T, class S>
+AVLTreeNode<T, S> *AVLTree<T, S>::generateTree(S **valuesArr, int size, T *(S::*chooseKey)() const)
+{
+    if (size <= 0)
+    {
+        return nullptr;
+    }
+
+    int mid = size/2;
+    S* value = valuesArr[mid];
+    AVLTreeNode<T,S> *curNode = createNode((value->*chooseKey)(), value);
+    try
+    {
+        curNode->left = generateTree(valuesArr, mid, chooseKey);
+        curNode->right = generateTree(valuesArr + mid+1, size-mid-1, chooseKey);
+    }
+    catch (const std::bad_alloc &e)
+    {
+        release(curNode);
+        throw;
+    }
+
+    if (curNode->left != nullptr)
+        curNode->left->parent = curNode;
+    if (curNode->right != nullptr)
+        curNode->right->parent = curNode;
+
+    curNode->updateHeight();
+    curNode->updateRank();
+
+    return curNode;
+}
+
+template<class T, class S>
+AVLTree<T, S>::~AVLTree()
+{
+    release(root);
 }
 
 template<class T, class S>
@@ -134,7 +253,7 @@ void AVLTree<T, S>::release(AVLTreeNode<T, S> *node)
 
     release(node->right);
     release(node->left);
-    delete node;
+    destroyNode(node);
 }
 
 template<class T, class S>
@@ -194,8 +313,9 @@ void AVLTree<T, S>::insert(T *key, S *value)
     {
         throw KeyExists();
     }
+    WC_STAT(uint64_t rotationsBefore = stats().rotations);
     AVLTreeNode<T, S> *newNode;
-    newNode = new AVLTreeNode<T, S>(key, value);
+    newNode = createNode(key, value);
 
     if (this->root == nullptr)
     {
@@ -207,6 +327,7 @@ void AVLTree<T, S>::insert(T *key, S *value)
     }
 
     balanceInsert(newNode);
+    WC_STAT(stats().insertRotations.add(stats().rotations - rotationsBefore));
 
 }
 
@@ -278,6 +399,7 @@ bool AVLTree<T, S>::balance(AVLTreeNode<T, S> *parent)
         {
             rotateLL(parent);
         }
+        WC_STAT(stats().rotations++);
 
         return true;
     }
@@ -291,6 +413,7 @@ bool AVLTree<T, S>::balance(AVLTreeNode<T, S> *parent)
         {
             rotateRR(parent);
         }
+        WC_STAT(stats().rotations++);
 
         return true;
     }
@@ -305,9 +428,40 @@ void AVLTree<T, S>::remove(T *key)
     {
         throw KeyDoesNotExist();
     }
+    WC_STAT(uint64_t rotationsBefore = stats().rotations);
     toDelete = removeBin(toDelete);
     balanceRemove(toDelete->parent);
-    delete toDelete;
+    destroyNode(toDelete);
+    WC_STAT(stats().removeRotations.add(stats().rotations - rotationsBefore));
+}
+
+template<class T, class S>
+template<class F>
+void AVLTree<T, S>::rekey(T *key, F changeKey)
+{
+    AVLTreeNode<T, S> *node = findNode(key, root);
+    if (node == nullptr)
+    {
+        throw KeyDoesNotExist();
+    }
+    node = removeBin(node);
+    balanceRemove(node->parent);
+
+    changeKey();
+    node->left = nullptr;
+    node->right = nullptr;
+    node->parent = nullptr;
+    node->height = 0;
+    node->nodesInSub = 1;
+    if (root == nullptr)
+    {
+        root = node;
+    }
+    else
+    {
+        insertBin(node, root);
+    }
+    balanceInsert(node);
 }
 
 template<class T, class S>
@@ -360,7 +514,9 @@ void AVLTree<T, S>::balanceRemove(AVLTreeNode<T, S> *curNode)
         previousHeight = curNode->height;
         curNode->updateHeight();
         curNode->updateRank();
-        balance(curNode);
+        // a rotation moves curNode down, the subtree's height is the one of its new root
+        if (balance(curNode))
+            curNode = curNode->parent;
         if (previousHeight == curNode->height) break;
         curNode = curNode->parent;
     }
@@ -501,6 +657,12 @@ void AVLTree<T, S>::updateParent(AVLTreeNode<T, S> *node, AVLTreeNode<T, S> *toU
     }
 }
 
+template<class T, class S>
+void AVLTree<T, S>::arrayInOrder(S **const output)
+{
+    arrayInOrderRecursive(output, root, 0);
+}
+
 template<class T, class S>
 int AVLTree<T, S>::arrayInOrderRecursive(S **const output, AVLTreeNode<T, S> *curNode, int offset)
 {
@@ -517,23 +679,37 @@ void AVLTree<T, S>::releaseValues()
     releaseValuesRecursive(root);
 }
 
+template<class T, class S>
+void AVLTree<T, S>::clear()
+{
+    release(root);
+    root = nullptr;
+}
+
+template<class T, class S>
+void AVLTree<T, S>::abandon()
+{
+    root = nullptr;
+}
+
 template<class T, class S>
 void AVLTree<T, S>::releaseValuesRecursive(AVLTreeNode<T, S> *curNode)
 {
     if (curNode == nullptr) return;
     releaseValuesRecursive(curNode->left);
-    delete curNode->value;
+    allocator->destroy(curNode->value);
     releaseValuesRecursive(curNode->right);
 }
 
 template<class T, class S>
 S *AVLTree<T, S>::select(int k)
 {
-    return selectRecursive(k, root);
+    AVLTreeNode<T, S> *node = selectRecursive(k, root);
+    return (node != nullptr) ? node->value : nullptr;
 }
 
 template<class T, class S>
-S *AVLTree<T, S>::selectRecursive(int k, AVLTreeNode<T, S> *curNode)
+AVLTreeNode<T, S> *AVLTree<T, S>::selectRecursive(int k, AVLTreeNode<T, S> *curNode)
 {
     if (curNode == nullptr)
         return nullptr;
@@ -550,7 +726,45 @@ S *AVLTree<T, S>::selectRecursive(int k, AVLTreeNode<T, S> *curNode)
     {
         return selectRecursive(k - weight - 1, curNode->right);
     }
-    return curNode->value;
+    return curNode;
+}
+
+template<class T, class S>
+typename AVLTree<T, S>::Cursor AVLTree<T, S>::cursorAt(int k)
+{
+    return Cursor(selectRecursive(k, root));
+}
+
+template<class T, class S>
+AVLTree<T, S>::Cursor::Cursor(AVLTreeNode<T, S> *node) : node(node)
+{}
+
+template<class T, class S>
+bool AVLTree<T, S>::Cursor::done() const
+{
+    return node == nullptr;
+}
+
+template<class T, class S>
+S *AVLTree<T, S>::Cursor::get() const
+{
+    return node->value;
+}
+
+template<class T, class S>
+void AVLTree<T, S>::Cursor::next()
+{
+    if (node->right != nullptr)
+    {
+        node = node->right;
+        while (node->left != nullptr)
+            node = node->left;
+        return;
+    }
+    // up to the first ancestor the node is on the left of
+    while (node->parent != nullptr && node == node->parent->right)
+        node = node->parent;
+    node = node->parent;
 }
 
 
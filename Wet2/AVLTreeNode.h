@@ -1,6 +1,8 @@
 #ifndef DATASTRUCTURES_AVL_TREE_NODE_H
 #define DATASTRUCTURES_AVL_TREE_NODE_H
 
+#include "Stats.h"
+
 template<class T, class S>
 class AVLTree;
 
@@ -48,7 +50,9 @@ private:
 template<class T, class S>
 AVLTreeNode<T, S>::AVLTreeNode(T *key, S *value) :
         key(key), value(value), left(nullptr), right(nullptr), parent(nullptr), height(0), nodesInSub(1)
-{}
+{
+    WC_STAT(stats().nodesAllocated++);
+}
 
 template<class T, class S>
 int AVLTreeNode<T, S>::balanceFactor()
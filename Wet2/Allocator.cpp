@@ -0,0 +1,221 @@
+#include "Allocator.h"
+
+void *HeapAllocator::allocate(size_t size)
+{
+    return ::operator new(size);
+}
+
+void HeapAllocator::deallocate(void *pointer, size_t /*size*/)
+{
+    ::operator delete(pointer);
+}
+
+Allocator &heapAllocator()
+{
+    static HeapAllocator heap;
+    return heap;
+}
+
+CountingAllocator::CountingAllocator(Allocator &backing) :
+        backing(backing), allocations(0), deallocations(0), failures(0), liveBytes(0), untilFailure(-1)
+{}
+
+void *CountingAllocator::allocate(size_t size)
+{
+    if (untilFailure == 0)
+    {
+        untilFailure = -1;
+        failures++;
+        throw std::bad_alloc();
+    }
+    if (untilFailure > 0)
+        untilFailure--;
+
+    void *pointer = backing.allocate(size);
+    allocations++;
+    liveBytes += size;
+    return pointer;
+}
+
+void CountingAllocator::deallocate(void *pointer, size_t size)
+{
+    backing.deallocate(pointer, size);
+    deallocations++;
+    liveBytes -= size;
+}
+
+void CountingAllocator::failAfter(long allowed)
+{
+    untilFailure = (allowed < 0) ? -1 : allowed;
+}
+
+uint64_t CountingAllocator::getAllocations() const
+{
+    return allocations;
+}
+
+uint64_t CountingAllocator::getDeallocations() const
+{
+    return deallocations;
+}
+
+uint64_t CountingAllocator::getFailures() const
+{
+    return failures;
+}
+
+uint64_t CountingAllocator::getLive() const
+{
+    return allocations - deallocations;
+}
+
+uint64_t CountingAllocator::getLiveBytes() const
+{
+    return liveBytes;
+}
+
+const size_t SlabAllocator::GRANULE;
+const size_t SlabAllocator::MAX_SLAB_OBJECT;
+const size_t SlabAllocator::FIRST_SLAB_BYTES;
+const size_t SlabAllocator::MAX_SLAB_BYTES;
+
+SlabAllocator::SlabAllocator(Allocator &backing) :
+        backing(backing), slabs(nullptr), idle(nullptr), large(nullptr), reservedBytes(0)
+{
+    resetClasses();
+}
+
+SlabAllocator::~SlabAllocator()
+{
+    release();
+}
+
+void SlabAllocator::resetClasses()
+{
+    for (int i = 0; i < CLASSES; ++i)
+    {
+        classes[i].freeList = nullptr;
+        classes[i].cursor = nullptr;
+        classes[i].end = nullptr;
+        classes[i].nextSlabBytes = FIRST_SLAB_BYTES;
+    }
+}
+
+SlabAllocator::Block *SlabAllocator::allocateBlock(Block *&list, size_t bytes)
+{
+    Block *block = static_cast<Block *>(backing.allocate(bytes));
+    block->previous = nullptr;
+    block->next = list;
+    block->bytes = bytes;
+    if (list != nullptr)
+        list->previous = block;
+    list = block;
+    reservedBytes += bytes;
+    return block;
+}
+
+void SlabAllocator::deallocateBlock(Block *&list, Block *block)
+{
+    if (block->previous != nullptr)
+        block->previous->next = block->next;
+    else
+        list = block->next;
+    if (block->next != nullptr)
+        block->next->previous = block->previous;
+    reservedBytes -= block->bytes;
+    backing.deallocate(block, block->bytes);
+}
+
+void SlabAllocator::releaseList(Block *&list)
+{
+    while (list != nullptr)
+    {
+        Block *next = list->next;
+        reservedBytes -= list->bytes;
+        backing.deallocate(list, list->bytes);
+        list = next;
+    }
+}
+
+SlabAllocator::Block *SlabAllocator::takeSlab(size_t bytes)
+{
+    if (idle == nullptr)
+        return allocateBlock(slabs, bytes);
+
+    Block *slab = idle;
+    idle = slab->next;
+    slab->previous = nullptr;
+    slab->next = slabs;
+    if (slabs != nullptr)
+        slabs->previous = slab;
+    slabs = slab;
+    return slab;
+}
+
+void *SlabAllocator::allocate(size_t size)
+{
+    if (size > MAX_SLAB_OBJECT)
+        return allocateBlock(large, sizeof(Block) + size) + 1;
+
+    size_t objectSize = (size > 0) ? (size + GRANULE - 1) / GRANULE * GRANULE : GRANULE;
+    SizeClass &sizeClass = classes[objectSize / GRANULE - 1];
+    if (sizeClass.freeList != nullptr)
+    {
+        FreeObject *object = sizeClass.freeList;
+        sizeClass.freeList = object->next;
+        return object;
+    }
+    if (sizeClass.end - sizeClass.cursor < (ptrdiff_t) objectSize)
+    {
+        // slabs double up to MAX_SLAB_BYTES, so a small world stays small
+        Block *slab = takeSlab(sizeClass.nextSlabBytes);
+        sizeClass.cursor = reinterpret_cast<char *>(slab + 1);
+        sizeClass.end = reinterpret_cast<char *>(slab) + slab->bytes;
+        if (sizeClass.nextSlabBytes < MAX_SLAB_BYTES)
+            sizeClass.nextSlabBytes *= 2;
+    }
+    void *object = sizeClass.cursor;
+    sizeClass.cursor += objectSize;
+    return object;
+}
+
+void SlabAllocator::deallocate(void *pointer, size_t size)
+{
+    if (pointer == nullptr)
+        return;
+    if (size > MAX_SLAB_OBJECT)
+    {
+        deallocateBlock(large, static_cast<Block *>(pointer) - 1);
+        return;
+    }
+    size_t objectSize = (size > 0) ? (size + GRANULE - 1) / GRANULE * GRANULE : GRANULE;
+    FreeObject *object = static_cast<FreeObject *>(pointer);
+    object->next = classes[objectSize / GRANULE - 1].freeList;
+    classes[objectSize / GRANULE - 1].freeList = object;
+}
+
+void SlabAllocator::release()
+{
+    releaseList(slabs);
+    releaseList(idle);
+    releaseList(large);
+    resetClasses();
+}
+
+void SlabAllocator::recycle()
+{
+    while (slabs != nullptr)
+    {
+        Block *next = slabs->next;
+        slabs->next = idle;
+        idle = slabs;
+        slabs = next;
+    }
+    releaseList(large);
+    resetClasses();
+}
+
+uint64_t SlabAllocator::getReservedBytes() const
+{
+    return reservedBytes;
+}
@@ -1,14 +1,16 @@
 #include "Hash.h"
+#include "SnapshotImage.h"
 
-Hash::Hash() : size(0), arrSize(STARTING_SIZE), players(new Node<Player>*[STARTING_SIZE])
+Hash::Hash(Allocator& allocator) :
+        size(0), arrSize(0), players(nullptr), image(nullptr), allocator(&allocator)
+{}
+
+Hash::~Hash()
 {
-    for (int i = 0; i < arrSize; ++i)
-    {
-        players[i] = nullptr;
-    }
+    clear();
 }
 
-Hash::~Hash()
+void Hash::clear()
 {
     Node<Player>* cur, *toDelete;
     for (int i = 0; i < arrSize; ++i)
@@ -18,14 +20,17 @@ Hash::~Hash()
             cur = players[i];
             while (cur != nullptr)
             {
-                delete cur->value;
+                allocator->destroy(cur->value);
                 toDelete = cur;
                 cur = cur->next;
-                delete toDelete;
+                allocator->destroy(toDelete);
             }
         }
     }
-    delete[] players;
+    allocator->deallocateArray(players, arrSize);
+    delete image;
+    abandon();
+    image = nullptr;
 }
 
 int Hash::h(int playerID) const
@@ -35,14 +40,23 @@ int Hash::h(int playerID) const
 
 Player *Hash::find(int playerID)
 {
-    Node<Player>* temp = players[h(playerID)];
+    // the table is made by the first insert
+    Node<Player>* temp = (arrSize > 0) ? players[h(playerID)] : nullptr;
+    WC_STAT(uint64_t chain = 0);
 
     while (temp != nullptr)
     {
+        WC_STAT(chain++);
         if (temp->value->getId() == playerID)
+        {
+            WC_STAT(stats().hashChain.add(chain));
             return temp->value;
+        }
         temp = temp->next;
     }
+    WC_STAT(stats().hashChain.add(chain));
+    if (image != nullptr)
+        return image->find(playerID);
     return nullptr;
 }
 
@@ -51,21 +65,26 @@ void Hash::insert(Player *player)
     if (find(player->getId()) != nullptr)
         throw KeyExists();
 
-    Node<Player>* playerNode =  new Node<Player>(player);
+    // grows first, so running out of memory half way leaves nothing behind
+    if (size + 1 >= arrSize)
+        increaseSize();
+
+    Node<Player>* playerNode = allocator->create<Node<Player>>(player);
     int id = player->getId();
 
     playerNode->next = players[h(id)];
     players[h(id)] = playerNode;
     size++;
-
-    if (size >= arrSize)
-        increaseSize();
 }
 
 void Hash::increaseSize()
 {
-    arrSize *= 2;
-    Node<Player>** newArr = new Node<Player>*[arrSize];
+    int oldSize = arrSize;
+    int newSize = STARTING_SIZE;
+    if (oldSize > 0)
+        newSize = oldSize * 2;
+    Node<Player>** newArr = allocator->allocateArray<Node<Player>*>(newSize);
+    arrSize = newSize;
     for (int i = 0; i < arrSize; ++i)
     {
         newArr[i] = nullptr;
@@ -73,7 +92,7 @@ void Hash::increaseSize()
 
     Node<Player> *currNode, *temp;
     Player* player;
-    for (int i = 0; i < arrSize/2; ++i)
+    for (int i = 0; i < oldSize; ++i)
     {
         currNode = players[i];
 
@@ -91,5 +110,39 @@ void Hash::increaseSize()
 
     Node<Player>** toDelete = players;
     players = newArr;
-    delete[] toDelete;
-}
\ No newline at end of file
+    allocator->deallocateArray(toDelete, oldSize);
+}
+void Hash::attachImage(SnapshotImage *snapshotImage)
+{
+    delete image;
+    image = snapshotImage;
+}
+
+void Hash::abandon()
+{
+    players = nullptr;
+    arrSize = 0;
+    size = 0;
+}
+
+int Hash::getSize() const
+{
+    if (image != nullptr)
+        return size + image->getPlayerCount();
+    return size;
+}
+
+int Hash::arrayOfPlayers(Player **output)
+{
+    int count = 0;
+    for (int i = 0; i < arrSize; ++i)
+    {
+        for (Node<Player>* cur = players[i]; cur != nullptr; cur = cur->next)
+        {
+            output[count++] = cur->value;
+        }
+    }
+    if (image != nullptr)
+        count += image->arrayOfPlayers(output + count);
+    return count;
+}
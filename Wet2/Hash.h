@@ -6,9 +6,11 @@
 #include "Player.h"
 #include "Team.h"
 #include "Node.h"
+#include "Allocator.h"
 
 class Player;
 class Team;
+class SnapshotImage;
 
 class Hash
 {
@@ -16,6 +18,8 @@ private:
     int size;
     int arrSize;
     Node<Player>** players;
+    SnapshotImage* image; // players of a loaded snapshot, materialized on first access
+    Allocator* allocator; // of the chain nodes and the table, the players are freed with it too
 
     const static int STARTING_SIZE = 16;
 
@@ -24,15 +28,50 @@ private:
     void increaseSize();
 
 public:
-    Hash();
+    explicit Hash(Allocator& allocator = heapAllocator());
 
     ~Hash();
     Hash(const Hash&) = delete;
     Hash& operator=(const Hash&) = delete;
 
+    /**
+     * Inserts a player, the table is left unchanged if memory runs out.
+     * @param player
+     */
     void insert(Player* player);
     Player* find (int playerID);
 
+    /**
+     * Takes ownership of a loaded snapshot image, its players are looked up after the table's own.
+     * @param snapshotImage
+     */
+    void attachImage(SnapshotImage* snapshotImage);
+
+    /**
+     * Frees every player, chain node and the table, and drops an attached image
+     */
+    void clear();
+
+    /**
+     * Forgets the table, its chain nodes and players without giving them back, for when the
+     * allocator is released as a whole. An attached image is still unmapped by the destructor.
+     */
+    void abandon();
+
+    /**
+     * Returns the number of players, including the ones of an attached image
+     * @return
+     */
+    int getSize() const;
+
+    /**
+     * Puts all the players to the array, an attached image's corrupt records left out
+     * (Required that the given array has room for getSize() players)
+     * @param output
+     * @return the number of players put in the array
+     */
+    int arrayOfPlayers(Player** output);
+
 
     class KeyExists : public std::exception {};
 
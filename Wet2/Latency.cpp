@@ -0,0 +1,172 @@
+#include "Latency.h"
+
+#include <cmath>
+#include <iomanip>
+
+namespace
+{
+    const char *OPERATION_NAMES[(int) Operation::COUNT] = {
+            "add_team",
+            "remove_team",
+            "add_player",
+            "play_match",
+            "num_played_games_for_player",
+            "add_player_cards",
+            "get_player_cards",
+            "get_team_points",
+            "get_ith_pointless_ability",
+            "get_partial_spirit",
+            "buy_team",
+            "saveSnapshot",
+            "loadSnapshot",
+            "reset"
+    };
+
+#if defined(__x86_64__) || defined(__i386__)
+    // spins for 10ms of steady_clock and counts the TSC ticks in between
+    double measureTicksPerNanosecond()
+    {
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        uint64_t beginTicks = readClock();
+        std::chrono::steady_clock::time_point end;
+        do
+        {
+            end = std::chrono::steady_clock::now();
+        } while (end - begin < std::chrono::milliseconds(10));
+        uint64_t endTicks = readClock();
+        double nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+        return (double) (endTicks - beginTicks) / nanoseconds;
+    }
+#endif
+}
+
+const char *operationName(Operation operation)
+{
+    return OPERATION_NAMES[(int) operation];
+}
+
+double ticksPerNanosecond()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    static const double ratio = measureTicksPerNanosecond();
+    return ratio;
+#else
+    return 1;
+#endif
+}
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+int LatencyHistogram::bucketOf(uint64_t value)
+{
+    if (value < LINEAR)
+        return (int) value;
+    int exponent = 63 - __builtin_clzll(value);
+    if (exponent > MAX_EXPONENT)
+    {
+        exponent = MAX_EXPONENT;
+        value = (uint64_t(2) << MAX_EXPONENT) - 1;
+    }
+    // the top 6 bits of the value, in [SUB_BUCKETS, 2 * SUB_BUCKETS)
+    int subBucket = (int) (value >> (exponent - 5));
+    return LINEAR + (exponent - 6) * SUB_BUCKETS + (subBucket - SUB_BUCKETS);
+}
+
+uint64_t LatencyHistogram::highestValueOf(int bucket)
+{
+    if (bucket < LINEAR)
+        return bucket;
+    int exponent = (bucket - LINEAR) / SUB_BUCKETS + 6;
+    uint64_t subBucket = SUB_BUCKETS + (bucket - LINEAR) % SUB_BUCKETS;
+    return ((subBucket + 1) << (exponent - 5)) - 1;
+}
+
+void LatencyHistogram::add(uint64_t value)
+{
+    buckets[bucketOf(value)]++;
+    count++;
+    if (value > max)
+        max = value;
+}
+
+void LatencyHistogram::reset()
+{
+    for (int i = 0; i < BUCKETS; ++i)
+    {
+        buckets[i] = 0;
+    }
+    count = 0;
+    max = 0;
+}
+
+uint64_t LatencyHistogram::getCount() const
+{
+    return count;
+}
+
+uint64_t LatencyHistogram::getMax() const
+{
+    return max;
+}
+
+uint64_t LatencyHistogram::percentile(double fraction) const
+{
+    if (count == 0)
+        return 0;
+    uint64_t rank = (uint64_t) std::ceil(fraction * count);
+    if (rank == 0)
+        rank = 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; ++i)
+    {
+        seen += buckets[i];
+        if (seen >= rank)
+            return (highestValueOf(i) < max) ? highestValueOf(i) : max;
+    }
+    return max;
+}
+
+void LatencyStats::record(Operation operation, uint64_t ticks)
+{
+    histograms[(int) operation].add(ticks);
+}
+
+void LatencyStats::reset()
+{
+    for (int i = 0; i < (int) Operation::COUNT; ++i)
+    {
+        histograms[i].reset();
+    }
+}
+
+const LatencyHistogram &LatencyStats::get(Operation operation) const
+{
+    return histograms[(int) operation];
+}
+
+void LatencyStats::print(std::ostream &os) const
+{
+    double ratio = ticksPerNanosecond();
+    std::ios::fmtflags flags = os.flags();
+    std::streamsize precision = os.precision();
+    os << std::left << std::setw(30) << "operation (ns)" << std::right << std::setw(12) << "samples"
+       << std::setw(12) << "p50" << std::setw(12) << "p99" << std::setw(12) << "p999" << std::setw(12) << "max"
+       << "\n";
+    for (int i = 0; i < (int) Operation::COUNT; ++i)
+    {
+        const LatencyHistogram &histogram = histograms[i];
+        if (histogram.getCount() == 0)
+            continue;
+        os << std::left << std::setw(30) << OPERATION_NAMES[i] << std::right << std::setw(12) << histogram.getCount()
+           << std::fixed << std::setprecision(0)
+           << std::setw(12) << histogram.percentile(0.5) / ratio
+           << std::setw(12) << histogram.percentile(0.99) / ratio
+           << std::setw(12) << histogram.percentile(0.999) / ratio
+           << std::setw(12) << histogram.getMax() / ratio << "\n";
+    }
+    os.flags(flags);
+    os.precision(precision);
+}
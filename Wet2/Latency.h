@@ -0,0 +1,154 @@
+#ifndef DATASTRUCTURESWET2_LATENCY_H
+#define DATASTRUCTURESWET2_LATENCY_H
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/*
+ * Per operation latency histograms. Every public world_cup_t method starts an OpTimer, which
+ * reads the clock for 1 in N calls (world_cup_t::setLatencySampling) and costs a thread local
+ * decrement otherwise, so it can stay on in production. Sampling is off until enabled.
+ *
+ * Samples are kept in clock ticks - the TSC where there is one, steady_clock nanoseconds
+ * elsewhere - and converted to nanoseconds when printed. Like Stats, everything is per thread.
+ */
+
+enum class Operation
+{
+    ADD_TEAM,
+    REMOVE_TEAM,
+    ADD_PLAYER,
+    PLAY_MATCH,
+    NUM_PLAYED_GAMES_FOR_PLAYER,
+    ADD_PLAYER_CARDS,
+    GET_PLAYER_CARDS,
+    GET_TEAM_POINTS,
+    GET_ITH_POINTLESS_ABILITY,
+    GET_PARTIAL_SPIRIT,
+    BUY_TEAM,
+    SAVE_SNAPSHOT,
+    LOAD_SNAPSHOT,
+    RESET,
+    COUNT
+};
+
+const char *operationName(Operation operation);
+
+inline uint64_t readClock()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// Clock ticks per nanosecond, measured once on first use (1 without a TSC)
+double ticksPerNanosecond();
+
+/*
+ * HDR style histogram: exact below LINEAR, then SUB_BUCKETS buckets per power of two, which keeps
+ * every recorded value within about 3% of the true one. Values above 2^(MAX_EXPONENT+1) are clamped.
+ */
+class LatencyHistogram
+{
+public:
+    static const int LINEAR = 64;
+    static const int SUB_BUCKETS = 32;
+    static const int MAX_EXPONENT = 40;
+    static const int BUCKETS = LINEAR + (MAX_EXPONENT - 5) * SUB_BUCKETS;
+
+    LatencyHistogram();
+
+    void add(uint64_t value);
+    void reset();
+
+    uint64_t getCount() const;
+    uint64_t getMax() const;
+
+    /**
+     * @param fraction - in [0, 1], e.g. 0.999
+     * @return the highest value equivalent to the sample at that fraction, 0 if empty
+     */
+    uint64_t percentile(double fraction) const;
+
+    static int bucketOf(uint64_t value);
+    static uint64_t highestValueOf(int bucket);
+
+private:
+    uint64_t buckets[BUCKETS];
+    uint64_t count;
+    uint64_t max;
+};
+
+class LatencyStats
+{
+public:
+    void record(Operation operation, uint64_t ticks);
+    void reset();
+
+    const LatencyHistogram &get(Operation operation) const;
+
+    // a row per operation that has samples: count and p50/p99/p999/max in nanoseconds
+    void print(std::ostream &os) const;
+
+private:
+    LatencyHistogram histograms[(int) Operation::COUNT];
+};
+
+// The histograms of the calling thread
+inline LatencyStats &latency()
+{
+    static thread_local LatencyStats current;
+    return current;
+}
+
+// Kept apart from the histograms so the hot path touches a constant initialized thread local
+struct LatencySampling
+{
+    int every;
+    int countdown;
+};
+
+inline LatencySampling &latencySampling()
+{
+    static thread_local LatencySampling current = {0, 0};
+    return current;
+}
+
+// Times the enclosing scope when the call is sampled
+class OpTimer
+{
+public:
+    explicit OpTimer(Operation operation) : operation(operation), sampled(false), start(0)
+    {
+        LatencySampling &sampling = latencySampling();
+        if (sampling.every != 0 && --sampling.countdown <= 0)
+        {
+            sampling.countdown = sampling.every;
+            sampled = true;
+            start = readClock();
+        }
+    }
+
+    ~OpTimer()
+    {
+        if (sampled)
+            latency().record(operation, readClock() - start);
+    }
+
+    OpTimer(const OpTimer &) = delete;
+    OpTimer &operator=(const OpTimer &) = delete;
+
+private:
+    Operation operation;
+    bool sampled;
+    uint64_t start;
+};
+
+#endif //DATASTRUCTURESWET2_LATENCY_H
@@ -1,6 +1,8 @@
 #ifndef DATASTRUCTURES_NODE_H
 #define DATASTRUCTURES_NODE_H
 
+#include "Stats.h"
+
 template <class T>
 class Node
 {
@@ -9,7 +11,10 @@ public:
     Node* next;
 
     Node() = default;
-    explicit Node(T* value) : value(value) {}
+    explicit Node(T* value) : value(value)
+    {
+        WC_STAT(stats().nodesAllocated++);
+    }
 
 };
 
@@ -0,0 +1,470 @@
+#ifndef DATASTRUCTURESWET2_PERSISTENT_AVL_TREE_H
+#define DATASTRUCTURESWET2_PERSISTENT_AVL_TREE_H
+
+#include <exception>
+#include <new>
+#include "Allocator.h"
+#include "Stats.h"
+
+/*
+ * Persistent AVL tree with ranks: nodes are never changed once linked, a mutation copies the
+ * nodes on the path from the root to the change (O(log n) of them) and shares everything else.
+ * Copying a tree (or fork()) shares the root, so it is O(1), and the copies are versions that
+ * change independently. Nodes are reference counted and go back to the allocator with their last
+ * version.
+ *
+ * Unlike AVLTree, keys and values are stored by value - a version must not see later changes
+ * through a pointer. K needs operator<. The reference counts are not atomic, a tree and all of its
+ * versions are used by one thread at a time, and they share the allocator of the tree they came from.
+ */
+template<class K, class V>
+class PersistentAVLTree
+{
+public:
+    explicit PersistentAVLTree(Allocator &allocator = heapAllocator());
+
+    /**
+     * A new version sharing every node with other, O(1).
+     * @param other
+     */
+    PersistentAVLTree(const PersistentAVLTree &other);
+    PersistentAVLTree &operator=(const PersistentAVLTree &other);
+    ~PersistentAVLTree();
+
+    /**
+     * @return a version sharing every node with this one, O(1)
+     */
+    PersistentAVLTree fork() const;
+
+    /**
+     * @param key
+     * @return the value of key, nullptr if there is none. Valid until this version changes.
+     */
+    const V *find(const K &key) const;
+
+    /**
+     * Inserts key with value. Throws KeyExists if the key is in the tree, and std::bad_alloc with
+     * the tree unchanged if memory runs out.
+     * @param key
+     * @param value
+     */
+    void insert(const K &key, const V &value);
+
+    /**
+     * Removes key. Throws KeyDoesNotExist if it is not in the tree, and std::bad_alloc with the
+     * tree unchanged if memory runs out.
+     * @param key
+     */
+    void remove(const K &key);
+
+    /**
+     * Replaces the value of key, copying only its path. Throws like remove.
+     * @param key
+     * @param value
+     */
+    void update(const K &key, const V &value);
+
+    /**
+     * @param k - 0 based
+     * @return the value of the k-th smallest key, nullptr if out of range
+     */
+    const V *select(int k) const;
+
+    int getSize() const;
+
+    /**
+     * Copies the values in key order to the array
+     * (Required that the given array has room for getSize() values)
+     * @param output
+     */
+    void arrayInOrder(V *output) const;
+
+    class KeyExists : public std::exception {};
+
+    class KeyDoesNotExist : public std::exception {};
+
+private:
+    struct Node
+    {
+        K key;
+        V value;
+        Node *left;
+        Node *right;
+        int height;
+        int size;
+        int refs; // trees and nodes pointing to this one
+
+        Node(const K &key, const V &value, Node *left, Node *right);
+    };
+
+    // The nodes one mutation made, to free its garbage or undo it. An AVL tree of 2^31 keys is at
+    // most 45 high and a mutation makes at most 3 nodes per level.
+    struct Path
+    {
+        static const int CAPACITY = 160;
+        Node *created[CAPACITY];
+        int count;
+
+        Path() : count(0)
+        {}
+    };
+
+    Node *root;
+    Allocator *allocator;
+
+    static int heightOf(const Node *node);
+    static int sizeOf(const Node *node);
+
+    static void acquire(Node *node);
+    void release(Node *node);
+
+    // a new node linking left and right, which may be new or shared nodes
+    Node *make(Path &path, const K &key, const V &value, Node *left, Node *right);
+    // make() with a single or double rotation when left and right differ by 2 in height
+    Node *balance(Path &path, const K &key, const V &value, Node *left, Node *right);
+
+    Node *insertRecursive(Path &path, Node *node, const K &key, const V &value);
+    Node *removeRecursive(Path &path, Node *node, const K &key);
+    Node *removeMin(Path &path, Node *node, Node *&min);
+    Node *updateRecursive(Path &path, Node *node, const K &key, const V &value);
+
+    // makes newRoot the root and frees the nodes of path that did not end up in it
+    void commit(Path &path, Node *newRoot);
+    // frees every node of path, the tree is left as it was
+    void undo(Path &path);
+
+    int arrayInOrderRecursive(V *output, const Node *node, int offset) const;
+};
+
+
+template<class K, class V>
+PersistentAVLTree<K, V>::Node::Node(const K &key, const V &value, Node *left, Node *right) :
+        key(key), value(value), left(left), right(right), refs(0)
+{
+    int leftHeight = heightOf(left);
+    int rightHeight = heightOf(right);
+    height = 1 + ((leftHeight > rightHeight) ? leftHeight : rightHeight);
+    size = 1 + sizeOf(left) + sizeOf(right);
+    WC_STAT(stats().nodesAllocated++);
+}
+
+template<class K, class V>
+PersistentAVLTree<K, V>::PersistentAVLTree(Allocator &allocator) : root(nullptr), allocator(&allocator)
+{}
+
+template<class K, class V>
+PersistentAVLTree<K, V>::PersistentAVLTree(const PersistentAVLTree &other) :
+        root(other.root), allocator(other.allocator)
+{
+    acquire(root);
+}
+
+template<class K, class V>
+PersistentAVLTree<K, V> &PersistentAVLTree<K, V>::operator=(const PersistentAVLTree &other)
+{
+    Node *newRoot = other.root;
+    acquire(newRoot);
+    release(root);
+    root = newRoot;
+    allocator = other.allocator;
+    return *this;
+}
+
+template<class K, class V>
+PersistentAVLTree<K, V>::~PersistentAVLTree()
+{
+    release(root);
+}
+
+template<class K, class V>
+PersistentAVLTree<K, V> PersistentAVLTree<K, V>::fork() const
+{
+    return PersistentAVLTree(*this);
+}
+
+template<class K, class V>
+int PersistentAVLTree<K, V>::heightOf(const Node *node)
+{
+    return (node != nullptr) ? node->height : 0;
+}
+
+template<class K, class V>
+int PersistentAVLTree<K, V>::sizeOf(const Node *node)
+{
+    return (node != nullptr) ? node->size : 0;
+}
+
+template<class K, class V>
+void PersistentAVLTree<K, V>::acquire(Node *node)
+{
+    if (node != nullptr)
+        node->refs++;
+}
+
+template<class K, class V>
+void PersistentAVLTree<K, V>::release(Node *node)
+{
+    if (node == nullptr || --node->refs > 0)
+        return;
+    release(node->left);
+    release(node->right);
+    allocator->destroy(node);
+}
+
+template<class K, class V>
+typename PersistentAVLTree<K, V>::Node *
+PersistentAVLTree<K, V>::make(Path &path, const K &key, const V &value, Node *left, Node *right)
+{
+    Node *node = allocator->create<Node>(key, value, left, right);
+    path.created[path.count++] = node;
+    acquire(left);
+    acquire(right);
+    return node;
+}
+
+template<class K, class V>
+typename PersistentAVLTree<K, V>::Node *
+PersistentAVLTree<K, V>::balance(Path &path, const K &key, const V &value, Node *left, Node *right)
+{
+    if (heightOf(left) > heightOf(right) + 1)
+    {
+        WC_STAT(stats().rotations++);
+        if (heightOf(left->left) >= heightOf(left->right))
+            return make(path, left->key, left->value, left->left, make(path, key, value, left->right, right));
+
+        Node *middle = left->right;
+        Node *newLeft = make(path, left->key, left->value, left->left, middle->left);
+        Node *newRight = make(path, key, value, middle->right, right);
+        return make(path, middle->key, middle->value, newLeft, newRight);
+    }
+    if (heightOf(right) > heightOf(left) + 1)
+    {
+        WC_STAT(stats().rotations++);
+        if (heightOf(right->right) >= heightOf(right->left))
+            return make(path, right->key, right->value, make(path, key, value, left, right->left), right->right);
+
+        Node *middle = right->left;
+        Node *newLeft = make(path, key, value, left, middle->left);
+        Node *newRight = make(path, right->key, right->value, middle->right, right->right);
+        return make(path, middle->key, middle->value, newLeft, newRight);
+    }
+    return make(path, key, value, left, right);
+}
+
+template<class K, class V>
+void PersistentAVLTree<K, V>::commit(Path &path, Node *newRoot)
+{
+    acquire(newRoot);
+    // nodes made on the way that nothing links to, e.g. the ones a rotation replaced. Collected
+    // first: freeing one can free other new nodes that only it linked to.
+    Node *garbage[Path::CAPACITY];
+    int garbageCount = 0;
+    for (int i = 0; i < path.count; ++i)
+    {
+        if (path.created[i]->refs == 0)
+            garbage[garbageCount++] = path.created[i];
+    }
+    for (int i = 0; i < garbageCount; ++i)
+    {
+        release(garbage[i]->left);
+        release(garbage[i]->right);
+        allocator->destroy(garbage[i]);
+    }
+    release(root);
+    root = newRoot;
+}
+
+template<class K, class V>
+void PersistentAVLTree<K, V>::undo(Path &path)
+{
+    for (int i = 0; i < path.count; ++i)
+    {
+        path.created[i]->refs = -1;
+    }
+    // only the links into the old tree are counted anywhere that stays
+    for (int i = 0; i < path.count; ++i)
+    {
+        Node *node = path.created[i];
+        if (node->left != nullptr && node->left->refs != -1)
+            node->left->refs--;
+        if (node->right != nullptr && node->right->refs != -1)
+            node->right->refs--;
+    }
+    for (int i = 0; i < path.count; ++i)
+    {
+        allocator->destroy(path.created[i]);
+    }
+    path.count = 0;
+}
+
+template<class K, class V>
+const V *PersistentAVLTree<K, V>::find(const K &key) const
+{
+    const Node *node = root;
+    while (node != nullptr)
+    {
+        if (key < node->key)
+            node = node->left;
+        else if (node->key < key)
+            node = node->right;
+        else
+            return &node->value;
+    }
+    return nullptr;
+}
+
+template<class K, class V>
+void PersistentAVLTree<K, V>::insert(const K &key, const V &value)
+{
+    if (find(key) != nullptr)
+        throw KeyExists();
+
+    Path path;
+    try
+    {
+        commit(path, insertRecursive(path, root, key, value));
+    }
+    catch (const std::bad_alloc &e)
+    {
+        undo(path);
+        throw;
+    }
+}
+
+template<class K, class V>
+typename PersistentAVLTree<K, V>::Node *
+PersistentAVLTree<K, V>::insertRecursive(Path &path, Node *node, const K &key, const V &value)
+{
+    if (node == nullptr)
+        return make(path, key, value, nullptr, nullptr);
+    if (key < node->key)
+        return balance(path, node->key, node->value, insertRecursive(path, node->left, key, value), node->right);
+    return balance(path, node->key, node->value, node->left, insertRecursive(path, node->right, key, value));
+}
+
+template<class K, class V>
+void PersistentAVLTree<K, V>::remove(const K &key)
+{
+    if (find(key) == nullptr)
+        throw KeyDoesNotExist();
+
+    Path path;
+    try
+    {
+        commit(path, removeRecursive(path, root, key));
+    }
+    catch (const std::bad_alloc &e)
+    {
+        undo(path);
+        throw;
+    }
+}
+
+template<class K, class V>
+typename PersistentAVLTree<K, V>::Node *
+PersistentAVLTree<K, V>::removeRecursive(Path &path, Node *node, const K &key)
+{
+    if (key < node->key)
+        return balance(path, node->key, node->value, removeRecursive(path, node->left, key), node->right);
+    if (node->key < key)
+        return balance(path, node->key, node->value, node->left, removeRecursive(path, node->right, key));
+
+    if (node->left == nullptr)
+        return node->right;
+    if (node->right == nullptr)
+        return node->left;
+    // the successor takes the place of the node
+    Node *min = nullptr;
+    Node *right = removeMin(path, node->right, min);
+    return balance(path, min->key, min->value, node->left, right);
+}
+
+template<class K, class V>
+typename PersistentAVLTree<K, V>::Node *
+PersistentAVLTree<K, V>::removeMin(Path &path, Node *node, Node *&min)
+{
+    if (node->left == nullptr)
+    {
+        min = node;
+        return node->right;
+    }
+    return balance(path, node->key, node->value, removeMin(path, node->left, min), node->right);
+}
+
+template<class K, class V>
+void PersistentAVLTree<K, V>::update(const K &key, const V &value)
+{
+    if (find(key) == nullptr)
+        throw KeyDoesNotExist();
+
+    Path path;
+    try
+    {
+        commit(path, updateRecursive(path, root, key, value));
+    }
+    catch (const std::bad_alloc &e)
+    {
+        undo(path);
+        throw;
+    }
+}
+
+template<class K, class V>
+typename PersistentAVLTree<K, V>::Node *
+PersistentAVLTree<K, V>::updateRecursive(Path &path, Node *node, const K &key, const V &value)
+{
+    if (key < node->key)
+        return make(path, node->key, node->value, updateRecursive(path, node->left, key, value), node->right);
+    if (node->key < key)
+        return make(path, node->key, node->value, node->left, updateRecursive(path, node->right, key, value));
+    return make(path, node->key, value, node->left, node->right);
+}
+
+template<class K, class V>
+const V *PersistentAVLTree<K, V>::select(int k) const
+{
+    if (k < 0 || k >= sizeOf(root))
+        return nullptr;
+    const Node *node = root;
+    while (true)
+    {
+        int leftSize = sizeOf(node->left);
+        if (k < leftSize)
+        {
+            node = node->left;
+        }
+        else if (k > leftSize)
+        {
+            k -= leftSize + 1;
+            node = node->right;
+        }
+        else
+        {
+            return &node->value;
+        }
+    }
+}
+
+template<class K, class V>
+int PersistentAVLTree<K, V>::getSize() const
+{
+    return sizeOf(root);
+}
+
+template<class K, class V>
+void PersistentAVLTree<K, V>::arrayInOrder(V *output) const
+{
+    arrayInOrderRecursive(output, root, 0);
+}
+
+template<class K, class V>
+int PersistentAVLTree<K, V>::arrayInOrderRecursive(V *output, const Node *node, int offset) const
+{
+    if (node == nullptr)
+        return offset;
+    offset = arrayInOrderRecursive(output, node->left, offset);
+    output[offset++] = node->value;
+    return arrayInOrderRecursive(output, node->right, offset);
+}
+
+#endif //DATASTRUCTURESWET2_PERSISTENT_AVL_TREE_H
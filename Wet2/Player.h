@@ -10,6 +10,7 @@ class Team;
 class Player
 {
     friend class UnionFind;
+    friend class SnapshotImage;
 public:
     Player(int id, int cards, int gamesPlayed ,int ability,  bool isGoalKeeper, const permutation_t &spirit, Team *team);
 
@@ -0,0 +1,437 @@
+#include "SnapshotImage.h"
+#include "SpiritPacking.h"
+
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    const char MAGIC[8] = {'W', 'C', '2', 'S', 'N', 'A', 'P', '\0'};
+
+    // permutation_t does not expose its values, so it is packed through its text form,
+    // printed into a fixed buffer so that writing an image allocates nothing per record
+    class SpiritText : public std::streambuf
+    {
+    public:
+        SpiritText() : out(this)
+        {}
+
+        uint8_t pack(const permutation_t &spirit)
+        {
+            setp(buffer, buffer + sizeof(buffer) - 1);
+            out.clear();
+            out << spirit;
+            *pptr() = '\0';
+            return packSpirit(buffer);
+        }
+
+    private:
+        char buffer[16];
+        std::ostream out;
+    };
+
+    permutation_t unpackPermutation(uint8_t packed)
+    {
+        int values[SPIRIT_SIZE];
+        if (!unpackSpirit(packed, values))
+            return permutation_t::invalid();
+        return permutation_t(values);
+    }
+
+    int teamIndexOf(Team **teamsById, int teamCount, int teamId)
+    {
+        int low = 0, high = teamCount - 1;
+        while (low <= high)
+        {
+            int mid = low + (high - low) / 2;
+            if (teamsById[mid]->getId() == teamId)
+                return mid;
+            if (teamsById[mid]->getId() < teamId)
+                low = mid + 1;
+            else
+                high = mid - 1;
+        }
+        return -1;
+    }
+
+    size_t reservedBytes(uint32_t playerCount)
+    {
+        return sizeof(Player) * (playerCount > 0 ? playerCount : 1);
+    }
+
+    uint64_t alignUp(uint64_t offset)
+    {
+        return (offset + 7) & ~(uint64_t) 7;
+    }
+
+    // Checks the records map reads right away: the teams and their ability order. The player
+    // records are only checked as they are looked up, so loading never touches their pages
+    bool validTeams(const SnapshotHeader *header, const TeamImage *teams, const uint32_t *abilityOrder)
+    {
+        uint32_t teamCount = header->teamCount;
+        std::vector<bool> ordered(teamCount, false);
+        for (uint32_t i = 0; i < teamCount; ++i)
+        {
+            // the ability order is a permutation of the teams, which are sorted by id
+            if (abilityOrder[i] >= teamCount || ordered[abilityOrder[i]])
+                return false;
+            ordered[abilityOrder[i]] = true;
+
+            const TeamImage &team = teams[i];
+            if (team.id <= 0 || (i > 0 && teams[i - 1].id >= team.id) || team.spirit >= SPIRIT_RANKS)
+                return false;
+            if (team.teamSet < -1 || (team.teamSet >= 0 && (uint32_t) team.teamSet >= header->playerSlots))
+                return false;
+        }
+        return true;
+    }
+}
+
+SnapshotImage::SnapshotImage(char *base, size_t length, Player *materialized, Allocator &allocator) :
+        base(base), length(length), header(reinterpret_cast<SnapshotHeader *>(base)),
+        teams(reinterpret_cast<TeamImage *>(base + header->teamsOffset)),
+        abilityOrder(reinterpret_cast<uint32_t *>(base + header->abilityOffset)),
+        players(reinterpret_cast<PlayerImage *>(base + header->playersOffset)),
+        materialized(materialized), materializedCount(0), allocator(&allocator)
+{}
+
+SnapshotImage::~SnapshotImage()
+{
+    for (int i = 0; i < materializedCount; ++i)
+    {
+        materialized[i].~Player();
+    }
+    allocator->deallocate(materialized, reservedBytes(header->playerCount));
+    munmap(base, length);
+}
+
+int SnapshotImage::slotOf(int playerID, uint32_t slots)
+{
+    // fibonacci hashing, the multiply-shift keeps the high bits
+    uint32_t hash = (uint32_t) playerID * 2654435769u;
+    return (int) (((uint64_t) hash * slots) >> 32);
+}
+
+bool SnapshotImage::write(const char *path, uint64_t sequence, Team **teamsById, Team **teamsByAbility,
+                          int teamCount, Player **players, int playerCount)
+{
+    uint32_t slots = 1;
+    while (slots < 2 * (uint32_t) playerCount)
+        slots *= 2;
+
+    SnapshotHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = SnapshotHeader::VERSION;
+    header.teamCount = teamCount;
+    header.sequence = sequence;
+    header.playerCount = playerCount;
+    header.playerSlots = slots;
+    header.teamsOffset = sizeof(SnapshotHeader);
+    header.abilityOffset = header.teamsOffset + teamCount * sizeof(TeamImage);
+    header.playersOffset = alignUp(header.abilityOffset + teamCount * sizeof(uint32_t));
+    header.imageSize = header.playersOffset + slots * sizeof(PlayerImage);
+
+    TeamImage *teamImages = new TeamImage[teamCount > 0 ? teamCount : 1];
+    uint32_t *abilityImage = nullptr;
+    PlayerImage *playerImages = nullptr;
+    try
+    {
+        abilityImage = new uint32_t[teamCount > 0 ? teamCount : 1];
+        playerImages = new PlayerImage[slots];
+    }
+    catch (const std::bad_alloc &e)
+    {
+        delete[] teamImages;
+        delete[] abilityImage;
+        throw;
+    }
+    std::memset(teamImages, 0, (teamCount > 0 ? teamCount : 1) * sizeof(TeamImage));
+    std::memset(playerImages, 0, slots * sizeof(PlayerImage));
+
+    SpiritText text;
+    // first pass places every id, so the second can resolve parents to slots
+    for (int i = 0; i < playerCount; ++i)
+    {
+        int slot = slotOf(players[i]->id, slots);
+        while (playerImages[slot].id != 0)
+            slot = (slot + 1) & (slots - 1);
+        playerImages[slot].id = players[i]->id;
+    }
+    for (int i = 0; i < playerCount; ++i)
+    {
+        Player *player = players[i];
+        int slot = slotOf(player->id, slots);
+        while (playerImages[slot].id != player->id)
+            slot = (slot + 1) & (slots - 1);
+
+        PlayerImage &record = playerImages[slot];
+        record.cards = player->cards;
+        record.gamesPlayed = player->gamesPlayed;
+        record.ability = player->ability;
+        record.isGoalKeeper = player->isGoalKeeper;
+        record.spirit = text.pack(player->spirit);
+        record.size = player->size;
+        record.team = -1;
+        record.parent = -1;
+        if (!player->isRoot)
+        {
+            int parentSlot = slotOf(player->parent->id, slots);
+            while (playerImages[parentSlot].id != player->parent->id)
+                parentSlot = (parentSlot + 1) & (slots - 1);
+            record.parent = parentSlot;
+        }
+        else if (player->team != nullptr)
+        {
+            record.team = teamIndexOf(teamsById, teamCount, player->team->getId());
+        }
+    }
+
+    for (int i = 0; i < teamCount; ++i)
+    {
+        Team *team = teamsById[i];
+        TeamImage &record = teamImages[i];
+        record.id = team->getId();
+        record.points = team->getPoints();
+        record.teamAbility = team->getTeamAbility();
+        record.hasGoalKeeper = team->isLegal();
+        record.spirit = text.pack(team->getTeamSpirit());
+        record.teamSet = -1;
+        if (team->getTeamSet() != nullptr)
+        {
+            int rootId = team->getTeamSet()->id;
+            int slot = slotOf(rootId, slots);
+            while (playerImages[slot].id != rootId)
+                slot = (slot + 1) & (slots - 1);
+            record.teamSet = slot;
+        }
+        abilityImage[i] = teamIndexOf(teamsById, teamCount, teamsByAbility[i]->getId());
+    }
+
+    std::string tempPath = std::string(path) + ".tmp";
+    FILE *file = std::fopen(tempPath.c_str(), "wb");
+    bool ok = (file != nullptr);
+    if (ok)
+    {
+        static const char padding[8] = {0};
+        uint64_t abilityEnd = header.abilityOffset + teamCount * sizeof(uint32_t);
+        ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+        ok = ok && std::fwrite(teamImages, sizeof(TeamImage), teamCount, file) == (size_t) teamCount;
+        ok = ok && std::fwrite(abilityImage, sizeof(uint32_t), teamCount, file) == (size_t) teamCount;
+        ok = ok && std::fwrite(padding, 1, header.playersOffset - abilityEnd, file) == header.playersOffset - abilityEnd;
+        ok = ok && std::fwrite(playerImages, sizeof(PlayerImage), slots, file) == slots;
+        ok = (std::fflush(file) == 0) && ok;
+        ok = ok && (fsync(fileno(file)) == 0);
+        ok = (std::fclose(file) == 0) && ok;
+        ok = ok && (std::rename(tempPath.c_str(), path) == 0);
+        if (!ok)
+            std::remove(tempPath.c_str());
+    }
+
+    delete[] teamImages;
+    delete[] abilityImage;
+    delete[] playerImages;
+    return ok;
+}
+
+SnapshotImage *SnapshotImage::map(const char *path, Allocator &allocator)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return nullptr;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof(SnapshotHeader))
+    {
+        close(fd);
+        return nullptr;
+    }
+    size_t length = info.st_size;
+
+    // private mapping - fixups are written to copy on write pages and never reach the file
+    void *mapped = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+        return nullptr;
+
+    const SnapshotHeader *header = static_cast<const SnapshotHeader *>(mapped);
+    uint32_t slots = header->playerSlots;
+    bool valid = std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0 &&
+                 header->version == SnapshotHeader::VERSION &&
+                 header->imageSize == length &&
+                 slots != 0 && (slots & (slots - 1)) == 0 && header->playerCount < slots &&
+                 header->teamsOffset == sizeof(SnapshotHeader) &&
+                 header->abilityOffset == header->teamsOffset + header->teamCount * sizeof(TeamImage) &&
+                 header->playersOffset >= header->abilityOffset + header->teamCount * sizeof(uint32_t) &&
+                 header->playersOffset % 8 == 0 && header->playersOffset <= length &&
+                 header->playersOffset + slots * sizeof(PlayerImage) == length;
+
+    void *reserved = nullptr;
+    try
+    {
+        char *base = static_cast<char *>(mapped);
+        valid = valid && validTeams(header, reinterpret_cast<const TeamImage *>(base + header->teamsOffset),
+                                    reinterpret_cast<const uint32_t *>(base + header->abilityOffset));
+        if (!valid)
+        {
+            munmap(mapped, length);
+            return nullptr;
+        }
+        reserved = allocator.allocate(reservedBytes(header->playerCount));
+        return new SnapshotImage(base, length, static_cast<Player *>(reserved), allocator);
+    }
+    catch (const std::bad_alloc &e)
+    {
+        if (reserved != nullptr)
+            allocator.deallocate(reserved, reservedBytes(header->playerCount));
+        munmap(mapped, length);
+        throw;
+    }
+}
+
+uint64_t SnapshotImage::getSequence() const
+{
+    return header->sequence;
+}
+
+int SnapshotImage::getTeamCount() const
+{
+    return (int) header->teamCount;
+}
+
+int SnapshotImage::getPlayerCount() const
+{
+    return (int) header->playerCount;
+}
+
+const uint32_t *SnapshotImage::getAbilityOrder() const
+{
+    return abilityOrder;
+}
+
+Team *SnapshotImage::createTeam(int index, Allocator &allocator) const
+{
+    const TeamImage &record = teams[index];
+    Team *team = allocator.create<Team>(record.id);
+    team->updatePoints(record.points);
+    team->updateAbility(record.teamAbility);
+    team->updateHasGoalKeeper(record.hasGoalKeeper != 0);
+    team->updateTeamSpirit(unpackPermutation(record.spirit));
+    return team;
+}
+
+bool SnapshotImage::attachTeamSet(Team *team, int index)
+{
+    int32_t slot = teams[index].teamSet;
+    if (slot < 0)
+        return true;
+    if (players[slot].parent != -1)
+        return false;
+    Player *root = materialize(slot);
+    if (root == nullptr)
+        return false;
+    root->setTeam(team);
+    team->setTeamSet(root);
+    return true;
+}
+
+int SnapshotImage::findSlot(int playerID) const
+{
+    uint32_t slots = header->playerSlots;
+    int slot = slotOf(playerID, slots);
+    // a valid table always has an empty slot, a corrupt one is not probed around more than once
+    for (uint32_t probes = 0; probes < slots && players[slot].id != 0; ++probes)
+    {
+        if (players[slot].id == playerID)
+            return slot;
+        slot = (slot + 1) & (slots - 1);
+    }
+    return -1;
+}
+
+Player *SnapshotImage::find(int playerID)
+{
+    if (playerID <= 0)
+        return nullptr;
+    int slot = findSlot(playerID);
+    if (slot < 0)
+        return nullptr;
+    return materialize(slot);
+}
+
+bool SnapshotImage::isMaterialized(uint64_t fixup) const
+{
+    uintptr_t offset = (uintptr_t) fixup - reinterpret_cast<uintptr_t>(materialized);
+    return offset < (uintptr_t) materializedCount * sizeof(Player) && offset % sizeof(Player) == 0;
+}
+
+Player *SnapshotImage::materialize(int slot)
+{
+    // checks the records up to the first one already materialized (or the root) before creating any,
+    // every record gets one of the playerCount reserved places, so a chain needing more is corrupt
+    // (a cycle among them)
+    uint32_t slots = header->playerSlots;
+    int pending = 0;
+    for (int32_t cur = slot; cur >= 0; cur = players[cur].parent)
+    {
+        const PlayerImage &record = players[cur];
+        if (record.fixup != 0)
+        {
+            if (!isMaterialized(record.fixup))
+                return nullptr;
+            break;
+        }
+        if (record.id <= 0 || record.spirit >= SPIRIT_RANKS || record.parent < -1 ||
+            (record.parent >= 0 && (uint32_t) record.parent >= slots) ||
+            ++pending > (int) header->playerCount - materializedCount)
+            return nullptr;
+    }
+
+    // the records keep their values relative to the parent, so each is created on its own and
+    // linked to the one created after it
+    int32_t cur = slot;
+    Player *child = nullptr;
+    for (int i = 0; i < pending; ++i)
+    {
+        PlayerImage &record = players[cur];
+        Player *player = new(materialized + materializedCount) Player(record.id, record.cards, record.gamesPlayed,
+                                record.ability, record.isGoalKeeper != 0, unpackPermutation(record.spirit), nullptr);
+        player->size = record.size;
+        materializedCount++;
+        record.fixup = reinterpret_cast<uint64_t>(player);
+        if (child != nullptr)
+        {
+            child->isRoot = false;
+            child->parent = player;
+        }
+        child = player;
+        cur = record.parent;
+    }
+    if (child != nullptr && cur >= 0)
+    {
+        child->isRoot = false;
+        child->parent = reinterpret_cast<Player *>(players[cur].fixup);
+    }
+    return reinterpret_cast<Player *>(players[slot].fixup);
+}
+
+int SnapshotImage::arrayOfPlayers(Player **output)
+{
+    int count = 0;
+    for (uint32_t slot = 0; slot < header->playerSlots; ++slot)
+    {
+        if (players[slot].id == 0)
+            continue;
+        Player *player = materialize((int) slot);
+        if (player != nullptr)
+            output[count++] = player;
+    }
+    return count;
+}
@@ -0,0 +1,159 @@
+#ifndef DATASTRUCTURESWET2_SNAPSHOT_IMAGE_H
+#define DATASTRUCTURESWET2_SNAPSHOT_IMAGE_H
+
+#include <cstdint>
+#include <cstddef>
+#include "wet2util.h"
+#include "Player.h"
+#include "Team.h"
+#include "Allocator.h"
+
+class Player;
+class Team;
+
+/*
+ * Flat, pointer free image of a world, all references are indices:
+ *
+ *  header
+ *  TeamImage[teamCount]      - teams sorted by id (teamsById inorder)
+ *  uint32_t[teamCount]       - team indices in teamsByAbility order
+ *  PlayerImage[playerSlots]  - open addressing table by player id (id 0 - empty slot),
+ *                              union find parents are slot indices
+ *
+ * Loading maps the file privately (copy on write) and only creates the teams and the roots of
+ * their player sets. Every other player is turned into a Player object the first time it is
+ * looked up, by writing the object into the fixup field of its record, so only the pages
+ * that are actually touched are read and copied.
+ */
+
+struct SnapshotHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t teamCount;
+    uint64_t sequence;      // position in the op log this image reflects
+    uint32_t playerCount;
+    uint32_t playerSlots;   // power of two
+    uint64_t teamsOffset;
+    uint64_t abilityOffset;
+    uint64_t playersOffset;
+    uint64_t imageSize;
+
+    static const uint32_t VERSION = 1;
+};
+
+struct TeamImage
+{
+    int32_t id;
+    int32_t points;
+    int32_t teamAbility;
+    int32_t teamSet;        // slot of the root player, -1 if the team has no players
+    uint8_t hasGoalKeeper;
+    uint8_t spirit;         // packed team spirit
+    uint16_t reserved;
+};
+
+struct PlayerImage
+{
+    int32_t id;
+    int32_t cards;
+    int32_t gamesPlayed;    // relative to the parent, as kept by the union find
+    int32_t ability;
+    int32_t parent;         // slot of the parent, -1 for a root
+    int32_t team;           // index of the team of a root, -1 if none
+    int32_t size;           // size of the set, roots only
+    uint8_t isGoalKeeper;
+    uint8_t spirit;         // packed, relative to the parent
+    uint16_t reserved;
+    uint64_t fixup;         // 0 in the file, the Player object once the record is touched
+};
+
+
+class SnapshotImage
+{
+public:
+    /**
+     * Writes the image of a world to path (through a temporary file, replaced atomically).
+     * @param teamsById - the teams sorted by id
+     * @param teamsByAbility - the same teams in teamsByAbility order
+     * @param players - every player in the world
+     * @return false on a write error
+     */
+    static bool write(const char *path, uint64_t sequence, Team **teamsById, Team **teamsByAbility,
+                      int teamCount, Player **players, int playerCount);
+
+    /**
+     * Maps an image file and reserves room for all of its players, so that looking them up
+     * later never allocates. Only the header and the teams are read, in O(teams), a player record
+     * is checked when it is first looked up.
+     * @param path
+     * @param allocator - of the players, has to outlive the image
+     * @return nullptr if the file is missing or is not a valid image
+     */
+    static SnapshotImage *map(const char *path, Allocator &allocator = heapAllocator());
+
+    ~SnapshotImage();
+    SnapshotImage(const SnapshotImage &) = delete;
+    SnapshotImage &operator=(const SnapshotImage &) = delete;
+
+    uint64_t getSequence() const;
+    int getTeamCount() const;
+    int getPlayerCount() const;
+    const uint32_t *getAbilityOrder() const;
+
+    /**
+     * Creates the team stored at the given index (without its player set).
+     * @param index
+     * @param allocator - of the world the team is for
+     * @return
+     */
+    Team *createTeam(int index, Allocator &allocator) const;
+
+    /**
+     * Materializes the root of the team's player set and attaches it to the team.
+     * @param team - a team created from the same index
+     * @param index
+     * @return false if the team's set is not a valid root
+     */
+    bool attachTeamSet(Team *team, int index);
+
+    /**
+     * Finds a player of the image, turning it (and its union find ancestors) into Player objects on first access.
+     * @param playerID
+     * @return nullptr if the image has no such player, or its record or an ancestor's is corrupt
+     */
+    Player *find(int playerID);
+
+    /**
+     * Materializes every player of the image and puts them in the array, skipping corrupt records
+     * (Required that the given array has room for getPlayerCount() players)
+     * @param output
+     * @return the number of players put in the array
+     */
+    int arrayOfPlayers(Player **output);
+
+private:
+    char *base;
+    size_t length;
+    SnapshotHeader *header;
+    TeamImage *teams;
+    uint32_t *abilityOrder;
+    PlayerImage *players;
+
+    // room for a Player per record, reserved by map, the first materializedCount are created
+    Player *materialized;
+    int materializedCount;
+    Allocator *allocator;
+
+    SnapshotImage(char *base, size_t length, Player *materialized, Allocator &allocator);
+
+    // nullptr if the record or one of its ancestors is corrupt
+    Player *materialize(int slot);
+    bool isMaterialized(uint64_t fixup) const;
+    int findSlot(int playerID) const;
+
+    static int slotOf(int playerID, uint32_t slots);
+};
+
+
+#endif //DATASTRUCTURESWET2_SNAPSHOT_IMAGE_H
@@ -0,0 +1,80 @@
+#include "SpiritPacking.h"
+
+namespace
+{
+    int factorial(int n)
+    {
+        int res = 1;
+        for (int i = 2; i <= n; ++i)
+            res *= i;
+        return res;
+    }
+}
+
+uint8_t packSpirit(const int values[SPIRIT_SIZE])
+{
+    bool used[SPIRIT_SIZE] = {false, false, false, false, false};
+    int rank = 0;
+    for (int i = 0; i < SPIRIT_SIZE; ++i)
+    {
+        if (values[i] < 0 || values[i] >= SPIRIT_SIZE || used[values[i]])
+            return INVALID_SPIRIT_RANK;
+
+        int smallerUnused = 0;
+        for (int j = 0; j < values[i]; ++j)
+        {
+            if (!used[j])
+                smallerUnused++;
+        }
+        used[values[i]] = true;
+        rank += smallerUnused * factorial(SPIRIT_SIZE - 1 - i);
+    }
+    return (uint8_t) rank;
+}
+
+uint8_t packSpirit(const char *text)
+{
+    // same format as permutation_t::read - "2,1,3,5,4"
+    if (text == nullptr)
+        return INVALID_SPIRIT_RANK;
+
+    int values[SPIRIT_SIZE];
+    for (int i = 0; i < SPIRIT_SIZE; ++i)
+    {
+        if (i > 0 && text[2 * i - 1] != ',')
+            return INVALID_SPIRIT_RANK;
+        if (text[2 * i] < '1' || text[2 * i] > '9')
+            return INVALID_SPIRIT_RANK;
+        values[i] = text[2 * i] - '1';
+    }
+    if (text[2 * SPIRIT_SIZE - 1] != '\0')
+        return INVALID_SPIRIT_RANK;
+
+    return packSpirit(values);
+}
+
+bool unpackSpirit(uint8_t packed, int values[SPIRIT_SIZE])
+{
+    if (packed >= SPIRIT_RANKS)
+        return false;
+
+    bool used[SPIRIT_SIZE] = {false, false, false, false, false};
+    int rank = packed;
+    for (int i = 0; i < SPIRIT_SIZE; ++i)
+    {
+        int weight = factorial(SPIRIT_SIZE - 1 - i);
+        int skip = rank / weight;
+        rank %= weight;
+
+        int value = 0;
+        while (used[value] || skip > 0)
+        {
+            if (!used[value])
+                skip--;
+            value++;
+        }
+        used[value] = true;
+        values[i] = value;
+    }
+    return true;
+}
@@ -0,0 +1,34 @@
+#ifndef DATASTRUCTURESWET2_SPIRIT_PACKING_H
+#define DATASTRUCTURESWET2_SPIRIT_PACKING_H
+
+#include <cstdint>
+
+/*
+ * Spirit packing - a valid permutation of 1..5 is stored as its rank (0..119)
+ * in lexicographic order, INVALID_SPIRIT_RANK otherwise.
+ * Shared by the op log records and the snapshot image, so both read the same byte the same way.
+ */
+
+const int SPIRIT_SIZE = 5;
+const int SPIRIT_RANKS = 120;
+const uint8_t INVALID_SPIRIT_RANK = 0xFF;
+
+/**
+ * Packs zero based values (the permutation_t representation).
+ * @return INVALID_SPIRIT_RANK if the values are not a permutation
+ */
+uint8_t packSpirit(const int values[SPIRIT_SIZE]);
+
+/**
+ * Packs the text form of permutation_t, e.g. "2,1,3,5,4".
+ * @return INVALID_SPIRIT_RANK for anything else
+ */
+uint8_t packSpirit(const char *text);
+
+/**
+ * Unpacks a spirit into zero based values (the permutation_t representation).
+ * @return false for INVALID_SPIRIT_RANK or an out of range rank
+ */
+bool unpackSpirit(uint8_t packed, int values[SPIRIT_SIZE]);
+
+#endif //DATASTRUCTURESWET2_SPIRIT_PACKING_H
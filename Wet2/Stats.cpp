@@ -0,0 +1,79 @@
+#include "Stats.h"
+
+Histogram::Histogram()
+{
+    reset();
+}
+
+void Histogram::add(uint64_t value)
+{
+    buckets[(value < BUCKETS - 1) ? value : BUCKETS - 1]++;
+    count++;
+    sum += value;
+    if (value > max)
+        max = value;
+}
+
+void Histogram::reset()
+{
+    for (int i = 0; i < BUCKETS; ++i)
+    {
+        buckets[i] = 0;
+    }
+    count = 0;
+    sum = 0;
+    max = 0;
+}
+
+uint64_t Histogram::getCount() const
+{
+    return count;
+}
+
+uint64_t Histogram::getMax() const
+{
+    return max;
+}
+
+double Histogram::getMean() const
+{
+    return (count == 0) ? 0 : (double) sum / count;
+}
+
+uint64_t Histogram::getBucket(int i) const
+{
+    return buckets[i];
+}
+
+void Histogram::print(std::ostream &os, const char *name) const
+{
+    os << name << ": count " << count << ", mean " << getMean() << ", max " << max << " |";
+    for (int i = 0; i < BUCKETS; ++i)
+    {
+        if (buckets[i] != 0)
+            os << " " << i << ((i == BUCKETS - 1) ? "+:" : ":") << buckets[i];
+    }
+    os << "\n";
+}
+
+Stats::Stats() : rotations(0), nodesAllocated(0)
+{}
+
+void Stats::reset()
+{
+    insertRotations.reset();
+    removeRotations.reset();
+    rotations = 0;
+    hashChain.reset();
+    unionFindHops.reset();
+    nodesAllocated = 0;
+}
+
+void Stats::print(std::ostream &os) const
+{
+    insertRotations.print(os, "rotations per insert");
+    removeRotations.print(os, "rotations per remove");
+    hashChain.print(os, "hash chain per find");
+    unionFindHops.print(os, "union find hops");
+    os << "rotations: " << rotations << "\nnodes allocated: " << nodesAllocated << "\n";
+}
@@ -20,6 +20,11 @@ int* Team::getIdPtr()
     return &id;
 }
 
+Team *Team::getSelf()
+{
+    return this;
+}
+
 
 int Team::getPoints() const
 {
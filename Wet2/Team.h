@@ -24,6 +24,7 @@ public:
 
     int getId() const;
     int* getIdPtr();
+    Team* getSelf();
     int getPoints() const;
     int getTeamAbility() const;
     permutation_t& getTeamSpirit();
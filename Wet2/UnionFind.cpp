@@ -6,13 +6,16 @@ Player *UnionFind::find(Player *player)
     Player* cur = player;
     int sumGM = 0, toSubGM = 0;
     permutation_t sumSpirit = permutation_t::neutral(), toSubSpirit = permutation_t::neutral();
+    WC_STAT(uint64_t hops = 0);
     while(!(cur->isRoot))  //root finding
     {
+        WC_STAT(hops++);
         sumGM += cur->gamesPlayed;
         sumSpirit = cur->spirit * sumSpirit;
         cur = cur->parent;
     }
     Player* root = cur;
+    WC_STAT(stats().unionFindHops.add(hops));
     cur = player;
     while(!(cur->isRoot)) //path shortening
     {
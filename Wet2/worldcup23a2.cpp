@@ -1,15 +1,54 @@
 #include "worldcup23a2.h"
 
-world_cup_t::world_cup_t() : teamsById(), teamsByAbility(), players(), teamCount(0)
+world_cup_t::world_cup_t() : world_cup_t(slabs)
+{}
+
+world_cup_t::world_cup_t(Allocator &allocator) :
+        teamsById(allocator), teamsByAbility(allocator), players(allocator), teamCount(0), allocator(&allocator)
+{}
+
+world_cup_t::world_cup_t(Team **teamsByIdArr, Team **teamsByAbilityArr, int count, Allocator &allocator) :
+        teamsById(teamsByIdArr, count, (int *(Team::*)() const) &Team::getIdPtr, allocator),
+        teamsByAbility(teamsByAbilityArr, count, (Team *(Team::*)() const) &Team::getSelf, allocator),
+        players(allocator), teamCount(count), allocator(&allocator)
 {}
 
 world_cup_t::~world_cup_t()
 {
+    if (allocator == &slabs)
+    {
+        // everything the world made is in its slabs, they go back whole right after this
+        teamsById.abandon();
+        teamsByAbility.abandon();
+        players.abandon();
+        return;
+    }
 	teamsById.releaseValues();
 }
 
+void world_cup_t::reset()
+{
+    OpTimer timer(Operation::RESET);
+    if (allocator == &slabs)
+    {
+        teamsById.abandon();
+        teamsByAbility.abandon();
+        players.abandon();
+        slabs.recycle();
+    }
+    else
+    {
+        teamsById.releaseValues();
+        teamsById.clear();
+        teamsByAbility.clear();
+        players.clear();
+    }
+    teamCount = 0;
+}
+
 StatusType world_cup_t::add_team(int teamId)
 {
+    OpTimer timer(Operation::ADD_TEAM);
 	if (teamId <= 0)
         return StatusType::INVALID_INPUT;
 
@@ -20,7 +59,7 @@ StatusType world_cup_t::add_team(int teamId)
     Team *team;
     try
     {
-        team = new Team(teamId);
+        team = allocator->create<Team>(teamId);
     }
     catch (const std::bad_alloc &e)
     {
@@ -30,11 +69,20 @@ StatusType world_cup_t::add_team(int teamId)
     try
     {
         teamsById.insert(key, team);
+    }
+    catch (const std::bad_alloc &e)
+    {
+        allocator->destroy(team);
+        return StatusType::ALLOCATION_ERROR;
+    }
+    try
+    {
         teamsByAbility.insert(team, team);
     }
     catch (const std::bad_alloc &e)
     {
-        delete team;
+        teamsById.remove(key);
+        allocator->destroy(team);
         return StatusType::ALLOCATION_ERROR;
     }
 
@@ -45,6 +93,7 @@ StatusType world_cup_t::add_team(int teamId)
 
 StatusType world_cup_t::remove_team(int teamId)
 {
+    OpTimer timer(Operation::REMOVE_TEAM);
     if (teamId <= 0)
         return StatusType::INVALID_INPUT;
 
@@ -58,7 +107,7 @@ StatusType world_cup_t::remove_team(int teamId)
     if (team->getTeamSet() != nullptr)
         team->getTeamSet()->setTeam(nullptr);
 
-    delete team;
+    allocator->destroy(team);
 
     teamCount--;
 
@@ -69,6 +118,7 @@ StatusType world_cup_t::add_player(int playerId, int teamId,
                                    const permutation_t &spirit, int gamesPlayed,
                                    int ability, int cards, bool goalKeeper)
 {
+    OpTimer timer(Operation::ADD_PLAYER);
 	if ((playerId <= 0) || (teamId <= 0) || (!spirit.isvalid()) || (gamesPlayed < 0) || (cards < 0))
         return StatusType::INVALID_INPUT;
 
@@ -79,7 +129,7 @@ StatusType world_cup_t::add_player(int playerId, int teamId,
     Player *player;
     try
     {
-        player = new Player(playerId, cards, gamesPlayed, ability, goalKeeper, spirit, team);
+        player = allocator->create<Player>(playerId, cards, gamesPlayed, ability, goalKeeper, spirit, team);
     }
     catch (const std::bad_alloc &e)
     {
@@ -91,12 +141,11 @@ StatusType world_cup_t::add_player(int playerId, int teamId,
     }
     catch (const std::bad_alloc &e)
     {
-        delete player;
+        allocator->destroy(player);
         return StatusType::ALLOCATION_ERROR;
     }
 
-    if (updateTeamInAbilityTree(team, ability) == StatusType::ALLOCATION_ERROR)
-        return StatusType::ALLOCATION_ERROR;
+    updateTeamInAbilityTree(team, ability);
 
     if (team->getTeamSet() == nullptr)
         team->setTeamSet(player);
@@ -111,6 +160,7 @@ StatusType world_cup_t::add_player(int playerId, int teamId,
 
 output_t<int> world_cup_t::play_match(int teamId1, int teamId2)
 {
+    OpTimer timer(Operation::PLAY_MATCH);
 	if(teamId1 <= 0 || teamId2 <= 0 || teamId1 == teamId2)
         return StatusType::INVALID_INPUT;
 
@@ -156,6 +206,7 @@ output_t<int> world_cup_t::play_match(int teamId1, int teamId2)
 
 output_t<int> world_cup_t::num_played_games_for_player(int playerId)
 {
+    OpTimer timer(Operation::NUM_PLAYED_GAMES_FOR_PLAYER);
     if(playerId <= 0)
         return StatusType::INVALID_INPUT;
 
@@ -168,6 +219,7 @@ output_t<int> world_cup_t::num_played_games_for_player(int playerId)
 
 StatusType world_cup_t::add_player_cards(int playerId, int cards)
 {
+    OpTimer timer(Operation::ADD_PLAYER_CARDS);
 	if(playerId <= 0 || cards < 0)
         return StatusType::INVALID_INPUT;
 
@@ -184,6 +236,7 @@ StatusType world_cup_t::add_player_cards(int playerId, int cards)
 
 output_t<int> world_cup_t::get_player_cards(int playerId)
 {
+    OpTimer timer(Operation::GET_PLAYER_CARDS);
     if(playerId <= 0)
         return StatusType::INVALID_INPUT;
 
@@ -196,6 +249,7 @@ output_t<int> world_cup_t::get_player_cards(int playerId)
 
 output_t<int> world_cup_t::get_team_points(int teamId)
 {
+    OpTimer timer(Operation::GET_TEAM_POINTS);
 	if(teamId <= 0)
         return StatusType::INVALID_INPUT;
 
@@ -208,6 +262,7 @@ output_t<int> world_cup_t::get_team_points(int teamId)
 
 output_t<int> world_cup_t::get_ith_pointless_ability(int i)
 {
+    OpTimer timer(Operation::GET_ITH_POINTLESS_ABILITY);
     if(i < 0 || teamCount == 0 || i >= teamCount)
         return StatusType::FAILURE;
 
@@ -218,6 +273,7 @@ output_t<int> world_cup_t::get_ith_pointless_ability(int i)
 
 output_t<permutation_t> world_cup_t::get_partial_spirit(int playerId)
 {
+    OpTimer timer(Operation::GET_PARTIAL_SPIRIT);
     if(playerId <= 0)
         return StatusType::INVALID_INPUT;
 
@@ -233,6 +289,7 @@ output_t<permutation_t> world_cup_t::get_partial_spirit(int playerId)
 
 StatusType world_cup_t::buy_team(int teamId1, int teamId2)
 {
+    OpTimer timer(Operation::BUY_TEAM);
 	if(teamId1 <= 0 || teamId2 <= 0 || teamId1 == teamId2)
         return StatusType::INVALID_INPUT;
 
@@ -257,29 +314,152 @@ StatusType world_cup_t::buy_team(int teamId1, int teamId2)
 
     teamsById.remove(&teamId2);
     teamsByAbility.remove(boughtTeam);
-    if (updateTeamInAbilityTree(buyerTeam, boughtTeam->getTeamAbility()) == StatusType::ALLOCATION_ERROR)
-        return StatusType::ALLOCATION_ERROR;
+    updateTeamInAbilityTree(buyerTeam, boughtTeam->getTeamAbility());
 
     teamCount--;
-    delete boughtTeam;
+    allocator->destroy(boughtTeam);
 
 	return StatusType::SUCCESS;
 }
 
 
-//--------------------------------------- private methods ---------------------------------------------------//
-
-StatusType world_cup_t::updateTeamInAbilityTree(Team *team, int ability)
+StatusType world_cup_t::saveSnapshot(const char *path, uint64_t sequence)
 {
+    OpTimer timer(Operation::SAVE_SNAPSHOT);
+    Team **byId = nullptr;
+    Team **byAbility = nullptr;
+    Player **allPlayers = nullptr;
+    bool written;
     try
     {
-        teamsByAbility.remove(team);
-        team->updateAbility(ability);
-        teamsByAbility.insert(team, team);
+        byId = allocator->allocateArray<Team *>(teamCount);
+        byAbility = allocator->allocateArray<Team *>(teamCount);
+        allPlayers = allocator->allocateArray<Player *>(players.getSize());
+
+        teamsById.arrayInOrder(byId);
+        teamsByAbility.arrayInOrder(byAbility);
+        int playerCount = players.arrayOfPlayers(allPlayers);
+        written = SnapshotImage::write(path, sequence, byId, byAbility, teamCount, allPlayers, playerCount);
     }
     catch (const std::bad_alloc &e)
     {
+        allocator->deallocateArray(byId, teamCount);
+        allocator->deallocateArray(byAbility, teamCount);
+        allocator->deallocateArray(allPlayers, players.getSize());
         return StatusType::ALLOCATION_ERROR;
     }
-    return StatusType::SUCCESS;
+
+    allocator->deallocateArray(byId, teamCount);
+    allocator->deallocateArray(byAbility, teamCount);
+    allocator->deallocateArray(allPlayers, players.getSize());
+    return written ? StatusType::SUCCESS : StatusType::FAILURE;
+}
+
+world_cup_t *world_cup_t::loadSnapshot(const char *path, uint64_t *sequence, Allocator &allocator)
+{
+    OpTimer timer(Operation::LOAD_SNAPSHOT);
+    SnapshotImage *image;
+    try
+    {
+        image = SnapshotImage::map(path, allocator);
+    }
+    catch (const std::bad_alloc &e)
+    {
+        return nullptr;
+    }
+    if (image == nullptr)
+        return nullptr;
+
+    int count = image->getTeamCount();
+    Team **byId = nullptr;
+    Team **byAbility = nullptr;
+    world_cup_t *world = nullptr;
+    SnapshotImage *attached = image;
+    int created = 0;
+    try
+    {
+        byId = allocator.allocateArray<Team *>(count);
+        byAbility = allocator.allocateArray<Team *>(count);
+        for (; created < count; ++created)
+        {
+            byId[created] = image->createTeam(created, allocator);
+        }
+        for (int i = 0; i < count; ++i)
+        {
+            byAbility[i] = byId[image->getAbilityOrder()[i]];
+        }
+        world = new world_cup_t(byId, byAbility, count, allocator);
+
+        world->players.attachImage(image);
+        image = nullptr;
+        for (int i = 0; i < count; ++i)
+        {
+            if (!attached->attachTeamSet(byId[i], i))
+            {
+                // the world owns the teams and the image by now
+                delete world;
+                world = nullptr;
+                break;
+            }
+        }
+    }
+    catch (const std::bad_alloc &e)
+    {
+        if (world == nullptr)
+        {
+            for (int i = 0; i < created; ++i)
+            {
+                allocator.destroy(byId[i]);
+            }
+        }
+        delete world;
+        delete image;
+        allocator.deallocateArray(byId, count);
+        allocator.deallocateArray(byAbility, count);
+        return nullptr;
+    }
+
+    if (world != nullptr && sequence != nullptr)
+        *sequence = attached->getSequence();
+    allocator.deallocateArray(byId, count);
+    allocator.deallocateArray(byAbility, count);
+    return world;
+}
+
+Stats world_cup_t::getStats()
+{
+#ifdef WC_ENABLE_STATS
+    return stats();
+#else
+    return Stats();
+#endif
+}
+
+void world_cup_t::resetStats()
+{
+    WC_STAT(stats().reset());
+}
+
+void world_cup_t::setLatencySampling(int everyN)
+{
+    latencySampling().every = (everyN > 0) ? everyN : 0;
+    latencySampling().countdown = latencySampling().every;
+}
+
+void world_cup_t::dumpLatency(std::ostream &os)
+{
+    latency().print(os);
+}
+
+void world_cup_t::resetLatency()
+{
+    latency().reset();
+}
+
+
+//--------------------------------------- private methods ---------------------------------------------------//
+
+void world_cup_t::updateTeamInAbilityTree(Team *team, int ability)
+{
+    teamsByAbility.rekey(team, [team, ability]() { team->updateAbility(ability); });
 }
@@ -21,18 +21,29 @@
 #include "Team.h"
 #include "Hash.h"
 #include "UnionFind.h"
+#include "SnapshotImage.h"
+#include "Stats.h"
+#include "Latency.h"
+#include "Allocator.h"
 #include "exception"
 #include "wet2util.h"
+#include <cstdint>
 
 
 class world_cup_t {
 private:
+    SlabAllocator slabs; // of a world built without an allocator, first in so it is destroyed last
 	AVLTree<int, Team> teamsById;
     AVLTree<Team, Team> teamsByAbility;
     Hash players;
     int teamCount;
+    Allocator *allocator; // of everything the world allocates, see Allocator.h
 
-    StatusType updateTeamInAbilityTree(Team *team, int ability);
+    // Moves the team to its place for the new ability, never allocates
+    void updateTeamInAbilityTree(Team *team, int ability);
+
+    // Builds the team trees of a loaded snapshot from arrays sorted by id and by ability
+    world_cup_t(Team **teamsByIdArr, Team **teamsByAbilityArr, int count, Allocator &allocator);
 	
 public:
 	// <DO-NOT-MODIFY> {
@@ -65,6 +76,95 @@ public:
 	StatusType buy_team(int teamId1, int teamId2);
 	
 	// } </DO-NOT-MODIFY>
+
+    /**
+     * A world that takes all of its memory from the given allocator, which has to outlive it.
+     * @param allocator
+     */
+    explicit world_cup_t(Allocator &allocator);
+
+    /**
+     * Empties the world for another run. A world that owns its slabs forgets everything at once and
+     * keeps the slabs for the next run, one made with an allocator frees object by object.
+     */
+    void reset();
+
+    /**
+     * Calls visit(team) for the teams in ability order, from the i-th (counted like
+     * get_ith_pointless_ability) to the last or until visit returns false. Walks the ability tree
+     * in O(log n + teams visited) without allocating, where paging with get_ith_pointless_ability
+     * costs O(log n) per team.
+     * @param i
+     * @param visit - bool(const Team &), the team must not be changed during the walk
+     * @return INVALID_INPUT if i < 0, FAILURE if there is no i-th team
+     */
+    template<class F>
+    StatusType forEachTeamByAbility(int i, F visit);
+
+    /**
+     * Writes the whole world into a flat snapshot image file (see SnapshotImage.h).
+     * @param path
+     * @param sequence - position in the op log the snapshot reflects, returned on load
+     * @return FAILURE if the file could not be written
+     */
+    StatusType saveSnapshot(const char *path, uint64_t sequence = 0);
+
+    /**
+     * Maps a snapshot image file into a new world. Only the teams and the roots of their
+     * player sets are created up front, other players are created on first access, in room
+     * reserved at load so that lookups never allocate.
+     * @param path
+     * @param sequence - if not null, receives the sequence the snapshot was saved with
+     * @param allocator - of everything the world allocates, has to outlive it
+     * @return nullptr if the file is missing or invalid, or on an allocation failure. A corrupt
+     * player record is only found when it is looked up, the player is then treated as missing.
+     */
+    static world_cup_t *loadSnapshot(const char *path, uint64_t *sequence = nullptr,
+                                     Allocator &allocator = heapAllocator());
+
+    /**
+     * The hot path counters of the calling thread, shared by all its worlds.
+     * @return all zero unless built with WC_ENABLE_STATS
+     */
+    static Stats getStats();
+
+    /**
+     * Zeroes the counters of the calling thread, does nothing unless built with WC_ENABLE_STATS.
+     */
+    static void resetStats();
+
+    /**
+     * Times 1 in everyN calls of the public methods on the calling thread (see Latency.h).
+     * @param everyN - 0 turns timing off, 1 times every call
+     */
+    static void setLatencySampling(int everyN);
+
+    /**
+     * Writes the p50/p99/p999 latency of every operation timed on the calling thread.
+     * @param os
+     */
+    static void dumpLatency(std::ostream &os);
+
+    /**
+     * Clears the latency histograms of the calling thread.
+     */
+    static void resetLatency();
 };
 
+template<class F>
+StatusType world_cup_t::forEachTeamByAbility(int i, F visit)
+{
+    if (i < 0)
+        return StatusType::INVALID_INPUT;
+    AVLTree<Team, Team>::Cursor cursor = teamsByAbility.cursorAt(i);
+    if (cursor.done())
+        return StatusType::FAILURE;
+    for (; !cursor.done(); cursor.next())
+    {
+        if (!visit(static_cast<const Team &>(*cursor.get())))
+            break;
+    }
+    return StatusType::SUCCESS;
+}
+
 #endif // WORLDCUP23A1_H_